@@ -38,6 +38,11 @@ static char af80_charset_filename[FILENAME_MAX];
 static UBYTE *af80_screen = NULL;
 static UBYTE *af80_attrib = NULL;
 
+#define AF80_ROWS 25
+#define AF80_CELL_HEIGHT 10
+
+UBYTE AF80_scanline_dirty[AF80_SCRN_HEIGHT];
+
 int AF80_enabled = FALSE;
 
 /* Austin Franklin information from forum posts by warerat at Atariage */
@@ -231,22 +236,64 @@ int AF80_D6GetByte(UWORD addr, int no_side_effects)
 	return result;
 }
 
+static void InvalidateRow(int row)
+{
+	if (row < AF80_ROWS)
+		memset(AF80_scanline_dirty + row * AF80_CELL_HEIGHT, 1, AF80_CELL_HEIGHT);
+}
+
+/* Marks the rows that display character RAM position POS as changed.
+   Rows above crtreg[0x10] show the screen from the address in crtreg[0x0c-0x0d],
+   the remaining rows from the address in crtreg[0x0e-0x0f]. */
+static void InvalidateScreenPos(int pos)
+{
+	int split = crtreg[0x10];
+	int row = ((pos - crtreg[0x0c] - ((crtreg[0x0d]&0x3f)<<8)) & 0x7ff) / 80;
+	if (row < split)
+		InvalidateRow(row);
+	InvalidateRow(split + ((pos - crtreg[0x0e] - ((crtreg[0x0f]&0x3f)<<8)) & 0x7ff) / 80);
+}
+
 void AF80_D6PutByte(UWORD addr, UBYTE byte)
 {
 	if (!not_enable_2k_character_ram) {
+		int pos = (addr&0x7f) + (video_bank_select<<7);
 		MEMORY_dPutByte((addr&0xff7f),byte);
 		MEMORY_dPutByte((addr&0xff7f)+0x80,byte);
-		af80_screen[(addr&0x7f) + (video_bank_select<<7)] = byte;
+		if (af80_screen[pos] != byte) {
+			af80_screen[pos] = byte;
+			InvalidateScreenPos(pos);
+		}
 	}
 	else if (!not_enable_2k_attribute_ram) {
+		int pos = (addr&0x7f) + (video_bank_select<<7);
 		MEMORY_dPutByte((addr&0xff7f),byte);
 		MEMORY_dPutByte((addr&0xff7f)+0x80,byte);
-		af80_attrib[(addr&0x7f) + (video_bank_select<<7)] = byte;
+		if (af80_attrib[pos] != byte) {
+			af80_attrib[pos] = byte;
+			InvalidateScreenPos(pos);
+		}
 		D(printf("AF80 Write, attribute,  addr:%4x byte:%2x, cpu:%4x\n", addr, byte,CPU_remember_PC[(CPU_remember_PC_curpos-1)%CPU_REMEMBER_PC_STEPS]));
 	}
 	else if (!not_enable_crtc_registers) {
 		if (video_bank_select == 0 ) {
-			if ((addr&0xff)<0x40) {
+			if ((addr&0xff)<0x40 && crtreg[addr&0xff] != byte) {
+				switch (addr&0xff) {
+				case 0x0c: /* screen addresses */
+				case 0x0d:
+				case 0x0e:
+				case 0x0f:
+				case 0x10:
+					memset(AF80_scanline_dirty, 1, AF80_SCRN_HEIGHT);
+					break;
+				case 0x18: /* cursor row */
+					InvalidateRow(crtreg[0x18]);
+					InvalidateRow(byte);
+					break;
+				case 0x19: /* cursor column */
+					InvalidateRow(crtreg[0x18]);
+					break;
+				}
 				crtreg[addr&0xff] = byte;
 			}
 			D(if (1 || (addr!=0xd618 && addr!=0xd619)) printf("AF80 Write addr:%4x byte:%2x, cpu:%4x\n", addr, byte,CPU_remember_PC[(CPU_remember_PC_curpos-1)%CPU_REMEMBER_PC_STEPS]));
@@ -331,8 +378,6 @@ void AF80_D5PutByte(UWORD addr, UBYTE byte)
 
 UBYTE AF80_GetPixels(int scanline, int column, int *colour, int blink)
 {
-#define AF80_ROWS 25
-#define AF80_CELL_HEIGHT 10
 	UBYTE character;
 	int attrib;
 	UBYTE font_data;
@@ -383,6 +428,7 @@ void AF80_Reset(void)
 	not_enable_80_column_output = 0;
 	video_bank_select = 0;
 	memset(crtreg, 0, 0x40);
+	memset(AF80_scanline_dirty, 1, AF80_SCRN_HEIGHT);
 }
 
 /*
@@ -15,6 +15,14 @@ void AF80_D5PutByte(UWORD addr, UBYTE byte);
 int AF80_D6GetByte(UWORD addr, int no_side_effects);
 void AF80_D6PutByte(UWORD addr, UBYTE byte);
 UBYTE AF80_GetPixels(int scanline, int column, int *colour, int blink);
+
+#define AF80_SCRN_HEIGHT 250
+
+/* One entry for each line returned by AF80_GetPixels, set to 1 when the
+   line changes. Platform code that displays only the changed lines clears
+   the entries after displaying the screen. Changes of the blink phase are
+   not tracked. */
+extern UBYTE AF80_scanline_dirty[AF80_SCRN_HEIGHT];
 extern int AF80_enabled;
 void AF80_Reset(void);
 
@@ -29,6 +29,7 @@
 #include "gtia.h"
 #include "img_tape.h"
 #include "log.h"
+#include "sap.h"
 #include "sio.h"
 #include "statesav.h"
 #include "util.h"
@@ -118,6 +119,12 @@ int AFILE_DetectFileType(const char *filename)
 			return AFILE_CART;
 		}
 		break;
+	case 'S':
+		if (header[1] == 'A' && header[2] == 'P' && header[3] == '\r') {
+			fclose(fp);
+			return AFILE_SAP;
+		}
+		break;
 	case 0x96:
 		if (header[1] == 0x02) {
 			fclose(fp);
@@ -185,6 +192,10 @@ int AFILE_OpenFile(const char *filename, int reboot, int diskno, int readonly)
 		if (!BINLOAD_Loader(filename))
 			return AFILE_ERROR;
 		break;
+	case AFILE_SAP:
+		if (!SAP_Load(filename))
+			return AFILE_ERROR;
+		break;
 	case AFILE_CART:
 	case AFILE_ROM:
 		{
@@ -19,6 +19,7 @@
 #define AFILE_STATE_GZ   14
 #define AFILE_PRO        15
 #define AFILE_ATX        16
+#define AFILE_SAP        17
 
 /* ATR format header */
 struct AFILE_ATR_Header {
@@ -651,6 +651,47 @@ UWORD ANTIC_cl[128];
 		WRITE_VIDEO(ptr++, art_lookup_new[(screendata_tally & 0x000fc0) >> 6]); \
 	}
 
+/* Playfield blocks without players and missiles
+   In the 4-colour and hi-res modes each pair of bits selects one of four
+   pixel values, so a nibble expands to two pixels - a single long looked up
+   in a 16-entry table built for the current line. Blocks of PF_BLOCK
+   characters are drawn with two lookups per byte and no branches on the
+   data, if all their PMG pixels are zero. Other blocks are drawn byte by byte
+   as before. */
+
+#ifdef WORDS_UNALIGNED_OK
+
+#define PF_BLOCK 4
+
+static ULONG nibble_lookup[2][16];
+
+static void init_nibble_lookup(ULONG *lookup, UWORD c0, UWORD c1, UWORD c2, UWORD c3)
+{
+	UWORD c[4];
+	int i;
+	c[0] = c0;
+	c[1] = c1;
+	c[2] = c2;
+	c[3] = c3;
+	for (i = 0; i < 16; i++) {
+		((UWORD *) (lookup + i))[0] = c[i >> 2];
+		((UWORD *) (lookup + i))[1] = c[i & 3];
+	}
+}
+
+#define IS_ZERO_PM_BLOCK(x) (!(UNALIGNED_GET_LONG((x), pm_scanline_read_long_stat) \
+	| UNALIGNED_GET_LONG((x) + 1, pm_scanline_read_long_stat) \
+	| UNALIGNED_GET_LONG((x) + 2, pm_scanline_read_long_stat) \
+	| UNALIGNED_GET_LONG((x) + 3, pm_scanline_read_long_stat)))
+
+#define DRAW_NIBBLES(lookup, data) { \
+		WRITE_VIDEO_LONG_UNALIGNED((ULONG *) ptr, (lookup)[(data) >> 4]); \
+		WRITE_VIDEO_LONG_UNALIGNED(((ULONG *) ptr) + 1, (lookup)[(data) & 0xf]); \
+		ptr += 4; \
+	}
+
+#endif /* WORDS_UNALIGNED_OK */
+
 /* Hi-res modes optimizations
    Now hi-res modes are drawn with words, not bytes. Endianess defaults
    to little-endian. WORDS_BIGENDIAN should be defined when compiling on
@@ -962,9 +1003,16 @@ int ANTIC_Initialise(int *argc, char *argv[])
 			}
 			else a_m = TRUE;
 		}
+#ifndef NO_RENDER_CACHE
+		else if (strcmp(argv[i], "-no-render-cache") == 0)
+			ANTIC_render_cache = FALSE;
+#endif
 		else {
 			if (strcmp(argv[i], "-help") == 0) {
 				Log_print("\t-artif <num>     Set artifacting mode 0-4 (0 = disable)");
+#ifndef NO_RENDER_CACHE
+				Log_print("\t-no-render-cache Redraw all scanlines in every frame");
+#endif
 			}
 			argv[j++] = argv[i];
 		}
@@ -1478,11 +1526,28 @@ static void draw_antic_2(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 	INIT_BACKGROUND_6
 	INIT_ANTIC_2
 	INIT_HIRES
+#ifdef PF_BLOCK
+	init_nibble_lookup(nibble_lookup[0], hires_norm(0x00), hires_norm(0x40), hires_norm(0x80), hires_norm(0xc0));
+#endif
 
 	CHAR_LOOP_BEGIN
-		UBYTE screendata = *antic_memptr++;
+		UBYTE screendata;
 		int chdata;
 
+#ifdef PF_BLOCK
+		if (nchars >= PF_BLOCK && IS_ZERO_PM_BLOCK(t_pm_scanline_ptr)) {
+			int k = PF_BLOCK;
+			do {
+				screendata = *antic_memptr++;
+				GET_CHDATA_ANTIC_2
+				DRAW_NIBBLES(nibble_lookup[0], chdata)
+			} while (--k);
+			t_pm_scanline_ptr += PF_BLOCK;
+			nchars -= PF_BLOCK - 1;
+			continue;
+		}
+#endif
+		screendata = *antic_memptr++;
 		GET_CHDATA_ANTIC_2
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
 			if (chdata) {
@@ -1816,11 +1881,33 @@ static void draw_antic_4(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 	lookup2[0x80] = lookup2[0x20] = lookup2[0x08] = lookup2[0x02] = ANTIC_cl[C_PF1];
 	lookup2[0xc0] = lookup2[0x30] = lookup2[0x0c] = lookup2[0x03] = ANTIC_cl[C_PF2];
 	lookup2[0xcf] = lookup2[0x3f] = lookup2[0x1b] = lookup2[0x12] = ANTIC_cl[C_PF3];
+#ifdef PF_BLOCK
+	init_nibble_lookup(nibble_lookup[0], ANTIC_cl[C_BAK], ANTIC_cl[C_PF0], ANTIC_cl[C_PF1], ANTIC_cl[C_PF2]);
+	init_nibble_lookup(nibble_lookup[1], ANTIC_cl[C_BAK], ANTIC_cl[C_PF0], ANTIC_cl[C_PF1], ANTIC_cl[C_PF3]);
+#endif
 
 	CHAR_LOOP_BEGIN
-		UBYTE screendata = *antic_memptr++;
+		UBYTE screendata;
 		const UWORD *lookup;
 		UBYTE chdata;
+#ifdef PF_BLOCK
+		if (nchars >= PF_BLOCK && IS_ZERO_PM_BLOCK(t_pm_scanline_ptr)) {
+			int k = PF_BLOCK;
+			do {
+				screendata = *antic_memptr++;
+#ifdef PAGED_MEM
+				chdata = MEMORY_dGetByte(t_chbase + ((UWORD) (screendata & 0x7f) << 3));
+#else
+				chdata = chptr[(screendata & 0x7f) << 3];
+#endif
+				DRAW_NIBBLES(nibble_lookup[screendata >> 7], chdata)
+			} while (--k);
+			t_pm_scanline_ptr += PF_BLOCK;
+			nchars -= PF_BLOCK - 1;
+			continue;
+		}
+#endif
+		screendata = *antic_memptr++;
 		if (screendata & 0x80)
 			lookup = lookup2 + 0xf;
 		else
@@ -2211,9 +2298,25 @@ static void draw_antic_e(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 	lookup2[0x40] = lookup2[0x10] = lookup2[0x04] = lookup2[0x01] = ANTIC_cl[C_PF0];
 	lookup2[0x80] = lookup2[0x20] = lookup2[0x08] = lookup2[0x02] = ANTIC_cl[C_PF1];
 	lookup2[0xc0] = lookup2[0x30] = lookup2[0x0c] = lookup2[0x03] = ANTIC_cl[C_PF2];
+#ifdef PF_BLOCK
+	init_nibble_lookup(nibble_lookup[0], ANTIC_cl[C_BAK], ANTIC_cl[C_PF0], ANTIC_cl[C_PF1], ANTIC_cl[C_PF2]);
+#endif
 
 	CHAR_LOOP_BEGIN
-		UBYTE screendata = *antic_memptr++;
+		UBYTE screendata;
+#ifdef PF_BLOCK
+		if (nchars >= PF_BLOCK && IS_ZERO_PM_BLOCK(t_pm_scanline_ptr)) {
+			DRAW_NIBBLES(nibble_lookup[0], antic_memptr[0])
+			DRAW_NIBBLES(nibble_lookup[0], antic_memptr[1])
+			DRAW_NIBBLES(nibble_lookup[0], antic_memptr[2])
+			DRAW_NIBBLES(nibble_lookup[0], antic_memptr[3])
+			antic_memptr += PF_BLOCK;
+			t_pm_scanline_ptr += PF_BLOCK;
+			nchars -= PF_BLOCK - 1;
+			continue;
+		}
+#endif
+		screendata = *antic_memptr++;
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
 			if (screendata) {
 				WRITE_VIDEO(ptr++, lookup2[screendata & 0xc0]);
@@ -2319,9 +2422,25 @@ static void draw_antic_f(int nchars, const UBYTE *antic_memptr, UWORD *ptr, cons
 {
 	INIT_BACKGROUND_6
 	INIT_HIRES
+#ifdef PF_BLOCK
+	init_nibble_lookup(nibble_lookup[0], hires_norm(0x00), hires_norm(0x40), hires_norm(0x80), hires_norm(0xc0));
+#endif
 
 	CHAR_LOOP_BEGIN
-		int screendata = *antic_memptr++;
+		int screendata;
+#ifdef PF_BLOCK
+		if (nchars >= PF_BLOCK && IS_ZERO_PM_BLOCK(t_pm_scanline_ptr)) {
+			DRAW_NIBBLES(nibble_lookup[0], antic_memptr[0])
+			DRAW_NIBBLES(nibble_lookup[0], antic_memptr[1])
+			DRAW_NIBBLES(nibble_lookup[0], antic_memptr[2])
+			DRAW_NIBBLES(nibble_lookup[0], antic_memptr[3])
+			antic_memptr += PF_BLOCK;
+			t_pm_scanline_ptr += PF_BLOCK;
+			nchars -= PF_BLOCK - 1;
+			continue;
+		}
+#endif
+		screendata = *antic_memptr++;
 		if (IS_ZERO_ULONG(t_pm_scanline_ptr)) {
 			if (screendata) {
 				WRITE_VIDEO(ptr++, hires_norm(screendata & 0xc0));
@@ -2635,6 +2754,187 @@ static void draw_antic_0_dmactl_bug(int nchars, const UBYTE *antic_memptr, UWORD
 }
 #endif
 
+/* Render cache ------------------------------------------------------------ */
+
+#ifndef NO_RENDER_CACHE
+
+int ANTIC_render_cache = TRUE;
+UBYTE ANTIC_scanline_dirty[Screen_HEIGHT];
+
+/* Everything the pixels of a scanline depend on, as long as no player/missile
+   graphics are visible on it. The structure is cleared before it's filled
+   in, so that it can be compared with memcmp. */
+typedef struct {
+	draw_antic_function draw_antic;
+	void (*draw_antic_0)(void);
+	int playfield;
+	int md;
+	int chars_displayed;
+	int x_min;
+	int ch_offset;
+	int left_border_chars;
+	int right_border_start;
+#ifdef NEW_CYCLE_EXACT
+	int left_border_start;
+	int right_border_end;
+	int dmactl_bug_chdata;
+#endif
+	UBYTE anticmode;
+	UBYTE dctr;
+	UBYTE chactl;
+	UBYTE prior;
+	UBYTE colours[9];
+	UBYTE memory[sizeof(antic_memory)];
+	/* the character set row of each byte in memory (font modes only) */
+	UBYTE glyphs[sizeof(antic_memory)];
+} render_key;
+
+typedef struct {
+	render_key key;
+	int valid;
+	int xpos_delta; /* font cycles added to ANTIC_xpos when drawing */
+} render_entry;
+
+static render_entry render_cache[Screen_HEIGHT];
+/* Screen_atari line at scrn_ptr */
+#define RENDER_CACHE_LINE ((int) (scrn_ptr - (UWORD *) Screen_atari) / (Screen_WIDTH / 2))
+/* The buffer described by render_cache. */
+static const ULONG *render_cache_screen = NULL;
+/* The scanline being drawn, or -1 if it's not going to be cached. */
+static int render_cache_line = -1;
+static int render_cache_xpos;
+static render_key render_cache_new;
+
+void ANTIC_InvalidateLines(int y, int height)
+{
+	if (y < 0) {
+		height += y;
+		y = 0;
+	}
+	if (y + height > Screen_HEIGHT)
+		height = Screen_HEIGHT - y;
+	for (; height > 0; y++, height--) {
+		render_cache[y].valid = FALSE;
+		ANTIC_scanline_dirty[y] = 1;
+	}
+}
+
+static void render_cache_build_key(render_key *key, int playfield)
+{
+	memset(key, 0, sizeof(render_key));
+	key->draw_antic_0 = draw_antic_0_ptr;
+	key->playfield = playfield;
+	key->left_border_chars = left_border_chars;
+	key->right_border_start = right_border_start;
+#ifdef NEW_CYCLE_EXACT
+	key->left_border_start = left_border_start;
+	key->right_border_end = right_border_end;
+#endif
+	key->prior = GTIA_PRIOR;
+	key->colours[0] = GTIA_COLPM0;
+	key->colours[1] = GTIA_COLPM1;
+	key->colours[2] = GTIA_COLPM2;
+	key->colours[3] = GTIA_COLPM3;
+	key->colours[4] = GTIA_COLPF0;
+	key->colours[5] = GTIA_COLPF1;
+	key->colours[6] = GTIA_COLPF2;
+	key->colours[7] = GTIA_COLPF3;
+	key->colours[8] = GTIA_COLBK;
+	if (!playfield)
+		return;
+	key->draw_antic = draw_antic_ptr;
+	key->md = md;
+	key->chars_displayed = chars_displayed[md];
+	key->x_min = x_min[md];
+	key->ch_offset = ch_offset[md];
+#ifdef NEW_CYCLE_EXACT
+	key->dmactl_bug_chdata = dmactl_bug_chdata;
+#endif
+	key->anticmode = anticmode;
+	key->dctr = dctr;
+	key->chactl = ANTIC_CHACTL;
+	memcpy(key->memory, antic_memory, sizeof(antic_memory));
+	if (anticmode <= 7) {
+		/* same character set addressing as in the draw_antic_[2-7] routines */
+		UWORD t_chbase;
+		int mask = 0x7f;
+		const UBYTE *chptr;
+		int i;
+		if (anticmode <= 3)
+			t_chbase = (dctr ^ chbase_20) & 0xfc07;
+		else if (anticmode <= 5)
+			t_chbase = ((anticmode == 4 ? dctr : dctr >> 1) ^ chbase_20) & 0xfc07;
+		else {
+			t_chbase = (anticmode == 6 ? dctr & 7 : dctr >> 1) ^ chbase_20;
+			mask = 0x3f;
+		}
+		if (ANTIC_xe_ptr != NULL && chbase_20 < 0x8000 && chbase_20 >= 0x4000)
+			chptr = ANTIC_xe_ptr + (t_chbase & 0x3fff);
+		else
+			chptr = MEMORY_mem + t_chbase;
+		for (i = 0; i < (int) sizeof(antic_memory); i++)
+			key->glyphs[i] = chptr[(antic_memory[i] & mask) << 3];
+	}
+}
+
+/* Returns TRUE if the current scanline looks the same as in Screen_atari,
+   so it need not be drawn. Otherwise the caller draws the scanline
+   and then calls render_cache_store(). */
+static int render_cache_lookup(int playfield)
+{
+	int y = RENDER_CACHE_LINE;
+	render_entry *entry;
+	render_cache_line = -1;
+	if (y < 0 || y >= Screen_HEIGHT)
+		return FALSE;
+	entry = &render_cache[y];
+	if (!ANTIC_render_cache || GTIA_pm_dirty
+#ifndef NO_SIMPLE_PAL_BLENDING
+		|| ANTIC_pal_blending
+#endif
+		) {
+		entry->valid = FALSE;
+		ANTIC_scanline_dirty[y] = 1;
+		return FALSE;
+	}
+	render_cache_build_key(&render_cache_new, playfield);
+	if (entry->valid && memcmp(&entry->key, &render_cache_new, sizeof(render_key)) == 0) {
+		ANTIC_xpos += entry->xpos_delta;
+		return TRUE;
+	}
+	ANTIC_scanline_dirty[y] = 1;
+	render_cache_line = y;
+	render_cache_xpos = ANTIC_xpos;
+	return FALSE;
+}
+
+static void render_cache_store(void)
+{
+	if (render_cache_line >= 0) {
+		render_entry *entry = &render_cache[render_cache_line];
+		entry->key = render_cache_new;
+		entry->valid = TRUE;
+		entry->xpos_delta = ANTIC_xpos - render_cache_xpos;
+	}
+}
+
+/* Called at the beginning of a frame that is going to be drawn. */
+static void render_cache_new_frame(void)
+{
+	if (render_cache_screen != Screen_atari) {
+		ANTIC_InvalidateLines(0, Screen_HEIGHT);
+		render_cache_screen = Screen_atari;
+	}
+}
+
+#else /* NO_RENDER_CACHE */
+
+#define render_cache_lookup(playfield) FALSE
+#define render_cache_store()
+#define render_cache_new_frame()
+
+#endif /* NO_RENDER_CACHE */
+
 /* Artifacting ------------------------------------------------------------ */
 
 void ANTIC_UpdateArtifacting(void)
@@ -2661,6 +2961,7 @@ void ANTIC_UpdateArtifacting(void)
 	UBYTE q;
 	UBYTE art_white;
 
+	ANTIC_InvalidateLines(0, Screen_HEIGHT);
 	if (ANTIC_artif_mode == 0) {
 		draw_antic_table[0][2] = draw_antic_table[0][3] = draw_antic_2;
 		draw_antic_table[0][0xf] = draw_antic_f;
@@ -2842,6 +3143,42 @@ int ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
 static int scanlines_to_curses_display = 0;
 #endif
 
+#ifdef NEW_CYCLE_EXACT
+/* draw the rest of the current scanline at the end of it */
+static void draw_scanline_end(void)
+{
+#ifndef NO_RENDER_CACHE
+	if (ANTIC_cur_screen_pos != LBORDER_START) {
+		/* drawn in parts because of mid-line register changes */
+		ANTIC_InvalidateLines(RENDER_CACHE_LINE, 1);
+		draw_partial_scanline(ANTIC_cur_screen_pos, RBORDER_END);
+		return;
+	}
+	if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0) {
+		if (render_cache_lookup(FALSE))
+			return;
+	}
+	else {
+		/* ANTIC data is needed for the comparison, so load it
+		   before draw_partial_scanline() would */
+		if (need_load) {
+			antic_load();
+#ifdef USE_CURSES
+			scanlines_to_curses_display = 1;
+#endif
+			need_load = FALSE;
+		}
+		if (render_cache_lookup(TRUE))
+			return;
+	}
+	draw_partial_scanline(LBORDER_START, RBORDER_END);
+	render_cache_store();
+#else
+	draw_partial_scanline(ANTIC_cur_screen_pos, RBORDER_END);
+#endif /* NO_RENDER_CACHE */
+}
+#endif /* NEW_CYCLE_EXACT */
+
 /* This function emulates one frame drawing screen at Screen_atari */
 void ANTIC_Frame(int draw_display)
 {
@@ -2870,6 +3207,8 @@ void ANTIC_Frame(int draw_display)
 	} while (ANTIC_ypos < 8);
 
 	scrn_ptr = (UWORD *) Screen_atari;
+	if (draw_display)
+		render_cache_new_frame();
 #ifdef NEW_CYCLE_EXACT
 	ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
 #endif
@@ -3064,6 +3403,7 @@ void ANTIC_Frame(int draw_display)
 				if (toggle == 1) {\
 					FILL_VIDEO(scrn_ptr + LBORDER_START, 0x0f0f, (RBORDER_END - LBORDER_START) * 2);\
 				}\
+				ANTIC_InvalidateLines(RENDER_CACHE_LINE, 1);\
 				toggle = !toggle;\
 			}}while(0)
 #else
@@ -3074,7 +3414,7 @@ void ANTIC_Frame(int draw_display)
 		GTIA_NewPmScanline();
 		if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0) {
 			GOEOL_CYCLE_EXACT;
-			draw_partial_scanline(ANTIC_cur_screen_pos, RBORDER_END);
+			draw_scanline_end();
 			UPDATE_DMACTL;
 			UPDATE_GTIA_BUG;
 			ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
@@ -3088,7 +3428,7 @@ void ANTIC_Frame(int draw_display)
 		}
 
 		GOEOL_CYCLE_EXACT;
-		draw_partial_scanline(ANTIC_cur_screen_pos, RBORDER_END);
+		draw_scanline_end();
 		UPDATE_DMACTL;
 		UPDATE_GTIA_BUG;
 		ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
@@ -3103,7 +3443,10 @@ void ANTIC_Frame(int draw_display)
 		ANTIC_xpos += ANTIC_DMAR;
 
 		if (anticmode < 2 || (ANTIC_DMACTL & 3) == 0) {
-			draw_antic_0_ptr();
+			if (!render_cache_lookup(FALSE)) {
+				draw_antic_0_ptr();
+				render_cache_store();
+			}
 			GOEOL;
 			YPOS_BREAK_FLICKER;
 			scrn_ptr += Screen_WIDTH / 2;
@@ -3130,10 +3473,13 @@ void ANTIC_Frame(int draw_display)
 				ANTIC_xpos -= extra_cycles[md];
 		}
 
-		draw_antic_ptr(chars_displayed[md],
-			antic_memory + ANTIC_margin + ch_offset[md],
-			scrn_ptr + x_min[md],
-			(ULONG *) &GTIA_pm_scanline[x_min[md]]);
+		if (!render_cache_lookup(TRUE)) {
+			draw_antic_ptr(chars_displayed[md],
+				antic_memory + ANTIC_margin + ch_offset[md],
+				scrn_ptr + x_min[md],
+				(ULONG *) &GTIA_pm_scanline[x_min[md]]);
+			render_cache_store();
+		}
 
 		GOEOL;
 #endif /* NEW_CYCLE_EXACT */
@@ -134,4 +134,28 @@ void ANTIC_UpdateScanlinePrior(UBYTE byte);
 extern int ANTIC_pal_blending;
 #endif /* NO_SIMPLE_PAL_BLENDING */
 
+/* The render cache compares the inputs of each scanline with the previous
+   frame and skips drawing it if nothing changed. It works on the raw colour
+   values and reads character sets directly from memory. */
+#if defined(BASIC) || defined(CURSES_BASIC) || defined(PAGED_MEM) || defined(USE_COLOUR_TRANSLATION_TABLE)
+#define NO_RENDER_CACHE
+#endif
+
+#ifndef NO_RENDER_CACHE
+/* Set to 0 to disable the render cache. */
+extern int ANTIC_render_cache;
+
+/* One entry for each of Screen_HEIGHT lines of Screen_atari, set to 1 when
+   the line is redrawn. Platform code that displays only the changed lines
+   clears the entries after displaying the screen. */
+extern UBYTE ANTIC_scanline_dirty[];
+
+/* Must be called by everything that draws into Screen_atari other than
+   ANTIC_Frame (e.g. on-screen indicators or the user interface), so that
+   HEIGHT lines starting at Y get redrawn in the next frame. */
+void ANTIC_InvalidateLines(int y, int height);
+#else
+#define ANTIC_InvalidateLines(y, height)
+#endif /* NO_RENDER_CACHE */
+
 #endif /* ANTIC_H_ */
@@ -69,6 +69,9 @@
 #include "antic.h"
 #include "artifact.h"
 #include "atari.h"
+#ifdef AVI_RECORDING
+#include "avirec.h"
+#endif
 #include "binload.h"
 #include "cartridge.h"
 #include "cassette.h"
@@ -90,6 +93,10 @@
 #include "pokey.h"
 #include "rtime.h"
 #include "pbi.h"
+#include "sap.h"
+#ifdef SHM_EXPORT
+#include "shmexport.h"
+#endif
 #include "sio.h"
 #include "sysrom.h"
 #include "util.h"
@@ -105,6 +112,7 @@
 #endif /* BASIC */
 #if defined(SOUND) && !defined(__PLUS)
 #include "pokeysnd.h"
+#include "sndrender.h"
 #include "sndsave.h"
 #include "sound.h"
 #endif
@@ -582,6 +590,13 @@ int Atari800_Initialise(int *argc, char *argv[])
 		else if (strcmp(argv[i], "-nostereo") == 0) {
 			POKEYSND_stereo_enabled = FALSE;
 		}
+		else if (strcmp(argv[i], "-quad") == 0) {
+			POKEYSND_stereo_enabled = TRUE;
+			POKEYSND_quad_enabled = TRUE;
+		}
+		else if (strcmp(argv[i], "-noquad") == 0) {
+			POKEYSND_quad_enabled = FALSE;
+		}
 #endif /* STEREO_SOUND */
 		else if (strcmp(argv[i], "-turbo") == 0) {
 			Atari800_turbo = TRUE;
@@ -632,6 +647,28 @@ int Atari800_Initialise(int *argc, char *argv[])
 				}
 				else a_m = TRUE;
 			}
+#ifdef STEREO_SOUND
+			else if (strcmp(argv[i], "-pokeypan") == 0) {
+				if (i_a) {
+					if (!POKEYSND_SetPanning(argv[++i])) {
+						Log_print("Invalid POKEY panning - must be up to %d numbers from -100 to 100", POKEY_MAXPOKEYS);
+						return FALSE;
+					}
+				}
+				else a_m = TRUE;
+			}
+#endif
+#if defined(SOUND) && !defined(__PLUS)
+			else if (strcmp(argv[i], "-pokeylog") == 0) {
+				if (i_a) {
+					if (!POKEYSND_OpenLog(argv[++i])) {
+						Log_print("Cannot create %s", argv[i]);
+						return FALSE;
+					}
+				}
+				else a_m = TRUE;
+			}
+#endif
 			else if (strcmp(argv[i], "-mapram") == 0)
 				MEMORY_enable_mapram = TRUE;
 			else if (strcmp(argv[i], "-no-mapram") == 0)
@@ -699,6 +736,16 @@ int Atari800_Initialise(int *argc, char *argv[])
 					Log_print("\t-no-mapram       Disable MapRAM");
 #ifdef R_IO_DEVICE
 					Log_print("\t-rdevice [<dev>] Enable R: emulation (using serial device <dev>)");
+#endif
+#ifdef STEREO_SOUND
+					Log_print("\t-stereo          Enable a second POKEY chip at $D210");
+					Log_print("\t-nostereo        Disable the second POKEY chip");
+					Log_print("\t-quad            Enable four POKEY chips at $D200-$D23F");
+					Log_print("\t-noquad          Use two POKEY chips with -stereo");
+					Log_print("\t-pokeypan <list> Position of each chip, -100 (left) to 100 (right)");
+#endif
+#if defined(SOUND) && !defined(__PLUS)
+					Log_print("\t-pokeylog <file> Log the writes to the POKEY sound registers");
 #endif
 					Log_print("\t-turbo           Run emulated Atari as fast as possible");
 					Log_print("\t-v               Show version/release number");
@@ -747,6 +794,7 @@ int Atari800_Initialise(int *argc, char *argv[])
 		|| !CARTRIDGE_Initialise(argc, argv)
 		|| !CASSETTE_Initialise(argc, argv)
 		|| !PBI_Initialise(argc,argv)
+		|| !SAP_Initialise(argc, argv)
 #ifdef VOICEBOX
 		|| !VOICEBOX_Initialise(argc, argv)
 #endif
@@ -765,12 +813,25 @@ int Atari800_Initialise(int *argc, char *argv[])
 #if SUPPORTS_CHANGE_VIDEOMODE
 		|| !VIDEOMODE_Initialise(argc, argv)
 #endif
+#if defined(SOUND) && !defined(__PLUS)
+		|| !SndRender_Initialise(argc, argv)
+#endif
 #ifndef DONT_DISPLAY
 		/* Platform Specific Initialisation */
+#if defined(SOUND) && !defined(__PLUS)
+		|| (!SndRender_enabled && !PLATFORM_Initialise(argc, argv))
+#else
 		|| !PLATFORM_Initialise(argc, argv)
 #endif
+#endif
 #if !defined(BASIC) && !defined(CURSES_BASIC)
 		|| !Screen_Initialise(argc, argv)
+#endif
+#ifdef AVI_RECORDING
+		|| !AVIRec_Initialise(argc, argv)
+#endif
+#ifdef SHM_EXPORT
+		|| !SHMExport_Initialise(argc, argv)
 #endif
 		/* Initialise Custom Chips */
 		|| !ANTIC_Initialise(argc, argv)
@@ -791,7 +852,11 @@ int Atari800_Initialise(int *argc, char *argv[])
 
 #if SUPPORTS_CHANGE_VIDEOMODE
 #ifndef DONT_DISPLAY
-	if (!VIDEOMODE_InitialiseDisplay()) {
+	if (
+#if defined(SOUND) && !defined(__PLUS)
+		!SndRender_enabled &&
+#endif
+		!VIDEOMODE_InitialiseDisplay()) {
 		Atari800_ErrExit();
 		return FALSE;
 	}
@@ -894,6 +959,17 @@ int Atari800_Initialise(int *argc, char *argv[])
 
 #ifdef BENCHMARK
 	benchmark_start_time = Atari_time();
+#endif
+#if defined(SOUND) && !defined(__PLUS)
+	/* The platform isn't initialised, so don't return to its main loop.
+	   Shut down the same way as on AKEY_EXIT instead. */
+	if (SndRender_enabled) {
+		int status = SndRender_Run() ? 0 : 1;
+		/* -render changes settings such as stereo and turbo; don't save them. */
+		CFG_save_on_exit = FALSE;
+		Atari800_Exit(FALSE);
+		exit(status);
+	}
 #endif
 	return TRUE;
 }
@@ -936,7 +1012,12 @@ int Atari800_Exit(int run_monitor)
 			sums[0], sums[1], sums[2], sums[3], sums[4], sums[5]);
 	}
 #endif /* STAT_UNALIGNED_WORDS */
-	restart = PLATFORM_Exit(run_monitor);
+#if defined(SOUND) && !defined(__PLUS)
+	if (SndRender_enabled)
+		restart = FALSE; /* the platform wasn't initialised */
+	else
+#endif
+		restart = PLATFORM_Exit(run_monitor);
 #ifdef HAVE_SIGNAL
 	/* If a user pressed Ctrl+C in the monitor, avoid immediate return to it. */
 	sigint_flag = FALSE;
@@ -972,6 +1053,16 @@ int Atari800_Exit(int run_monitor)
 #endif
 #ifdef SOUND
 		SndSave_CloseSoundFile();
+		POKEYSND_CloseLog();
+#endif
+#ifdef AVI_RECORDING
+		AVIRec_Exit();
+#endif
+#ifdef SHM_EXPORT
+		SHMExport_Exit();
+#endif
+#if !defined(BASIC) && !defined(CURSES_BASIC)
+		Screen_Exit();	/* finish writing screenshots */
 #endif
 		MONITOR_Exit();
 #ifdef SDL
@@ -1313,7 +1404,8 @@ void Atari800_Frame(void)
 		break;
 #ifndef CURSES_BASIC
 	case AKEY_SCREENSHOT:
-		Screen_SaveNextScreenshot(FALSE);
+		if (!Screen_StartScreenshotBurst())
+			Screen_SaveNextScreenshot(FALSE);
 		break;
 	case AKEY_SCREENSHOT_INTERLACE:
 		Screen_SaveNextScreenshot(TRUE);
@@ -1344,7 +1436,11 @@ void Atari800_Frame(void)
 #ifdef BASIC
 	basic_frame();
 #else /* BASIC */
-	if (++refresh_counter >= Atari800_refresh_rate) {
+	if (++refresh_counter >= Atari800_refresh_rate
+#if defined(SOUND) && !defined(__PLUS)
+		&& !SndRender_enabled
+#endif
+	) {
 		refresh_counter = 0;
 #ifdef USE_CURSES
 		curses_clear_screen();
@@ -1353,6 +1449,7 @@ void Atari800_Frame(void)
 		basic_frame();
 #else
 		ANTIC_Frame(TRUE);
+		Screen_Frame();
 		INPUT_DrawMousePointer();
 		Screen_DrawAtariSpeed(Atari_time());
 		Screen_DrawDiskLED();
@@ -1374,8 +1471,19 @@ void Atari800_Frame(void)
 	}
 #endif /* BASIC */
 	POKEY_Frame();
-#ifdef SOUND
+#if defined(SOUND) && !defined(__PLUS)
+	if (SndRender_enabled)
+		SndRender_Frame();
+	else
+		Sound_Update();
+#elif defined(SOUND)
 	Sound_Update();
+#endif
+#ifdef AVI_RECORDING
+	AVIRec_Frame();
+#endif
+#ifdef SHM_EXPORT
+	SHMExport_Frame();
 #endif
 	Atari800_nframes++;
 #ifdef BENCHMARK
@@ -1390,7 +1498,7 @@ void Atari800_Frame(void)
 #ifdef ALTERNATE_SYNC_WITH_HOST
 	if (refresh_counter == 0)
 #endif
-		if (Atari800_turbo == FALSE) Atari800_Sync();
+		if (Atari800_turbo == FALSE && !CASSETTE_Turbo()) Atari800_Sync();
 #endif /* BENCHMARK */
 }
 
@@ -1531,6 +1639,11 @@ void Atari800_SetTVMode(int mode)
 		Colours_SetVideoSystem(mode);
 		ARTIFACT_SetTVMode(mode);
 #endif
+#if defined(SOUND) && !defined(__PLUS)
+		/* There's no display nor sound device to update. */
+		if (SndRender_enabled)
+			return;
+#endif
 #if SUPPORTS_CHANGE_VIDEOMODE
 		VIDEOMODE_SetVideoSystem(mode);
 #endif
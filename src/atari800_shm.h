@@ -0,0 +1,68 @@
+#ifndef ATARI800_SHM_H_
+#define ATARI800_SHM_H_
+
+/* Layout of the shared memory object created with the -shm option.
+   This header doesn't depend on the rest of the emulator, so that other
+   programs can include it to read frames and sound and to send input.
+
+   The object starts with A8SHM_Header, followed by frame_slots frame
+   slots of frame_slot_size bytes at frame_offset, and by audio_size bytes
+   of sound at audio_offset. All values are in host byte order and
+   "unsigned int" is 32 bits.
+
+   Reading frames: the emulator stores frame N (counted from 1) in slot
+   (N - 1) % frame_slots and then sets frame_count to N. A slot's seq is
+   odd while the emulator is writing to it. To read the latest frame
+   without copying it, read frame_count, take seq of its slot, use
+   the pixels and palette in place, then check that seq is still the same
+   and even - otherwise the frame was overwritten and must be skipped.
+
+   Reading sound: audio_written counts the bytes written to the ring so far
+   (wrapping at 2^32); byte number K is at audio_offset + K % audio_size.
+   Sound is PCM in the format given by the audio_* fields.
+
+   Sending input: set the fields of "input", then increment input_seq.
+   Input is used from the next emulated frame while input_enabled is set;
+   the emulator's own keyboard and joysticks are ignored then. */
+
+#define A8SHM_MAGIC   0x4d485338 /* "8SHM" */
+#define A8SHM_VERSION 1
+
+typedef struct {
+	unsigned int seq;          /* odd while the frame is being written */
+	unsigned int frame_number; /* emulated frame (Atari800_nframes) */
+	unsigned char palette[256 * 3]; /* R, G, B for each colour index */
+	/* followed by width * height colour indexes, line by line */
+} A8SHM_Frame;
+
+typedef struct {
+	unsigned int input_seq;    /* incremented by the writer after each change */
+	unsigned int input_enabled;
+	int key_code;              /* AKEY_* value, -1 for no key */
+	int key_shift;             /* Shift (Atari 5200: second fire button) */
+	int key_consol;            /* bits 0-2 cleared for Start, Select, Option */
+	int port[2];               /* joystick positions, 4 bits for each stick */
+	int trig[4];               /* fire buttons, 0 = pressed */
+} A8SHM_Input;
+
+typedef struct {
+	unsigned int magic;
+	unsigned int version;
+	unsigned int emulator_pid;
+	unsigned int width;
+	unsigned int height;
+	unsigned int frame_slots;
+	unsigned int frame_slot_size;
+	unsigned int frame_offset;
+	unsigned int frame_count;   /* frames completed so far */
+	unsigned int fps_x1000;     /* frames per second * 1000 */
+	unsigned int audio_offset;
+	unsigned int audio_size;
+	unsigned int audio_written; /* bytes written so far */
+	unsigned int audio_freq;    /* 0 if there's no sound */
+	unsigned int audio_channels;
+	unsigned int audio_bits;
+	A8SHM_Input input;
+} A8SHM_Header;
+
+#endif /* ATARI800_SHM_H_ */
@@ -0,0 +1,708 @@
+/*
+ * avirec.c - lossless audio/video recording to AVI files
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "atari.h"
+#include "avirec.h"
+#include "colours.h"
+#include "log.h"
+#include "screen.h"
+#include "util.h"
+#ifdef SOUND
+#include "pokeysnd.h"
+#endif
+
+#if defined(HAVE_FORK) && defined(HAVE_WAITPID) && defined(HAVE_PIPE) && defined(HAVE_SYS_WAIT_H)
+/* Frames are compressed and written by a child process fed through a pipe,
+   so that the encoder doesn't slow down the emulation. */
+#define ASYNC_ENCODER
+#endif
+
+/* The recorded area is the same as in screenshots. */
+#define FRAME_WIDTH 336
+#define FRAME_HEIGHT Screen_HEIGHT
+#define FRAME_LEFT ((Screen_WIDTH - FRAME_WIDTH) / 2)
+#define FRAME_SIZE (FRAME_WIDTH * FRAME_HEIGHT)
+#define PALETTE_SIZE (256 * 3)
+
+/* ZMBV format */
+#define ZMBV_KEYFRAME         0x01
+#define ZMBV_DELTA_PALETTE    0x02
+#define ZMBV_COMPRESSION_ZLIB 1
+#define ZMBV_FORMAT_8BPP      4
+#define BLOCK_SIZE 16
+#define BLOCKS_X ((FRAME_WIDTH + BLOCK_SIZE - 1) / BLOCK_SIZE)
+#define BLOCKS_Y ((FRAME_HEIGHT + BLOCK_SIZE - 1) / BLOCK_SIZE)
+#define VECTORS_SIZE ((BLOCKS_X * BLOCKS_Y * 2 + 3) & ~3)
+
+/* A keyframe every few seconds makes seeking possible. */
+#define KEYFRAME_INTERVAL 300
+
+/* Frame data before compression: palette, motion vectors and pixels. */
+#define WORK_SIZE (PALETTE_SIZE + VECTORS_SIZE + FRAME_SIZE)
+/* Compressed frame: flags, keyframe header and zlib output. */
+#define OUT_SIZE (7 + WORK_SIZE + WORK_SIZE / 1000 + 64)
+
+/* RIFF header, hdrl list with avih and two strl lists, movi list header. */
+#define HEADER_SIZE (12 + 12 + 64 + 124 + 100 + 12)
+
+/* AVI 1.0 offsets are 32-bit - stop well before 2 GB. */
+#define MAX_FILE_SIZE 0x7f000000
+
+/* File given with -record-avi, opened on the first frame. */
+static char start_filename[FILENAME_MAX] = "";
+static int recording = FALSE;
+
+/* Encoder ------------------------------------------------------------------
+   Runs in the child process if ASYNC_ENCODER is defined. */
+
+static FILE *avi_file = NULL;
+static int enc_error;
+static int enc_full;
+static double enc_fps;
+static int snd_channels;
+static int snd_bits;
+static int snd_rate;
+static ULONG file_pos;
+static ULONG movi_end;
+static ULONG video_frames;
+static ULONG sound_bytes;
+static ULONG max_chunk;
+/* idx1 entries: four values for each chunk */
+static ULONG *index_entries = NULL;
+static ULONG index_count;
+static ULONG index_alloc;
+static z_stream zstream;
+static UBYTE prev_frame[FRAME_SIZE];
+static UBYTE prev_palette[PALETTE_SIZE];
+static UBYTE *work = NULL;
+static UBYTE *out = NULL;
+
+static UBYTE *header_ptr;
+
+static void PutId(const char *id)
+{
+	memcpy(header_ptr, id, 4);
+	header_ptr += 4;
+}
+
+static void Put16(int x)
+{
+	header_ptr[0] = (UBYTE) x;
+	header_ptr[1] = (UBYTE) (x >> 8);
+	header_ptr += 2;
+}
+
+static void Put32(ULONG x)
+{
+	header_ptr[0] = (UBYTE) x;
+	header_ptr[1] = (UBYTE) (x >> 8);
+	header_ptr[2] = (UBYTE) (x >> 16);
+	header_ptr[3] = (UBYTE) (x >> 24);
+	header_ptr += 4;
+}
+
+/* Builds HEADER_SIZE bytes of the file header with the current counts. */
+static void BuildHeader(UBYTE *header)
+{
+	int has_sound = sound_bytes > 0;
+	int block_align = snd_channels * snd_bits / 8;
+	header_ptr = header;
+	PutId("RIFF");
+	Put32(file_pos - 8);
+	PutId("AVI ");
+	PutId("LIST");
+	Put32(4 + 64 + 124 + 100);
+	PutId("hdrl");
+
+	PutId("avih");
+	Put32(56);
+	Put32((ULONG) (1000000 / enc_fps + 0.5)); /* microseconds per frame */
+	Put32(0); /* max bytes per second */
+	Put32(0); /* padding granularity */
+	Put32(0x10); /* AVIF_HASINDEX */
+	Put32(video_frames);
+	Put32(0); /* initial frames */
+	Put32(has_sound ? 2 : 1); /* streams */
+	Put32(max_chunk); /* suggested buffer size */
+	Put32(FRAME_WIDTH);
+	Put32(FRAME_HEIGHT);
+	Put32(0);
+	Put32(0);
+	Put32(0);
+	Put32(0);
+
+	PutId("LIST");
+	Put32(4 + 64 + 48);
+	PutId("strl");
+	PutId("strh");
+	Put32(56);
+	PutId("vids");
+	PutId("ZMBV");
+	Put32(0); /* flags */
+	Put16(0); /* priority */
+	Put16(0); /* language */
+	Put32(0); /* initial frames */
+	Put32(1000000); /* scale */
+	Put32((ULONG) (enc_fps * 1000000 + 0.5)); /* rate */
+	Put32(0); /* start */
+	Put32(video_frames); /* length */
+	Put32(max_chunk); /* suggested buffer size */
+	Put32(0xffffffff); /* quality */
+	Put32(0); /* sample size */
+	Put16(0);
+	Put16(0);
+	Put16(FRAME_WIDTH);
+	Put16(FRAME_HEIGHT);
+	PutId("strf");
+	Put32(40);
+	Put32(40); /* BITMAPINFOHEADER size */
+	Put32(FRAME_WIDTH);
+	Put32(FRAME_HEIGHT);
+	Put16(1); /* planes */
+	Put16(24); /* bits per pixel after decoding */
+	PutId("ZMBV");
+	Put32(FRAME_WIDTH * FRAME_HEIGHT * 4);
+	Put32(0);
+	Put32(0);
+	Put32(0);
+	Put32(0);
+
+	if (has_sound) {
+		PutId("LIST");
+		Put32(4 + 64 + 24);
+		PutId("strl");
+		PutId("strh");
+		Put32(56);
+		PutId("auds");
+		Put32(0); /* handler */
+		Put32(0); /* flags */
+		Put16(0); /* priority */
+		Put16(0); /* language */
+		Put32(0); /* initial frames */
+		Put32(block_align); /* scale */
+		Put32(snd_rate * block_align); /* rate */
+		Put32(0); /* start */
+		Put32(sound_bytes / block_align); /* length */
+		Put32(max_chunk); /* suggested buffer size */
+		Put32(0xffffffff); /* quality */
+		Put32(block_align); /* sample size */
+		Put16(0);
+		Put16(0);
+		Put16(0);
+		Put16(0);
+		PutId("strf");
+		Put32(16);
+		Put16(1); /* PCM */
+		Put16(snd_channels);
+		Put32(snd_rate);
+		Put32(snd_rate * block_align);
+		Put16(block_align);
+		Put16(snd_bits);
+	}
+	else {
+		/* no sound stream - fill its place */
+		PutId("JUNK");
+		Put32(92);
+		memset(header_ptr, 0, 92);
+		header_ptr += 92;
+	}
+
+	PutId("LIST");
+	Put32(movi_end - (HEADER_SIZE - 4));
+	PutId("movi");
+}
+
+static void WriteChunk(const char *id, const UBYTE *data, ULONG size, int keyframe)
+{
+	UBYTE chunk_header[8];
+	ULONG *entry;
+	if (enc_error || enc_full)
+		return;
+	/* leave space for the index */
+	if (file_pos + 8 + size + 1 + 8 + 16 * (index_count + 1) > MAX_FILE_SIZE) {
+		Log_print("AVI file size limit reached, recording stopped");
+		enc_full = TRUE;
+		return;
+	}
+	if (index_count >= index_alloc) {
+		index_alloc = index_alloc == 0 ? 4096 : index_alloc * 2;
+		index_entries = (ULONG *) Util_realloc(index_entries, index_alloc * 4 * sizeof(ULONG));
+	}
+	entry = index_entries + 4 * index_count++;
+	entry[0] = id[0] | (id[1] << 8) | (id[2] << 16) | ((ULONG) id[3] << 24);
+	entry[1] = keyframe ? 0x10 : 0; /* AVIIF_KEYFRAME */
+	entry[2] = file_pos - (HEADER_SIZE - 4); /* from the 'movi' id */
+	entry[3] = size;
+	if (size > max_chunk)
+		max_chunk = size;
+
+	header_ptr = chunk_header;
+	PutId(id);
+	Put32(size);
+	if (fwrite(chunk_header, 1, 8, avi_file) != 8
+	 || fwrite(data, 1, size, avi_file) != size
+	 || ((size & 1) && putc(0, avi_file) == EOF))
+		enc_error = TRUE;
+	file_pos += 8 + size + (size & 1);
+	movi_end = file_pos;
+}
+
+static int Encoder_Open(void)
+{
+	UBYTE header[HEADER_SIZE];
+	enc_error = FALSE;
+	enc_full = FALSE;
+	video_frames = 0;
+	sound_bytes = 0;
+	max_chunk = 0;
+	index_count = 0;
+	file_pos = HEADER_SIZE;
+	movi_end = HEADER_SIZE;
+	memset(&zstream, 0, sizeof(zstream));
+	if (deflateInit(&zstream, 4) != Z_OK)
+		return FALSE;
+	work = (UBYTE *) Util_malloc(WORK_SIZE);
+	out = (UBYTE *) Util_malloc(OUT_SIZE);
+	BuildHeader(header);
+	return fwrite(header, 1, HEADER_SIZE, avi_file) == HEADER_SIZE;
+}
+
+/* Writes the index, updates the header and closes the file. */
+static int Encoder_Close(void)
+{
+	UBYTE header[HEADER_SIZE];
+	ULONG i;
+	header_ptr = header;
+	PutId("idx1");
+	Put32(16 * index_count);
+	if (fwrite(header, 1, 8, avi_file) != 8)
+		enc_error = TRUE;
+	for (i = 0; i < 4 * index_count && !enc_error; i += 4) {
+		header_ptr = header;
+		Put32(index_entries[i]);
+		Put32(index_entries[i + 1]);
+		Put32(index_entries[i + 2]);
+		Put32(index_entries[i + 3]);
+		if (fwrite(header, 1, 16, avi_file) != 16)
+			enc_error = TRUE;
+	}
+	file_pos += 8 + 16 * index_count;
+	BuildHeader(header);
+	if (fseek(avi_file, 0, SEEK_SET) != 0
+	 || fwrite(header, 1, HEADER_SIZE, avi_file) != HEADER_SIZE)
+		enc_error = TRUE;
+	if (fclose(avi_file) != 0)
+		enc_error = TRUE;
+	avi_file = NULL;
+	deflateEnd(&zstream);
+	free(work);
+	free(out);
+	free(index_entries);
+	work = out = NULL;
+	index_entries = NULL;
+	index_alloc = 0;
+	return !enc_error;
+}
+
+/* Compresses a frame. The first one and every KEYFRAME_INTERVAL-th are
+   stored whole, the others as XOR with the previous frame for each
+   BLOCK_SIZE x BLOCK_SIZE block that changed. */
+static void Encoder_Frame(const UBYTE *pixels, const UBYTE *palette)
+{
+	int keyframe = video_frames % KEYFRAME_INTERVAL == 0;
+	ULONG work_len = 0;
+	int out_len;
+	int i;
+	if (keyframe) {
+		out[0] = ZMBV_KEYFRAME;
+		out[1] = 0; /* version */
+		out[2] = 1;
+		out[3] = ZMBV_COMPRESSION_ZLIB;
+		out[4] = ZMBV_FORMAT_8BPP;
+		out[5] = BLOCK_SIZE;
+		out[6] = BLOCK_SIZE;
+		out_len = 7;
+		deflateReset(&zstream);
+		memcpy(work, palette, PALETTE_SIZE);
+		memcpy(work + PALETTE_SIZE, pixels, FRAME_SIZE);
+		work_len = PALETTE_SIZE + FRAME_SIZE;
+	}
+	else {
+		UBYTE *vectors;
+		int bx;
+		int by;
+		out[0] = 0;
+		out_len = 1;
+		if (memcmp(palette, prev_palette, PALETTE_SIZE) != 0) {
+			out[0] |= ZMBV_DELTA_PALETTE;
+			for (i = 0; i < PALETTE_SIZE; i++)
+				work[i] = palette[i] ^ prev_palette[i];
+			work_len = PALETTE_SIZE;
+		}
+		vectors = work + work_len;
+		memset(vectors, 0, VECTORS_SIZE);
+		work_len += VECTORS_SIZE;
+		for (by = 0; by < BLOCKS_Y; by++) {
+			int y0 = by * BLOCK_SIZE;
+			int h = FRAME_HEIGHT - y0 < BLOCK_SIZE ? FRAME_HEIGHT - y0 : BLOCK_SIZE;
+			for (bx = 0; bx < BLOCKS_X; bx++) {
+				int x0 = bx * BLOCK_SIZE;
+				int w = FRAME_WIDTH - x0 < BLOCK_SIZE ? FRAME_WIDTH - x0 : BLOCK_SIZE;
+				int offset = y0 * FRAME_WIDTH + x0;
+				int y;
+				for (y = 0; y < h; y++)
+					if (memcmp(pixels + offset + y * FRAME_WIDTH, prev_frame + offset + y * FRAME_WIDTH, w) != 0)
+						break;
+				if (y < h) {
+					/* changed - zero motion vector with the XOR data flag */
+					vectors[(by * BLOCKS_X + bx) * 2] = 1;
+					for (y = 0; y < h; y++) {
+						const UBYTE *p = pixels + offset + y * FRAME_WIDTH;
+						const UBYTE *q = prev_frame + offset + y * FRAME_WIDTH;
+						int x;
+						for (x = 0; x < w; x++)
+							work[work_len++] = p[x] ^ q[x];
+					}
+				}
+			}
+		}
+	}
+	memcpy(prev_frame, pixels, FRAME_SIZE);
+	memcpy(prev_palette, palette, PALETTE_SIZE);
+
+	zstream.next_in = work;
+	zstream.avail_in = work_len;
+	zstream.next_out = out + out_len;
+	zstream.avail_out = OUT_SIZE - out_len;
+	if (deflate(&zstream, Z_SYNC_FLUSH) != Z_OK || zstream.avail_in != 0) {
+		enc_error = TRUE;
+		return;
+	}
+	WriteChunk("00dc", out, OUT_SIZE - zstream.avail_out, keyframe);
+	if (!enc_full)
+		video_frames++;
+}
+
+static void Encoder_Sound(const UBYTE *buffer, ULONG size)
+{
+	WriteChunk("01wb", buffer, size, TRUE);
+	if (!enc_full)
+		sound_bytes += size;
+}
+
+/* Child process ------------------------------------------------------------ */
+
+#ifdef ASYNC_ENCODER
+
+#define MSG_FRAME 0
+#define MSG_SOUND 1
+
+typedef struct {
+	int type;
+	unsigned int size;
+} message_t;
+
+static int pipe_fd = -1;
+static pid_t encoder_pid;
+#ifdef SIGPIPE
+static void (*old_sigpipe)(int);
+#endif
+
+static int WriteAll(int fd, const void *buffer, size_t size)
+{
+	const char *p = (const char *) buffer;
+	while (size > 0) {
+		ssize_t n = write(fd, p, size);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return FALSE;
+		}
+		p += n;
+		size -= n;
+	}
+	return TRUE;
+}
+
+static int ReadAll(int fd, void *buffer, size_t size)
+{
+	char *p = (char *) buffer;
+	while (size > 0) {
+		ssize_t n = read(fd, p, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return FALSE;
+		p += n;
+		size -= n;
+	}
+	return TRUE;
+}
+
+/* Main loop of the child process: encodes messages until the emulator
+   closes the pipe. Exits on a write error, so the emulator stops sending. */
+static void EncoderProcess(int fd)
+{
+	unsigned int buffer_size = FRAME_SIZE + PALETTE_SIZE;
+	UBYTE *buffer = (UBYTE *) Util_malloc(buffer_size);
+	message_t msg;
+	while (!enc_error && ReadAll(fd, &msg, sizeof(msg))) {
+		if (msg.size > buffer_size) {
+			buffer_size = msg.size;
+			buffer = (UBYTE *) Util_realloc(buffer, buffer_size);
+		}
+		if (!ReadAll(fd, buffer, msg.size))
+			break;
+		if (msg.type == MSG_FRAME)
+			Encoder_Frame(buffer, buffer + FRAME_SIZE);
+		else
+			Encoder_Sound(buffer, msg.size);
+	}
+	if (enc_error)
+		Log_print("Error writing AVI file");
+	fflush(stdout);
+	_exit(Encoder_Close() ? 0 : 1);
+}
+
+static void Send(int type, const UBYTE *data, unsigned int size)
+{
+	message_t msg;
+	msg.type = type;
+	msg.size = size;
+	if (!WriteAll(pipe_fd, &msg, sizeof(msg)) || !WriteAll(pipe_fd, data, size)) {
+		Log_print("AVI encoder failed, recording stopped");
+		AVIRec_Close();
+	}
+}
+
+#endif /* ASYNC_ENCODER */
+
+/* Public interface --------------------------------------------------------- */
+
+int AVIRec_IsOpen(void)
+{
+	return recording;
+}
+
+int AVIRec_Open(const char *filename)
+{
+	AVIRec_Close();
+	avi_file = fopen(filename, "wb");
+	if (avi_file == NULL)
+		return FALSE;
+	enc_fps = Atari800_tv_mode == Atari800_TV_PAL ? Atari800_FPS_PAL : Atari800_FPS_NTSC;
+#ifdef SOUND
+	snd_channels = POKEYSND_num_pokeys;
+	snd_bits = POKEYSND_snd_flags & POKEYSND_BIT16 ? 16 : 8;
+	snd_rate = POKEYSND_playback_freq;
+#else
+	snd_channels = 0;
+	snd_bits = 0;
+	snd_rate = 0;
+#endif
+#ifdef ASYNC_ENCODER
+	{
+		int fds[2];
+		if (pipe(fds) == 0) {
+#ifdef FD_CLOEXEC
+			/* programs run by the emulator must not keep the pipe open,
+			   or the encoder never sees its end */
+			fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+			/* don't let the child repeat buffered output */
+			fflush(stdout);
+			encoder_pid = fork();
+			if (encoder_pid == 0) {
+				close(fds[1]);
+				if (!Encoder_Open())
+					_exit(1);
+				EncoderProcess(fds[0]);
+			}
+			close(fds[0]);
+			if (encoder_pid > 0) {
+				/* the child writes the file */
+				fclose(avi_file);
+				avi_file = NULL;
+				pipe_fd = fds[1];
+#ifdef SIGPIPE
+				old_sigpipe = signal(SIGPIPE, SIG_IGN);
+#endif
+				recording = TRUE;
+				return TRUE;
+			}
+			close(fds[1]);
+		}
+		/* no child process - encode in the emulator */
+	}
+#endif /* ASYNC_ENCODER */
+	if (!Encoder_Open()) {
+		Encoder_Close();
+		return FALSE;
+	}
+	recording = TRUE;
+	return TRUE;
+}
+
+void AVIRec_CloseInChild(void)
+{
+#ifdef ASYNC_ENCODER
+	if (pipe_fd >= 0)
+		close(pipe_fd);
+#endif
+}
+
+int AVIRec_Close(void)
+{
+	if (!recording)
+		return TRUE;
+	recording = FALSE;
+#ifdef ASYNC_ENCODER
+	if (pipe_fd >= 0) {
+		int status;
+		close(pipe_fd);
+		pipe_fd = -1;
+#ifdef SIGPIPE
+		signal(SIGPIPE, old_sigpipe);
+#endif
+		return waitpid(encoder_pid, &status, 0) == encoder_pid
+			&& WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+#endif
+	return Encoder_Close();
+}
+
+void AVIRec_Frame(void)
+{
+	static UBYTE frame[FRAME_SIZE + PALETTE_SIZE];
+	const UBYTE *src;
+	UBYTE *dst;
+	int i;
+	if (start_filename[0] != '\0') {
+		if (!AVIRec_Open(start_filename))
+			Log_print("Cannot create AVI file %s", start_filename);
+		start_filename[0] = '\0';
+	}
+	if (!recording)
+		return;
+	src = (const UBYTE *) Screen_atari + FRAME_LEFT;
+	dst = frame;
+	for (i = 0; i < FRAME_HEIGHT; i++) {
+		memcpy(dst, src, FRAME_WIDTH);
+		src += Screen_WIDTH;
+		dst += FRAME_WIDTH;
+	}
+	for (i = 0; i < 256; i++) {
+		*dst++ = Colours_GetR(i);
+		*dst++ = Colours_GetG(i);
+		*dst++ = Colours_GetB(i);
+	}
+#ifdef ASYNC_ENCODER
+	if (pipe_fd >= 0) {
+		Send(MSG_FRAME, frame, sizeof(frame));
+		return;
+	}
+#endif
+	Encoder_Frame(frame, frame + FRAME_SIZE);
+	if (enc_error) {
+		Log_print("Error writing AVI file, recording stopped");
+		AVIRec_Close();
+	}
+}
+
+void AVIRec_Sound(const UBYTE *buffer, unsigned int size)
+{
+	if (!recording || buffer == NULL || size == 0)
+		return;
+#ifdef SOUND
+	if (POKEYSND_snd_flags & POKEYSND_BIT16)
+		size <<= 1;
+#endif
+#ifdef ASYNC_ENCODER
+	if (pipe_fd >= 0) {
+		Send(MSG_SOUND, buffer, size);
+		return;
+	}
+#endif
+	Encoder_Sound(buffer, size);
+	if (enc_error) {
+		Log_print("Error writing AVI file, recording stopped");
+		AVIRec_Close();
+	}
+}
+
+int AVIRec_Initialise(int *argc, char *argv[])
+{
+	int i;
+	int j;
+	for (i = j = 1; i < *argc; i++) {
+		int i_a = (i + 1 < *argc);		/* is argument available? */
+		int a_m = FALSE;			/* error, argument missing! */
+
+		if (strcmp(argv[i], "-record-avi") == 0) {
+			if (i_a)
+				Util_strlcpy(start_filename, argv[++i], sizeof(start_filename));
+			else a_m = TRUE;
+		}
+		else {
+			if (strcmp(argv[i], "-help") == 0)
+				Log_print("\t-record-avi <file> Record video and sound to an AVI file");
+			argv[j++] = argv[i];
+		}
+
+		if (a_m) {
+			Log_print("Missing argument for '%s'", argv[i]);
+			return FALSE;
+		}
+	}
+	*argc = j;
+	return TRUE;
+}
+
+void AVIRec_Exit(void)
+{
+	start_filename[0] = '\0';
+	if (recording && !AVIRec_Close())
+		Log_print("Error writing AVI file");
+}
@@ -0,0 +1,36 @@
+#ifndef AVIREC_H_
+#define AVIREC_H_
+
+#include "atari.h"
+
+/* Lossless recording of the emulated screen and sound to an AVI file.
+   The video uses the ZMBV codec: palette-indexed frames, each XORed
+   against the previous one and compressed with zlib. */
+
+int AVIRec_Initialise(int *argc, char *argv[]);
+void AVIRec_Exit(void);
+
+/* Returns TRUE if recording is in progress. */
+int AVIRec_IsOpen(void);
+
+/* Starts recording to FILENAME, closing the current recording first.
+   Returns FALSE if the file cannot be created. */
+int AVIRec_Open(const char *filename);
+
+/* Stops recording and finishes the file.
+   Returns FALSE if writing the file failed. */
+int AVIRec_Close(void);
+
+/* Closes the pipe to the encoder process in a child process forked by the
+   emulator, so that the encoder sees the end of the recording even while
+   the child is running. */
+void AVIRec_CloseInChild(void);
+
+/* Adds Screen_atari as the next video frame.
+   Called once for each emulated frame, whether drawn or not. */
+void AVIRec_Frame(void);
+
+/* Adds sound samples, in the format written by SndSave_WriteToSoundFile(). */
+void AVIRec_Sound(const UBYTE *buffer, unsigned int size);
+
+#endif /* AVIREC_H_ */
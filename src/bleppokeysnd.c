@@ -0,0 +1,546 @@
+/*
+ * bleppokeysnd.c - POKEY sound emulation with band-limited steps
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#include <math.h>
+#include <string.h>
+
+#include "atari.h"
+#include "antic.h"
+#include "gtia.h"
+#include "pokey.h"
+#include "pokeysnd.h"
+#include "bleppokeysnd.h"
+
+/* The output of a POKEY channel is a square wave that changes only when the
+   channel's counter reaches zero. Each change is added to a buffer of
+   differences as a windowed-sinc impulse placed at the exact sub-sample
+   position of the change; integrating the buffer gives the band-limited
+   sound. The counters are not run tick by tick - the emulation jumps from
+   one counter underflow to the next.
+
+   Register writes take effect at the start of the next POKEYSND_Process()
+   call, as in the other engines without SYNCHRONIZED_SOUND.
+
+   The steps of all chips go straight to the buffers of the output channels,
+   scaled by the chip's share of each channel, so the cost of every output
+   sample is the same for one chip as for four. */
+
+/* Number of output samples that one step is spread over */
+#define BLEP_WIDTH 32
+/* Number of tabulated sub-sample positions of a step; the impulse is
+   interpolated between them */
+#define BLEP_PHASES 64
+/* Fixed-point precision of the impulse */
+#define BLEP_BITS 14
+/* Output amplitude of one volume unit (volume * gain), in 16-bit samples */
+#define BLEP_UNIT 128
+/* Cutoff frequency of the impulse, relative to the Nyquist frequency */
+#define BLEP_CUTOFF 0.75
+/* Time constant of the filter that removes DC from the output, as a power
+   of 2 samples (4096 samples is a cutoff of about 2 Hz at 44100 Hz) */
+#define DC_SHIFT 12
+/* Largest number of samples per channel rendered at once */
+#define BLEP_BUFFER_SIZE 1024
+
+#define M_PI_BLEP 3.14159265358979323846
+
+typedef struct {
+	int period;       /* ticks between underflows, 0 if not clocked */
+	int counter;      /* ticks from the start of the chunk to the next underflow */
+	int out;          /* output of the distortion circuit, 0 or 1 */
+	int level;        /* current contribution to the sound, in volume units */
+	int vol;          /* volume * gain */
+	UBYTE audf;
+	UBYTE audc;
+} Channel;
+
+typedef struct {
+	Channel chan[4];
+	UBYTE audctl;
+	int hp1;          /* high-pass flip-flop of channel 1, clocked by channel 3 */
+	int hp2;          /* high-pass flip-flop of channel 2, clocked by channel 4 */
+	SLONG unit[2];    /* amplitude of one volume unit in each output channel */
+} Chip;
+
+typedef struct {
+	SLONG sum;        /* integrated sound */
+	SLONG dc;         /* DC component of sum */
+	SLONG deltas[BLEP_BUFFER_SIZE + BLEP_WIDTH];
+} Output;
+
+static Chip chips[POKEY_MAXPOKEYS];
+static int num_chips;
+static Output outputs[2];
+static int num_outputs;
+static int bit16;
+
+static SLONG impulse[BLEP_PHASES + 1][BLEP_WIDTH];
+
+static UBYTE poly4[POKEY_POLY4_SIZE];
+static UBYTE poly5[POKEY_POLY5_SIZE];
+static UBYTE poly9[POKEY_POLY9_SIZE];
+static UBYTE poly17[POKEY_POLY17_SIZE];
+/* Positions of the polynomial counters at the start of the chunk */
+static int poly4_pos, poly5_pos, poly9_pos, poly17_pos;
+
+static double samples_per_tick;
+static double ticks_per_sample;
+/* Time of output sample 0 in ticks, relative to the start of the chunk.
+   Always in (-1, 0]. */
+static double sample0_tick;
+
+static void BuildImpulse(void)
+{
+	int phase;
+	for (phase = 0; phase <= BLEP_PHASES; phase++) {
+		double taps[BLEP_WIDTH];
+		double total = 0.0;
+		SLONG sum = 0;
+		int k;
+		for (k = 0; k < BLEP_WIDTH; k++) {
+			/* distance from the centre of the impulse, in samples */
+			double x = k - (BLEP_WIDTH / 2 - 1) - (double) phase / BLEP_PHASES;
+			double u = x / (BLEP_WIDTH / 2);
+			double sinc = x == 0.0 ? 1.0 : sin(M_PI_BLEP * BLEP_CUTOFF * x) / (M_PI_BLEP * BLEP_CUTOFF * x);
+			/* Blackman window */
+			double window = fabs(u) >= 1.0 ? 0.0 : 0.42 + 0.5 * cos(M_PI_BLEP * u) + 0.08 * cos(2 * M_PI_BLEP * u);
+			taps[k] = sinc * window;
+			total += taps[k];
+		}
+		for (k = 0; k < BLEP_WIDTH; k++) {
+			impulse[phase][k] = (SLONG) floor(taps[k] / total * (1 << BLEP_BITS) + 0.5);
+			sum += impulse[phase][k];
+		}
+		/* Each step must add exactly its height, or DC would build up. */
+		impulse[phase][BLEP_WIDTH / 2 - 1] += (1 << BLEP_BITS) - sum;
+	}
+}
+
+/* The same sequences as in mzpokeysnd.c */
+static void BuildPolys(void)
+{
+	int i;
+	unsigned int p;
+	for (i = 0, p = 1; i < POKEY_POLY4_SIZE; i++) {
+		poly4[i] = ~p & 1;
+		p = ((p << 1) & 15) + (((p >> 2) ^ (p >> 3)) & 1);
+	}
+	for (i = 0, p = 1; i < POKEY_POLY5_SIZE; i++) {
+		poly5[i] = ~p & 1;
+		p = ((p << 1) & 31) + (((p >> 2) ^ (p >> 4)) & 1);
+	}
+	for (i = 0, p = 1; i < POKEY_POLY9_SIZE; i++) {
+		poly9[i] = p & 1;
+		p = ((p << 1) & 511) + (((p >> 3) ^ (p >> 8)) & 1);
+	}
+	for (i = 0, p = 1; i < POKEY_POLY17_SIZE; i++) {
+		poly17[i] = p & 1;
+		p = ((p << 1) & 131071) + (((p >> 11) ^ (p >> 16)) & 1);
+	}
+}
+
+/* Adds a change of the sound by DELTA volume units at tick T of the chunk. */
+static void AddStep(Chip *c, int t, int delta)
+{
+	double pos = (t - sample0_tick) * samples_per_tick;
+	int i = (int) pos;
+	double phase = (pos - i) * BLEP_PHASES;
+	int p = (int) phase;
+	int weight = (int) ((phase - p) * 256); /* of impulse p + 1, in 1/256 */
+	SLONG const *imp0 = impulse[p];
+	SLONG const *imp1 = impulse[p + 1];
+	SLONG taps[BLEP_WIDTH];
+	SLONG sum = 0;
+	int k;
+	int o;
+	for (k = 0; k < BLEP_WIDTH; k++) {
+		taps[k] = imp0[k] + (((imp1[k] - imp0[k]) * weight) >> 8);
+		sum += taps[k];
+	}
+	/* The step must have exactly its height, or DC would build up. */
+	taps[BLEP_WIDTH / 2 - 1] += (1 << BLEP_BITS) - sum;
+	for (o = 0; o < num_outputs; o++) {
+		SLONG amp = delta * c->unit[o];
+		SLONG *d = outputs[o].deltas + i;
+		if (amp == 0)
+			continue;
+		for (k = 0; k < BLEP_WIDTH; k++)
+			d[k] += amp * taps[k];
+	}
+}
+
+/* Updates the contribution of channel I to the sound at tick T. */
+static void UpdateLevel(Chip *c, int i, int t)
+{
+	Channel *ch = c->chan + i;
+	int out = ch->out;
+	int level;
+	if (i == POKEY_CHAN1 && (c->audctl & POKEY_CH1_FILTER))
+		out ^= c->hp1;
+	else if (i == POKEY_CHAN2 && (c->audctl & POKEY_CH2_FILTER))
+		out ^= c->hp2;
+	level = (ch->audc & POKEY_VOL_ONLY) || out ? ch->vol : 0;
+	if (level != ch->level) {
+		AddStep(c, t, level - ch->level);
+		ch->level = level;
+	}
+}
+
+/* Handles the underflow of channel I's counter at tick T of the chunk. */
+static void Underflow(Chip *c, int i, int t)
+{
+	Channel *ch = c->chan + i;
+	UBYTE audc = ch->audc;
+	if ((audc & POKEY_NOTPOLY5) || poly5[(poly5_pos + t) % POKEY_POLY5_SIZE]) {
+		if (audc & POKEY_PURETONE)
+			ch->out ^= 1;
+		else if (audc & POKEY_POLY4)
+			ch->out = poly4[(poly4_pos + t) % POKEY_POLY4_SIZE];
+		else if (c->audctl & POKEY_POLY9)
+			ch->out = poly9[(poly9_pos + t) % POKEY_POLY9_SIZE];
+		else
+			ch->out = poly17[(poly17_pos + t) % POKEY_POLY17_SIZE];
+	}
+	if (i == POKEY_CHAN3 && (c->audctl & POKEY_CH1_FILTER)) {
+		c->hp1 = c->chan[POKEY_CHAN1].out;
+		UpdateLevel(c, POKEY_CHAN1, t);
+	}
+	else if (i == POKEY_CHAN4 && (c->audctl & POKEY_CH2_FILTER)) {
+		c->hp2 = c->chan[POKEY_CHAN2].out;
+		UpdateLevel(c, POKEY_CHAN2, t);
+	}
+	UpdateLevel(c, i, t);
+}
+
+/* Runs the counters of chip C for TICKS ticks. */
+static void RunChip(Chip *c, int ticks)
+{
+	int i;
+	for (;;) {
+		int t = ticks;
+		for (i = 0; i < 4; i++)
+			if (c->chan[i].period != 0 && c->chan[i].counter < t)
+				t = c->chan[i].counter;
+		if (t >= ticks)
+			break;
+		for (i = 0; i < 4; i++) {
+			Channel *ch = c->chan + i;
+			if (ch->period != 0 && ch->counter == t) {
+				ch->counter += ch->period;
+				Underflow(c, i, t);
+			}
+		}
+	}
+	for (i = 0; i < 4; i++)
+		if (c->chan[i].period != 0)
+			c->chan[i].counter -= ticks;
+}
+
+/* Recalculates the counter periods of chip C after a register change. */
+static void UpdatePeriods(Chip *c)
+{
+	int base = (c->audctl & POKEY_CLOCK_15) ? POKEY_DIV_15 : POKEY_DIV_64;
+	int periods[4];
+	int i;
+
+	/* As in pokeysnd.c: AUDF + 1 with the 64 or 15 kHz clock, AUDF + 4 with
+	   the 1.79 MHz clock, and AUDF of both channels + 7 when joined. */
+	if (c->audctl & POKEY_CH1_179)
+		periods[POKEY_CHAN1] = c->chan[POKEY_CHAN1].audf + 4;
+	else
+		periods[POKEY_CHAN1] = (c->chan[POKEY_CHAN1].audf + 1) * base;
+	if (!(c->audctl & POKEY_CH1_CH2))
+		periods[POKEY_CHAN2] = (c->chan[POKEY_CHAN2].audf + 1) * base;
+	else if (c->audctl & POKEY_CH1_179)
+		periods[POKEY_CHAN2] = c->chan[POKEY_CHAN2].audf * 256 + c->chan[POKEY_CHAN1].audf + 7;
+	else
+		periods[POKEY_CHAN2] = (c->chan[POKEY_CHAN2].audf * 256 + c->chan[POKEY_CHAN1].audf + 1) * base;
+	if (c->audctl & POKEY_CH3_179)
+		periods[POKEY_CHAN3] = c->chan[POKEY_CHAN3].audf + 4;
+	else
+		periods[POKEY_CHAN3] = (c->chan[POKEY_CHAN3].audf + 1) * base;
+	if (!(c->audctl & POKEY_CH3_CH4))
+		periods[POKEY_CHAN4] = (c->chan[POKEY_CHAN4].audf + 1) * base;
+	else if (c->audctl & POKEY_CH3_179)
+		periods[POKEY_CHAN4] = c->chan[POKEY_CHAN4].audf * 256 + c->chan[POKEY_CHAN3].audf + 7;
+	else
+		periods[POKEY_CHAN4] = (c->chan[POKEY_CHAN4].audf * 256 + c->chan[POKEY_CHAN3].audf + 1) * base;
+
+	for (i = 0; i < 4; i++) {
+		Channel *ch = c->chan + i;
+		/* A silent channel needs no clock, unless it clocks a filter. */
+		if (((ch->audc & POKEY_VOL_ONLY) || ch->vol == 0)
+		    && !(i == POKEY_CHAN3 && (c->audctl & POKEY_CH1_FILTER))
+		    && !(i == POKEY_CHAN4 && (c->audctl & POKEY_CH2_FILTER)))
+			ch->period = 0;
+		else if (ch->period == 0) {
+			ch->period = periods[i];
+			ch->counter = periods[i];
+		}
+		else {
+			ch->period = periods[i];
+			if (ch->counter > periods[i])
+				ch->counter = periods[i];
+		}
+	}
+}
+
+static void Update_pokey_sound_blep(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain)
+{
+	Chip *c = chips + chip;
+	int i;
+	switch (addr & 0x0f) {
+	case POKEY_OFFSET_AUDF1:
+	case POKEY_OFFSET_AUDF2:
+	case POKEY_OFFSET_AUDF3:
+	case POKEY_OFFSET_AUDF4:
+		c->chan[(addr & 0x0f) >> 1].audf = val;
+		break;
+	case POKEY_OFFSET_AUDC1:
+	case POKEY_OFFSET_AUDC2:
+	case POKEY_OFFSET_AUDC3:
+	case POKEY_OFFSET_AUDC4:
+		c->chan[(addr & 0x0f) >> 1].audc = val;
+		c->chan[(addr & 0x0f) >> 1].vol = (val & POKEY_VOLUME_MASK) * gain;
+		break;
+	case POKEY_OFFSET_AUDCTL:
+		c->audctl = val;
+		break;
+	default:
+		return;
+	}
+	UpdatePeriods(c);
+	/* the change is heard from the start of the next chunk */
+	for (i = 0; i < 4; i++)
+		UpdateLevel(c, i, 0);
+}
+
+#ifdef VOL_ONLY_SOUND
+/* Adds a new value of the volume-only sound at cycle TIME. */
+static void SampbufPut(int time)
+{
+	POKEYSND_sampbuf_val[POKEYSND_sampbuf_ptr] = POKEYSND_sampbuf_lastval;
+	POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_ptr] =
+		(time - POKEYSND_sampbuf_last) * 128 * POKEYSND_samp_freq / 178979;
+	POKEYSND_sampbuf_last = time;
+	POKEYSND_sampbuf_ptr++;
+	if (POKEYSND_sampbuf_ptr >= POKEYSND_SAMPBUF_MAX)
+		POKEYSND_sampbuf_ptr = 0;
+	if (POKEYSND_sampbuf_ptr == POKEYSND_sampbuf_rptr) {
+		POKEYSND_sampbuf_rptr++;
+		if (POKEYSND_sampbuf_rptr >= POKEYSND_SAMPBUF_MAX)
+			POKEYSND_sampbuf_rptr = 0;
+	}
+}
+
+/* Moves POKEYSND_sampout to the value of the next output sample. */
+static void SampbufNext(void)
+{
+	int l;
+	if (POKEYSND_sampbuf_rptr == POKEYSND_sampbuf_ptr)
+		return;
+	if (POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr] > 0)
+		POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr] -= 1280;
+	while ((l = POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]) <= 0) {
+		POKEYSND_sampout = POKEYSND_sampbuf_val[POKEYSND_sampbuf_rptr];
+		POKEYSND_sampbuf_rptr++;
+		if (POKEYSND_sampbuf_rptr >= POKEYSND_SAMPBUF_MAX)
+			POKEYSND_sampbuf_rptr = 0;
+		if (POKEYSND_sampbuf_rptr == POKEYSND_sampbuf_ptr)
+			break;
+		POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr] += l;
+	}
+}
+#endif /* VOL_ONLY_SOUND */
+
+#ifdef SERIO_SOUND
+static void Update_serio_sound_blep(int out, UBYTE data)
+{
+#ifdef VOL_ONLY_SOUND
+	int bits, pv, future;
+	if (!POKEYSND_serio_sound_enabled)
+		return;
+
+	pv = 0;
+	future = 0;
+	bits = (data << 1) | 0x200;
+	while (bits) {
+		POKEYSND_sampbuf_lastval -= pv;
+		pv = (bits & 0x01) * chips[0].chan[POKEY_CHAN4].vol;
+		POKEYSND_sampbuf_lastval += pv;
+		SampbufPut(ANTIC_CPU_CLOCK + future);
+		/* 1789790/19200 = 93 */
+		future += 93;	/* ~ 19200 bit/s */
+		bits >>= 1;
+	}
+	POKEYSND_sampbuf_lastval -= pv;
+#endif /* VOL_ONLY_SOUND */
+}
+#endif /* SERIO_SOUND */
+
+#ifdef CONSOLE_SOUND
+static void Update_consol_sound_blep(int set)
+{
+#ifdef VOL_ONLY_SOUND
+	static int prev_atari_speaker = 0;
+	static unsigned int prev_cpu_clock = 0;
+	int d;
+	if (!POKEYSND_console_sound_enabled)
+		return;
+
+	if (!set && POKEYSND_samp_consol_val == 0)
+		return;
+	POKEYSND_sampbuf_lastval -= POKEYSND_samp_consol_val;
+	if (prev_atari_speaker != GTIA_speaker) {
+		POKEYSND_samp_consol_val = GTIA_speaker * 8 * 4;	/* gain */
+		prev_cpu_clock = ANTIC_CPU_CLOCK;
+	}
+	else if (!set) {
+		d = ANTIC_CPU_CLOCK - prev_cpu_clock;
+		if (d < 114) {
+			POKEYSND_sampbuf_lastval += POKEYSND_samp_consol_val;
+			return;
+		}
+		while (d >= 114 /* CPUL */) {
+			POKEYSND_samp_consol_val = POKEYSND_samp_consol_val * 99 / 100;
+			d -= 114;
+		}
+		prev_cpu_clock = ANTIC_CPU_CLOCK - d;
+	}
+	POKEYSND_sampbuf_lastval += POKEYSND_samp_consol_val;
+	prev_atari_speaker = GTIA_speaker;
+	SampbufPut(ANTIC_CPU_CLOCK);
+#endif /* VOL_ONLY_SOUND */
+}
+#endif /* CONSOLE_SOUND */
+
+#ifdef VOL_ONLY_SOUND
+static void Update_vol_only_sound_blep(void)
+{
+#ifdef CONSOLE_SOUND
+	POKEYSND_UpdateConsol(0);
+#endif
+}
+#endif /* VOL_ONLY_SOUND */
+
+/* Emulates all chips for the time of N output samples. */
+static void Render(int n)
+{
+	double end = sample0_tick + n * ticks_per_sample;
+	int ticks = (int) ceil(end);
+	int i;
+	for (i = 0; i < num_chips; i++)
+		RunChip(chips + i, ticks);
+	poly4_pos = (poly4_pos + ticks) % POKEY_POLY4_SIZE;
+	poly5_pos = (poly5_pos + ticks) % POKEY_POLY5_SIZE;
+	poly9_pos = (poly9_pos + ticks) % POKEY_POLY9_SIZE;
+	poly17_pos = (poly17_pos + ticks) % POKEY_POLY17_SIZE;
+	sample0_tick = end - ticks;
+}
+
+static void bleppokeysnd_process(void *sndbuffer, int sndn)
+{
+	UBYTE *buffer8 = (UBYTE *) sndbuffer;
+	SWORD *buffer16 = (SWORD *) sndbuffer;
+	int frames = sndn / num_outputs;
+
+	while (frames > 0) {
+		int n = frames > BLEP_BUFFER_SIZE ? BLEP_BUFFER_SIZE : frames;
+		int s;
+		int i;
+		Render(n);
+		for (s = 0; s < n; s++) {
+#ifdef VOL_ONLY_SOUND
+			SampbufNext();
+#endif
+			for (i = 0; i < num_outputs; i++) {
+				Output *out = outputs + i;
+				SLONG v;
+				out->sum += out->deltas[s];
+				v = out->sum;
+#ifdef VOL_ONLY_SOUND
+				/* heard where the first chip is */
+				v += (SLONG) POKEYSND_sampout * chips[0].unit[i] << BLEP_BITS;
+#endif
+				out->dc += (v - out->dc) >> DC_SHIFT;
+				v = (v - out->dc) >> BLEP_BITS;
+				if (v > 32767)
+					v = 32767;
+				else if (v < -32768)
+					v = -32768;
+				if (bit16)
+					*buffer16++ = (SWORD) v;
+				else
+					*buffer8++ = (UBYTE) ((v >> 8) + 128);
+			}
+		}
+		/* keep the tails of the steps that reach into the next chunk */
+		for (i = 0; i < num_outputs; i++) {
+			SLONG *d = outputs[i].deltas;
+			memmove(d, d + n, BLEP_WIDTH * sizeof(SLONG));
+			memset(d + BLEP_WIDTH, 0, n * sizeof(SLONG));
+		}
+		frames -= n;
+	}
+}
+
+int BLEPPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
+                      int flags)
+{
+	static int tables_built = FALSE;
+	int i;
+	int o;
+	if (!tables_built) {
+		BuildImpulse();
+		BuildPolys();
+		tables_built = TRUE;
+	}
+
+	POKEYSND_Update = Update_pokey_sound_blep;
+#ifdef SERIO_SOUND
+	POKEYSND_UpdateSerio = Update_serio_sound_blep;
+#endif
+#ifdef CONSOLE_SOUND
+	POKEYSND_UpdateConsol = Update_consol_sound_blep;
+#endif
+#ifdef VOL_ONLY_SOUND
+	POKEYSND_UpdateVolOnly = Update_vol_only_sound_blep;
+	POKEYSND_samp_freq = playback_freq;
+#endif
+	POKEYSND_Process_ptr = bleppokeysnd_process;
+
+	memset(chips, 0, sizeof(chips));
+	memset(outputs, 0, sizeof(outputs));
+	num_outputs = num_pokeys;
+	num_chips = POKEYSND_num_chips;
+	for (i = 0; i < num_chips; i++)
+		for (o = 0; o < num_outputs; o++)
+			chips[i].unit[o] = BLEP_UNIT * POKEYSND_PanWeight(i, o) / 256;
+	bit16 = (flags & POKEYSND_BIT16) != 0;
+	samples_per_tick = (double) playback_freq / freq17;
+	ticks_per_sample = (double) freq17 / playback_freq;
+	sample0_tick = 0.0;
+	poly4_pos = poly5_pos = poly9_pos = poly17_pos = 0;
+	return 0; /* OK */
+}
@@ -0,0 +1,14 @@
+#ifndef BLEPPOKEYSND_H_
+#define BLEPPOKEYSND_H_
+
+#include "config.h"
+#include "atari.h"
+
+/* POKEY sound emulation that adds each change of a channel's output to the
+   sound as a band-limited step. Its cost depends on the number of output
+   changes rather than on the number of 1.79 MHz ticks. */
+
+int BLEPPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
+                      int flags);
+
+#endif /* BLEPPOKEYSND_H_ */
@@ -73,6 +73,15 @@ static int cassette_motor = 0;
 int CASSETTE_hold_start_on_reboot = 0;
 int CASSETTE_hold_start = 0;
 int CASSETTE_press_space = 0;
+int CASSETTE_turbo = FALSE;
+int CASSETTE_max_gap = 0;
+
+/* Statistics of the current tape loading, reported when the motor stops.
+   All values are in CPU ticks. */
+static ULONG load_ticks = 0;       /* emulated while the tape was being read */
+static ULONG load_turbo_ticks = 0; /* part of LOAD_TICKS run without syncing to host */
+static ULONG load_gap_ticks = 0;   /* removed from inter-record gaps by CASSETTE_max_gap */
+
 /* Indicates whether the tape has ended. During saving the value is always 0;
    during loading it is equal to (CASSETTE_GetPosition() >= CASSETTE_GetSize()). */
 static int eof_of_tape = 0;
@@ -106,6 +115,18 @@ int CASSETTE_ReadConfig(char *string, char *ptr)
 			return FALSE;
 		CASSETTE_write_protect = value;
 	}
+	else if (strcmp(string, "CASSETTE_TURBO") == 0) {
+		int value = Util_sscanbool(ptr);
+		if (value == -1)
+			return FALSE;
+		CASSETTE_turbo = value;
+	}
+	else if (strcmp(string, "CASSETTE_MAX_GAP") == 0) {
+		int value = Util_sscandec(ptr);
+		if (value == -1)
+			return FALSE;
+		CASSETTE_max_gap = value;
+	}
 	else return FALSE;
 	return TRUE;
 }
@@ -115,6 +136,8 @@ void CASSETTE_WriteConfig(FILE *fp)
 	fprintf(fp, "CASSETTE_FILENAME=%s\n", CASSETTE_filename);
 	fprintf(fp, "CASSETTE_LOADED=%d\n", CASSETTE_status != CASSETTE_STATUS_NONE);
 	fprintf(fp, "CASSETTE_WRITE_PROTECT=%d\n", CASSETTE_write_protect);
+	fprintf(fp, "CASSETTE_TURBO=%d\n", CASSETTE_turbo);
+	fprintf(fp, "CASSETTE_MAX_GAP=%d\n", CASSETTE_max_gap);
 }
 
 int CASSETTE_Initialise(int *argc, char *argv[])
@@ -148,11 +171,28 @@ int CASSETTE_Initialise(int *argc, char *argv[])
 		}
 		else if (strcmp(argv[i], "-tape-readonly") == 0)
 			protect = TRUE;
+		else if (strcmp(argv[i], "-tape-turbo") == 0)
+			CASSETTE_turbo = TRUE;
+		else if (strcmp(argv[i], "-no-tape-turbo") == 0)
+			CASSETTE_turbo = FALSE;
+		else if (strcmp(argv[i], "-tape-maxgap") == 0) {
+			if (i_a) {
+				CASSETTE_max_gap = Util_sscandec(argv[++i]);
+				if (CASSETTE_max_gap < 0) {
+					Log_print("Invalid argument for '-tape-maxgap'");
+					return FALSE;
+				}
+			}
+			else a_m = TRUE;
+		}
 		else {
 			if (strcmp(argv[i], "-help") == 0) {
 				Log_print("\t-tape <file>      Insert cassette image");
 				Log_print("\t-boottape <file>  Insert cassette image and boot it");
 				Log_print("\t-tape-readonly    Mark the attached cassette image as read-only");
+				Log_print("\t-tape-turbo       Run emulation at full speed while loading from tape");
+				Log_print("\t-no-tape-turbo    Load from tape at normal speed");
+				Log_print("\t-tape-maxgap <ms> Shorten gaps between tape records to <ms> (0 = off)");
 			}
 			argv[j++] = argv[i];
 		}
@@ -302,6 +342,21 @@ void CASSETTE_PutByte(int byte)
 		IMG_TAPE_WriteByte(cassette_file, byte, POKEY_AUDF[POKEY_CHAN3] + POKEY_AUDF[POKEY_CHAN4]*0x100);
 }
 
+/* Reports how much real time the fast loading features saved during
+   the last load, and resets the statistics. */
+static void ReportLoad(void)
+{
+	ULONG saved = load_turbo_ticks + load_gap_ticks;
+	if (saved >= 1789790 / 10)
+		Log_print("Tape: %.1f s of tape loaded in about %.1f s, %.1f s saved",
+		          (double) (load_ticks + load_gap_ticks) / 1789790,
+		          (double) (load_ticks - load_turbo_ticks) / 1789790,
+		          (double) saved / 1789790);
+	load_ticks = 0;
+	load_turbo_ticks = 0;
+	load_gap_ticks = 0;
+}
+
 void CASSETTE_TapeMotor(int onoff)
 {
 	if (cassette_motor != onoff) {
@@ -310,9 +365,16 @@ void CASSETTE_TapeMotor(int onoff)
 			IMG_TAPE_Flush(cassette_file);
 		cassette_motor = onoff;
 		UpdateFlags();
+		if (!onoff)
+			ReportLoad();
 	}
 }
 
+int CASSETTE_Turbo(void)
+{
+	return CASSETTE_turbo && cassette_readable && !CASSETTE_record;
+}
+
 int CASSETTE_ToggleWriteProtect(void)
 {
 	if (CASSETTE_status != CASSETTE_STATUS_READ_WRITE)
@@ -353,6 +415,9 @@ static int CassetteRead(int num_ticks)
 {
 	if (cassette_readable) {
 		int loaded = FALSE; /* Function's return value */
+		load_ticks += num_ticks;
+		if (CASSETTE_turbo || Atari800_turbo)
+			load_turbo_ticks += num_ticks;
 		event_time_left -= num_ticks;
 		while (event_time_left < 0) {
 			unsigned int length;
@@ -371,6 +436,15 @@ static int CassetteRead(int num_ticks)
 				return loaded;
 			}
 
+			if (passing_gap && CASSETTE_max_gap > 0) {
+				/* Shorten the gap, but leave enough mark tone for the
+				   loader to synchronise. */
+				unsigned int max_length = CASSETTE_max_gap * 1789 + CASSETTE_max_gap * 790 / 1000;
+				if (length > max_length) {
+					load_gap_ticks += length - max_length;
+					length = max_length;
+				}
+			}
 			event_time_left += length;
 		}
 		return loaded;
@@ -35,6 +35,17 @@ extern int CASSETTE_hold_start;
 extern int CASSETTE_hold_start_on_reboot; /* preserve hold_start after reboot */
 extern int CASSETTE_press_space;
 
+/* Run the emulation at full speed while a tape is being read. */
+extern int CASSETTE_turbo;
+/* Maximum length of an inter-record gap while reading, in ms; longer gaps
+   are shortened. 0 means no limit. */
+extern int CASSETTE_max_gap;
+/* Returns TRUE if emulation should not be synchronised to the host because
+   CASSETTE_turbo is on and the tape is being read. Like Atari800_turbo,
+   this skips both Atari800_Sync() and the wait for room in the sound
+   output. */
+int CASSETTE_Turbo(void);
+
 /* Is cassette file write-protected? Don't change directly, use CASSETTE_ToggleWriteProtect(). */
 extern int CASSETTE_write_protect;
 /* Switches RO/RW. Fails with FALSE if the tape cannot be switched to RW. */
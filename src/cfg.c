@@ -192,11 +192,29 @@ int CFG_LoadConfig(const char *alternate_config_filename)
 #ifndef SYNCHRONIZED_SOUND
 				POKEYSND_enable_new_pokey = Util_sscanbool(ptr);
 #endif /* SYNCHRONIZED_SOUND */
+#endif /* SOUND */
+			}
+			else if (strcmp(string, "ENABLE_BLEP_POKEY") == 0) {
+#ifdef SOUND
+#ifndef SYNCHRONIZED_SOUND
+				POKEYSND_enable_blep_pokey = Util_sscanbool(ptr);
+#endif /* SYNCHRONIZED_SOUND */
 #endif /* SOUND */
 			}
 			else if (strcmp(string, "STEREO_POKEY") == 0) {
 #ifdef STEREO_SOUND
 				POKEYSND_stereo_enabled = Util_sscanbool(ptr);
+#endif
+			}
+			else if (strcmp(string, "QUAD_POKEY") == 0) {
+#ifdef STEREO_SOUND
+				POKEYSND_quad_enabled = Util_sscanbool(ptr);
+#endif
+			}
+			else if (strcmp(string, "POKEY_PANNING") == 0) {
+#ifdef STEREO_SOUND
+				if (!POKEYSND_SetPanning(ptr))
+					Log_print("Invalid POKEY panning: %s", ptr);
 #endif
 			}
 			else if (strcmp(string, "SPEAKER_SOUND") == 0) {
@@ -338,6 +356,9 @@ int CFG_WriteConfig(void)
 {
 	FILE *fp;
 	int i;
+#ifdef STEREO_SOUND
+	char panning[POKEY_MAXPOKEYS * 5];
+#endif
 	static const char * const machine_type_string[Atari800_MACHINE_SIZE] = {
 		"400/800", "XL/XE", "5200"
 	};
@@ -401,9 +422,13 @@ int CFG_WriteConfig(void)
 #ifdef SOUND
 #ifndef SYNCHRONIZED_SOUND
 	fprintf(fp, "ENABLE_NEW_POKEY=%d\n", POKEYSND_enable_new_pokey);
+	fprintf(fp, "ENABLE_BLEP_POKEY=%d\n", POKEYSND_enable_blep_pokey);
 #endif /* SYNCHRONIZED_SOUND */
 #ifdef STEREO_SOUND
 	fprintf(fp, "STEREO_POKEY=%d\n", POKEYSND_stereo_enabled);
+	fprintf(fp, "QUAD_POKEY=%d\n", POKEYSND_quad_enabled);
+	POKEYSND_GetPanning(panning);
+	fprintf(fp, "POKEY_PANNING=%s\n", panning);
 #endif
 #ifdef CONSOLE_SOUND
 	fprintf(fp, "SPEAKER_SOUND=%d\n", POKEYSND_console_sound_enabled);
@@ -33,6 +33,7 @@
 #include "afile.h"
 #include "atari.h"
 #include "compfile.h"
+#include "img_disk.h"
 #include "log.h"
 #include "util.h"
 
@@ -104,25 +105,8 @@ typedef struct {
 
 static int write_atr_header(const ATR_Info *pai)
 {
-	int sectorcount;
-	int sectorsize;
-	ULONG paras;
-	struct AFILE_ATR_Header header;
-	sectorcount = pai->sectorcount;
-	sectorsize = pai->sectorsize;
-	paras = (sectorsize != 256 || sectorcount <= 3)
-		? (sectorcount << 3) /* single density or only boot sectors: sectorcount * 128 / 16 */
-		: (sectorcount << 4) - 0x18; /* double density with 128-byte boot sectors: (sectorcount * 256 - 3 * 128) / 16 */
-	memset(&header, 0, sizeof(header));
-	header.magic1 = AFILE_ATR_MAGIC1;
-	header.magic2 = AFILE_ATR_MAGIC2;
-	header.secsizelo = (UBYTE) sectorsize;
-	header.secsizehi = (UBYTE) (sectorsize >> 8);
-	header.seccountlo = (UBYTE) paras;
-	header.seccounthi = (UBYTE) (paras >> 8);
-	header.hiseccountlo = (UBYTE) (paras >> 16);
-	header.hiseccounthi = (UBYTE) (paras >> 24);
-	return fsave(&header, sizeof(header), pai->fp);
+	/* DCM archives always store 128-byte boot sectors */
+	return IMG_DISK_WriteATRHeader(pai->fp, pai->sectorsize, pai->sectorcount, 128);
 }
 
 static int write_atr_sector(ATR_Info *pai, UBYTE *buf)
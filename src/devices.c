@@ -50,6 +50,10 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 #ifdef HAVE_DIRECT_H
 /* WIN32 */
 #include <direct.h> /* mkdir, rmdir */
@@ -75,6 +79,9 @@
 #ifdef R_IO_DEVICE
 #include "rdevice.h"
 #endif
+#ifdef AVI_RECORDING
+#include "avirec.h"
+#endif
 #ifdef __PLUS
 #include "misc_win.h"
 #endif
@@ -632,9 +639,12 @@ int Devices_Initialise(int *argc, char *argv[])
 	return TRUE;
 }
 
+static void Devices_P_Exit(void);
+
 void Devices_Exit(void)
 {
 	Devices_H_CloseAll();
+	Devices_P_Exit();
 }
 
 #define IS_DIR_SEP(c) ((c) == '/' || (c) == '\\' || (c) == ':' || (c) == '>')
@@ -1856,9 +1866,108 @@ int Devices_SetPrintCommand(const char *command)
 
 #ifdef HAVE_SYSTEM
 
+#if defined(HAVE_FORK) && defined(HAVE_WAITPID) && defined(HAVE_SYS_WAIT_H) && !defined(__PLUS)
+/* Closed spool files are queued and printed by a child process, so that
+   a slow print command doesn't stop the emulation. */
+#define ASYNC_PRINT
+#endif
+
 static FILE *phf = NULL;
 static char spool_file[FILENAME_MAX];
 
+#ifndef ASYNC_PRINT
+/* Prints a closed spool file synchronously. */
+static void PrintSpoolFile(const char *filename)
+{
+	char command[256 + FILENAME_MAX]; /* 256 for Devices_print_command + FILENAME_MAX for spool_file */
+	int retval;
+	sprintf(command, Devices_print_command, filename);
+	if ((retval = system(command)) == -1)
+		Log_print("Print command \"%s\' failed", command);
+#if defined(HAVE_UTIL_UNLINK) && !defined(VMS) && !defined(MACOSX)
+	if (Util_unlink(filename) != 0) {
+		perror(filename);
+	}
+#endif
+}
+
+#else /* ASYNC_PRINT */
+
+typedef struct print_job_t {
+	char spool_file[FILENAME_MAX];
+	char command[256 + FILENAME_MAX];
+	struct print_job_t *next;
+} print_job_t;
+
+/* Jobs waiting for printing; the head is being printed if print_pid != 0. */
+static print_job_t *print_queue_head = NULL;
+static print_job_t *print_queue_tail = NULL;
+static pid_t print_pid = 0;
+
+/* Starts the print command for the job at the head of the queue.
+   Returns FALSE if it was run synchronously instead, then stores in *FAILED
+   whether it could not be run. */
+static int StartPrintJob(int *failed)
+{
+	print_pid = fork();
+	if (print_pid == 0) {
+#ifdef AVI_RECORDING
+		AVIRec_CloseInChild();
+#endif
+		execl("/bin/sh", "sh", "-c", print_queue_head->command, (char *) NULL);
+		_exit(127);
+	}
+	if (print_pid < 0) {
+		/* no process available - print synchronously */
+		print_pid = 0;
+		*failed = system(print_queue_head->command) == -1;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* Removes a finished job from the head of the queue and its spool file. */
+static void FinishPrintJob(int failed)
+{
+	print_job_t *job = print_queue_head;
+	if (failed)
+		Log_print("Print command \"%s\" failed", job->command);
+#if defined(HAVE_UTIL_UNLINK) && !defined(VMS) && !defined(MACOSX)
+	if (Util_unlink(job->spool_file) != 0) {
+		perror(job->spool_file);
+	}
+#endif
+	print_queue_head = job->next;
+	if (print_queue_head == NULL)
+		print_queue_tail = NULL;
+	free(job);
+	print_pid = 0;
+}
+
+/* Reaps the running print command and starts the next one.
+   If WAIT is TRUE, blocks until the queue is empty. */
+static void UpdatePrintQueue(int wait)
+{
+	while (print_queue_head != NULL) {
+		int failed;
+		if (print_pid == 0 && !StartPrintJob(&failed)) {
+			/* printed synchronously */
+			FinishPrintJob(failed);
+			continue;
+		}
+		{
+			int status;
+			pid_t pid = waitpid(print_pid, &status, wait ? 0 : WNOHANG);
+			if (pid == 0)
+				return; /* still printing */
+			/* if the child was lost, don't wait forever */
+			FinishPrintJob(pid > 0 && (!WIFEXITED(status) || WEXITSTATUS(status) == 127));
+		}
+	}
+}
+
+#endif /* ASYNC_PRINT */
+
 static void Devices_P_Close(void)
 {
 	if (devbug)
@@ -1872,15 +1981,19 @@ static void Devices_P_Close(void)
 		if (!Misc_ExecutePrintCmd(spool_file))
 #endif
 		{
-			char command[256 + FILENAME_MAX]; /* 256 for Devices_print_command + FILENAME_MAX for spool_file */
-			int retval;
-			sprintf(command, Devices_print_command, spool_file);
-			if ((retval = system(command)) == -1)
-				Log_print("Print command \"%s\' failed", command);
-#if defined(HAVE_UTIL_UNLINK) && !defined(VMS) && !defined(MACOSX)
-			if (Util_unlink(spool_file) != 0) {
-				perror(spool_file);
-			}
+#ifdef ASYNC_PRINT
+			print_job_t *job = (print_job_t *) Util_malloc(sizeof(print_job_t));
+			strcpy(job->spool_file, spool_file);
+			sprintf(job->command, Devices_print_command, spool_file);
+			job->next = NULL;
+			if (print_queue_tail != NULL)
+				print_queue_tail->next = job;
+			else
+				print_queue_head = job;
+			print_queue_tail = job;
+			UpdatePrintQueue(FALSE);
+#else
+			PrintSpoolFile(spool_file);
 #endif
 		}
 	}
@@ -1945,6 +2058,20 @@ static void Devices_P_Init(void)
 	CPU_ClrN;
 }
 
+/* Prints the pending spool files before exit. */
+static void Devices_P_Exit(void)
+{
+#ifdef ASYNC_PRINT
+	UpdatePrintQueue(TRUE);
+#endif
+}
+
+#else /* HAVE_SYSTEM */
+
+static void Devices_P_Exit(void)
+{
+}
+
 #endif /* HAVE_SYSTEM */
 
 
@@ -2586,6 +2713,11 @@ static UWORD b_entry_address = 0;
 
 void Devices_Frame(void)
 {
+#ifdef ASYNC_PRINT
+	if (print_pid != 0)
+		UpdatePrintQueue(FALSE);
+#endif
+
 	if (Devices_enable_h_patch)
 		h_entry_address = Devices_UpdateHATABSEntry('H', h_entry_address, H_TABLE_ADDRESS);
 
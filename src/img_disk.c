@@ -0,0 +1,393 @@
+/*
+ * img_disk.c - support for ATR, XFD, DCM, PRO and ATX disk images
+ *
+ * Copyright (C) 1995-1998 David Firth
+ * Copyright (C) 1998-2013 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "afile.h"
+#include "atari.h"
+#include "compfile.h"
+#include "img_disk.h"
+#include "log.h"
+#include "util.h"
+
+#undef DEBUG_VAPI
+
+/* VAPI Format Header */
+typedef struct tagvapi_file_header_t {
+	unsigned char signature[4];
+	unsigned char majorver;
+	unsigned char minorver;
+	unsigned char reserved1[22];
+	unsigned char startdata[4];
+	unsigned char reserved[16];
+} vapi_file_header_t;
+
+typedef struct tagvapi_track_header_t {
+	unsigned char  next[4];
+	unsigned char  type[2];
+	unsigned char  reserved1[2];
+	unsigned char  tracknum;
+	unsigned char  reserved2;
+	unsigned char  sectorcnt[2];
+	unsigned char  reserved3[8];
+	unsigned char  startdata[4];
+	unsigned char  reserved4[8];
+} vapi_track_header_t;
+
+typedef struct tagvapi_sector_list_header_t {
+	unsigned char  sizelist[4];
+	unsigned char  type;
+	unsigned char  reserved[3];
+} vapi_sector_list_header_t;
+
+typedef struct tagvapi_sector_header_t {
+	unsigned char  sectornum;
+	unsigned char  sectorstatus;
+	unsigned char  sectorpos[2];
+	unsigned char  startdata[4];
+} vapi_sector_header_t;
+
+#define VAPI_32(x) (x[0] + (x[1] << 8) + (x[2] << 16) + (x[3] << 24))
+#define VAPI_16(x) (x[0] + (x[1] << 8))
+
+/* Reads the track and sector lists of a VAPI image. */
+static int ParseVAPI(FILE *f, IMG_DISK_Info *info)
+{
+	int file_length = Util_flen(f);
+	vapi_file_header_t fileheader;
+	vapi_track_header_t trackheader;
+	int trackoffset;
+
+	info->type = IMG_DISK_TYPE_VAPI;
+	info->sectorsize = 128;
+	info->sectorcount = 720;
+	fseek(f,0,SEEK_SET);
+	if (fread(&fileheader,1,sizeof(fileheader),f) != sizeof(fileheader)) {
+		Log_print("VAPI: Bad File Header");
+		return(FALSE);
+		}
+	trackoffset = VAPI_32(fileheader.startdata);
+	if (trackoffset > file_length) {
+		Log_print("VAPI: Bad Track Offset");
+		return(FALSE);
+		}
+#ifdef DEBUG_VAPI
+	Log_print("VAPI File Version %d.%d",fileheader.majorver,fileheader.minorver);
+#endif
+
+	info->vapi_sectors = Util_malloc(info->sectorcount * sizeof(IMG_DISK_VAPISector));
+	memset(info->vapi_sectors, 0, info->sectorcount * sizeof(IMG_DISK_VAPISector));
+
+	/* Now read all the sector data */
+	while (trackoffset > 0 && trackoffset < file_length) {
+		int sectorcnt, seclistdata,next;
+		vapi_sector_list_header_t sectorlist;
+		vapi_sector_header_t sectorheader;
+		IMG_DISK_VAPISector *sector;
+		UWORD tracktype;
+		int j;
+
+		fseek(f,trackoffset,SEEK_SET);
+		if (fread(&trackheader,1,sizeof(trackheader),f) != sizeof(trackheader)) {
+			Log_print("VAPI: Bad Track Header while reading sectors");
+			return(FALSE);
+			}
+		next = VAPI_32(trackheader.next);
+		sectorcnt = VAPI_16(trackheader.sectorcnt);
+		tracktype = VAPI_16(trackheader.type);
+		seclistdata = VAPI_32(trackheader.startdata) + trackoffset;
+#ifdef DEBUG_VAPI
+		Log_print("Track %d: next %x type %d seccnt %d secdata %x",trackheader.tracknum,
+			trackoffset + next,VAPI_16(trackheader.type),sectorcnt,seclistdata);
+#endif
+		if (tracktype == 0) {
+			if (seclistdata > file_length) {
+				Log_print("VAPI: Bad Sector List Offset");
+				return(FALSE);
+				}
+			fseek(f,seclistdata,SEEK_SET);
+			if (fread(&sectorlist,1,sizeof(sectorlist),f) != sizeof(sectorlist)) {
+				Log_print("VAPI: Bad Sector List");
+				return(FALSE);
+				}
+#ifdef DEBUG_VAPI
+			Log_print("Size sec list %x type %d",VAPI_32(sectorlist.sizelist),sectorlist.type);
+#endif
+			for (j=0;j<sectorcnt;j++) {
+				double percent_rot;
+
+				if (fread(&sectorheader,1,sizeof(sectorheader),f) != sizeof(sectorheader)) {
+					Log_print("VAPI: Bad Sector Header");
+					return(FALSE);
+					}
+				if (sectorheader.sectornum > 18 || sectorheader.sectornum == 0
+				    || trackheader.tracknum >= info->sectorcount / 18)  {
+					Log_print("VAPI: Bad Sector Index: Track %d Sec Num %d Index %d",
+							trackheader.tracknum,j,sectorheader.sectornum);
+					return(FALSE);
+					}
+				sector = &info->vapi_sectors[trackheader.tracknum * 18 + sectorheader.sectornum - 1];
+				if (sector->sec_count >= IMG_DISK_MAX_VAPI_PHANTOM_SEC) {
+					Log_print("VAPI: Too many Phantom Sectors");
+					return(FALSE);
+					}
+
+				percent_rot = ((double) VAPI_16(sectorheader.sectorpos))/IMG_DISK_VAPI_BYTES_PER_TRACK;
+				sector->sec_rot_pos[sector->sec_count] = (unsigned int) (percent_rot * IMG_DISK_VAPI_CYCLES_PER_ROT);
+				sector->sec_offset[sector->sec_count] = VAPI_32(sectorheader.startdata) + trackoffset;
+				sector->sec_status[sector->sec_count] = ~sectorheader.sectorstatus;
+				sector->sec_count++;
+#ifdef DEBUG_VAPI
+				Log_print("Sector %d status %x position %f %d %d data %x",sectorheader.sectornum,
+					sector->sec_status[sector->sec_count-1],percent_rot,
+					sector->sec_rot_pos[sector->sec_count-1],
+					VAPI_16(sectorheader.sectorpos),
+					sector->sec_offset[sector->sec_count-1]);
+#endif
+			}
+#ifdef DEBUG_VAPI
+			Log_flushlog();
+#endif
+		} else {
+			Log_print("Unknown VAPI track type Track:%d Type:%d",trackheader.tracknum,tracktype);
+		}
+		if (next <= 0)
+			break;
+		trackoffset += next;
+	}
+	return TRUE;
+}
+
+int IMG_DISK_IsCompressed(struct AFILE_ATR_Header const *header)
+{
+	return header->magic1 == 0xf9 || header->magic1 == 0xfa
+	    || (header->magic1 == 0x1f && header->magic2 == 0x8b);
+}
+
+int IMG_DISK_Uncompress(FILE *f, char const *filename, FILE *outfp)
+{
+	int magic1 = fgetc(f);
+	Util_rewind(f);
+	if (magic1 == 0xf9 || magic1 == 0xfa)
+		/* DCM */
+		return CompFile_DCMtoATR(f, outfp);
+	/* ATZ/ATR.GZ, XFZ/XFD.GZ */
+	return CompFile_ExtractGZ(filename, outfp);
+}
+
+int IMG_DISK_ParseHeader(FILE *f, struct AFILE_ATR_Header const *header, IMG_DISK_Info *info)
+{
+	memset(info, 0, sizeof(IMG_DISK_Info));
+	info->boot_sectors_type = IMG_DISK_BOOT_SECTORS_LOGICAL;
+
+	if (header->magic1 == AFILE_ATR_MAGIC1 && header->magic2 == AFILE_ATR_MAGIC2) {
+		/* ATR (may be temporary from DCM or ATR/ATR.GZ) */
+		info->type = IMG_DISK_TYPE_ATR;
+
+		info->sectorsize = (header->secsizehi << 8) + header->secsizelo;
+		if (info->sectorsize != 128 && info->sectorsize != 256)
+			return FALSE;
+
+		info->writeprotect = header->writeprotect != 0;
+
+		/* ATR header contains length in 16-byte chunks. */
+		/* First compute number of 128-byte chunks
+		   - it's number of sectors on single density disk */
+		info->sectorcount = ((header->hiseccounthi << 24)
+			+ (header->hiseccountlo << 16)
+			+ (header->seccounthi << 8)
+			+ header->seccountlo) >> 3;
+
+		/* Fix number of sectors if double density */
+		if (info->sectorsize == 256) {
+			if ((info->sectorcount & 1) != 0)
+				/* logical (128-byte) boot sectors */
+				info->sectorcount += 3;
+			else {
+				/* 256-byte boot sectors */
+				/* check if physical or SIO2PC: physical if there's
+				   a non-zero byte in bytes 0x190-0x30f of the ATR file */
+				UBYTE buffer[0x180];
+				int i;
+				fseek(f, 0x190, SEEK_SET);
+				if (fread(buffer, 1, 0x180, f) != 0x180)
+					return FALSE;
+				info->boot_sectors_type = IMG_DISK_BOOT_SECTORS_SIO2PC;
+				for (i = 0; i < 0x180; i++)
+					if (buffer[i] != 0) {
+						info->boot_sectors_type = IMG_DISK_BOOT_SECTORS_PHYSICAL;
+						break;
+					}
+			}
+			info->sectorcount >>= 1;
+		}
+	}
+	else if (header->magic1 == 'A' && header->magic2 == 'T' && header->seccountlo == '8' &&
+		 header->seccounthi == 'X') {
+		if (!ParseVAPI(f, info)) {
+			IMG_DISK_FreeInfo(info);
+			return FALSE;
+		}
+	}
+	else {
+		int file_length = Util_flen(f);
+		/* check for PRO */
+		if ((file_length-16)%(128+12) == 0 &&
+				(header->magic1*256 + header->magic2 == (file_length-16)/(128+12)) &&
+				header->seccountlo == 'P') {
+			info->type = IMG_DISK_TYPE_PRO;
+			info->sectorsize = 128;
+			if (file_length >= 1040*(128+12)+16) {
+				/* assume enhanced density */
+				info->sectorcount = 1040;
+			}
+			else {
+				/* assume single density */
+				info->sectorcount = 720;
+			}
+			info->pro_max_sector = (file_length-16)/(128+12);
+		}
+		else {
+			/* XFD (may be temporary from XFZ/XFD.GZ) */
+
+			info->type = IMG_DISK_TYPE_XFD;
+
+			if (file_length <= (1040 * 128)) {
+				/* single density */
+				info->sectorsize = 128;
+				info->sectorcount = file_length >> 7;
+			}
+			else {
+				/* double density */
+				info->sectorsize = 256;
+				if ((file_length & 0xff) == 0) {
+					info->boot_sectors_type = IMG_DISK_BOOT_SECTORS_PHYSICAL;
+					info->sectorcount = file_length >> 8;
+				}
+				else
+					info->sectorcount = (file_length + 0x180) >> 8;
+			}
+		}
+	}
+	return TRUE;
+}
+
+void IMG_DISK_FreeInfo(IMG_DISK_Info *info)
+{
+	free(info->vapi_sectors);
+	info->vapi_sectors = NULL;
+}
+
+void IMG_DISK_SizeOfSector(IMG_DISK_Info const *info, int sector, int *sz, ULONG *ofs)
+{
+	int size;
+	ULONG offset;
+	int header_size = (info->type == IMG_DISK_TYPE_ATR ? 16 : 0);
+
+	if (info->type == IMG_DISK_TYPE_PRO) {
+		size = 128;
+		offset = 16 + (128+12)*(sector -1); /* returns offset of header */
+	}
+	else if (info->type == IMG_DISK_TYPE_VAPI) {
+		size = 128;
+		if (info->vapi_sectors == NULL)
+			offset = 0;
+		else if (sector > info->sectorcount)
+			offset = 0;
+		else {
+			IMG_DISK_VAPISector const *secinfo = &info->vapi_sectors[sector-1];
+			if (secinfo->sec_count == 0  )
+				offset = 0;
+			else
+				offset = secinfo->sec_offset[0];
+		}
+	}
+	else if (sector < 4) {
+		/* special case for first three sectors in ATR and XFD image */
+		size = 128;
+		offset = header_size + (sector - 1) * (info->boot_sectors_type == IMG_DISK_BOOT_SECTORS_PHYSICAL ? 256 : 128);
+	}
+	else {
+		size = info->sectorsize;
+		offset = header_size + (info->boot_sectors_type == IMG_DISK_BOOT_SECTORS_LOGICAL ? 0x180 : 0x300) + (sector - 4) * size;
+	}
+
+	if (sz)
+		*sz = size;
+
+	if (ofs)
+		*ofs = offset;
+}
+
+int IMG_DISK_ReadSector(FILE *f, IMG_DISK_Info const *info, int sector, UBYTE *buffer)
+{
+	int size;
+	ULONG offset;
+	int result = IMG_DISK_SECTOR_OK;
+
+	if (sector <= 0 || sector > info->sectorcount)
+		return IMG_DISK_SECTOR_ERROR;
+	IMG_DISK_SizeOfSector(info, sector, &size, &offset);
+	if (info->type == IMG_DISK_TYPE_PRO) {
+		UBYTE header[12];
+		if (fseek(f, offset, SEEK_SET) != 0 || fread(header, 1, 12, f) != 12)
+			return IMG_DISK_SECTOR_ERROR;
+		if (header[1] != 0xff)
+			result = IMG_DISK_SECTOR_BAD;
+	}
+	else if (info->type == IMG_DISK_TYPE_VAPI) {
+		IMG_DISK_VAPISector const *secinfo = &info->vapi_sectors[sector - 1];
+		if (secinfo->sec_count == 0)
+			return IMG_DISK_SECTOR_MISSING;
+		if (secinfo->sec_status[0] != 0xff)
+			result = IMG_DISK_SECTOR_BAD;
+		if (fseek(f, offset, SEEK_SET) != 0)
+			return IMG_DISK_SECTOR_ERROR;
+	}
+	else if (fseek(f, offset, SEEK_SET) != 0)
+		return IMG_DISK_SECTOR_ERROR;
+	if ((int) fread(buffer, 1, size, f) != size)
+		return IMG_DISK_SECTOR_ERROR;
+	return result;
+}
+
+int IMG_DISK_WriteATRHeader(FILE *f, int sectorsize, int sectorcount, int bootsectsize)
+{
+	struct AFILE_ATR_Header header;
+	int bootsectcount = sectorcount < 3 ? sectorcount : 3;
+	ULONG paras = ((ULONG) bootsectsize * bootsectcount + (ULONG) sectorsize * (sectorcount - bootsectcount)) >> 4;
+	memset(&header, 0, sizeof(header));
+	header.magic1 = AFILE_ATR_MAGIC1;
+	header.magic2 = AFILE_ATR_MAGIC2;
+	header.secsizelo = (UBYTE) sectorsize;
+	header.secsizehi = (UBYTE) (sectorsize >> 8);
+	header.seccountlo = (UBYTE) paras;
+	header.seccounthi = (UBYTE) (paras >> 8);
+	header.hiseccountlo = (UBYTE) (paras >> 16);
+	header.hiseccounthi = (UBYTE) (paras >> 24);
+	return fwrite(&header, 1, sizeof(header), f) == sizeof(header);
+}
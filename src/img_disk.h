@@ -0,0 +1,121 @@
+/*
+ * img_disk.h - support for ATR, XFD, DCM, PRO and ATX disk images
+ *
+ * Copyright (C) 1995-1998 David Firth
+ * Copyright (C) 1998-2013 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef IMG_DISK_H_
+#define IMG_DISK_H_
+
+#include <stdio.h>
+
+#include "atari.h"
+#include "afile.h"
+
+/* This module holds the knowledge about the layout of disk image files.
+   It does not depend on the emulated machine, so it is shared by sio.c
+   and by the stand-alone util/diskimg tool. */
+
+/* Image types */
+#define IMG_DISK_TYPE_XFD  0
+#define IMG_DISK_TYPE_ATR  1
+#define IMG_DISK_TYPE_PRO  2
+#define IMG_DISK_TYPE_VAPI 3
+
+/* If ATR image is in double density (256 bytes per sector),
+   then the boot sectors (sectors 1-3) can be:
+   - logical (as seen by Atari) - 128 bytes in each sector
+   - physical (as stored on the disk) - 256 bytes in each sector.
+     Only the first half of sector is used for storing data, the rest is zero.
+   - SIO2PC (the type used by the SIO2PC program) - 3 * 128 bytes for data
+     of boot sectors, then 3 * 128 unused bytes (zero)
+   The XFD images in double density have either logical or physical
+   boot sectors. */
+#define IMG_DISK_BOOT_SECTORS_LOGICAL  0
+#define IMG_DISK_BOOT_SECTORS_PHYSICAL 1
+#define IMG_DISK_BOOT_SECTORS_SIO2PC   2
+
+/* Sector layout of a VAPI (ATX) image: every sector may be stored several
+   times ("phantom" sectors), each copy with its own FDC status and angular
+   position on the track. */
+#define IMG_DISK_MAX_VAPI_PHANTOM_SEC 40
+#define IMG_DISK_VAPI_BYTES_PER_TRACK 26042.0
+#define IMG_DISK_VAPI_CYCLES_PER_ROT  372706
+
+typedef struct IMG_DISK_VAPISector {
+	int sec_count;
+	unsigned int sec_offset[IMG_DISK_MAX_VAPI_PHANTOM_SEC];
+	unsigned char sec_status[IMG_DISK_MAX_VAPI_PHANTOM_SEC];
+	unsigned int sec_rot_pos[IMG_DISK_MAX_VAPI_PHANTOM_SEC];
+} IMG_DISK_VAPISector;
+
+/* Geometry of an opened (uncompressed) disk image. */
+typedef struct IMG_DISK_Info {
+	int type;                /* One of IMG_DISK_TYPE_* */
+	int sectorsize;          /* 128 or 256 */
+	int sectorcount;         /* Number of logical sectors */
+	int boot_sectors_type;   /* One of IMG_DISK_BOOT_SECTORS_* */
+	int writeprotect;        /* ATR header has the write protect flag set */
+	int pro_max_sector;      /* PRO: number of sector slots in the file, including duplicates */
+	IMG_DISK_VAPISector *vapi_sectors; /* ATX: SECTORCOUNT entries, owned by this structure */
+} IMG_DISK_Info;
+
+/* Return values of IMG_DISK_ReadSector(). */
+#define IMG_DISK_SECTOR_OK      0
+#define IMG_DISK_SECTOR_BAD     1 /* Stored with a bad FDC status (PRO, ATX) */
+#define IMG_DISK_SECTOR_MISSING 2 /* Not present in the image (ATX) */
+#define IMG_DISK_SECTOR_ERROR   3 /* Read error or truncated image */
+
+/* Returns TRUE if HEADER (the first 16 bytes of a file) starts a DCM or
+   a GZIP compressed image, which has to be passed to IMG_DISK_Uncompress()
+   before it can be used. */
+int IMG_DISK_IsCompressed(struct AFILE_ATR_Header const *header);
+
+/* Uncompresses a DCM or GZIP compressed image open as F (and named FILENAME)
+   into OUTFP. The result is an ATR or XFD image.
+   Returns TRUE on success. */
+int IMG_DISK_Uncompress(FILE *f, char const *filename, FILE *outfp);
+
+/* Detects type and geometry of an uncompressed image F whose first 16 bytes
+   are given in HEADER, and fills *INFO. Changes the file position.
+   Returns TRUE on success or FALSE if the image is malformed.
+   On success, INFO must be later released with IMG_DISK_FreeInfo(). */
+int IMG_DISK_ParseHeader(FILE *f, struct AFILE_ATR_Header const *header, IMG_DISK_Info *info);
+
+/* Releases memory allocated by IMG_DISK_ParseHeader(). */
+void IMG_DISK_FreeInfo(IMG_DISK_Info *info);
+
+/* Stores size of a given SECTOR in *SZ and its offset within the image file
+   in *OFS. Either pointer may be NULL. For PRO images, the offset is that
+   of the 12-byte sector header; for ATX images, of the first copy of the
+   sector (0 if it is missing). */
+void IMG_DISK_SizeOfSector(IMG_DISK_Info const *info, int sector, int *sz, ULONG *ofs);
+
+/* Reads the first stored copy of a SECTOR into BUFFER, ignoring any
+   copy-protection timing. Returns one of IMG_DISK_SECTOR_*; BUFFER is
+   filled for IMG_DISK_SECTOR_OK and IMG_DISK_SECTOR_BAD. */
+int IMG_DISK_ReadSector(FILE *f, IMG_DISK_Info const *info, int sector, UBYTE *buffer);
+
+/* Writes a 16-byte ATR header for an image with SECTORCOUNT sectors of
+   SECTORSIZE bytes and boot sectors of BOOTSECTSIZE (128 or 256) bytes.
+   Returns TRUE on success. */
+int IMG_DISK_WriteATRHeader(FILE *f, int sectorsize, int sectorcount, int bootsectsize);
+
+#endif /* IMG_DISK_H_ */
@@ -44,8 +44,12 @@
 #ifdef __PLUS
 #include "input_win.h"
 #endif
+#ifdef SHM_EXPORT
+#include "shmexport.h"
+#endif
 #ifdef EVENT_RECORDING
 #include <zlib.h>
+#include "statesav.h"
 #endif
 
 #ifdef DREAMCAST
@@ -125,17 +129,91 @@ static int cx85_port = 1;
 static int max_scanline_counter;
 static int scanline_counter;
 
+/* State of INPUT_Frame() carried over to the next frame */
+static int last_key_code = AKEY_NONE;
+static int last_key_break = 0;
+static UBYTE last_stick[4] = {INPUT_STICK_CENTRE, INPUT_STICK_CENTRE, INPUT_STICK_CENTRE, INPUT_STICK_CENTRE};
+
 #ifdef EVENT_RECORDING
 static gzFile recordfp = NULL; /*output file for input recording*/
 static gzFile playbackfp = NULL; /*input file for playback*/
+static FILE *movie_recordfp = NULL; /* output file for binary movie recording */
+static FILE *movie_playbackfp = NULL; /* input file for binary movie playback */
 static int recording = FALSE;
 static int playingback = FALSE;
+static void event_frame_begin(void);
 static void update_adler32_of_screen(void);
 static unsigned int compute_adler32_of_screen(void);
 static int recording_version;
+/* Playback statistics, reported when the end of the recording is reached */
+static int playback_frames = 0;
+static int playback_errors = 0;
+static int playback_first_error = -1;
+static int playback_skip_compare = TRUE; /* screen of the previous frame not emulated */
+static int playback_seek = -1; /* frame to start the playback at */
+static int record_frames = 0;
 #define GZBUFSIZE 256
 static char gzbuf[GZBUFSIZE+1];
 #define EVENT_RECORDING_VERSION 1
+
+/* Inputs of one frame, as stored in the recording */
+typedef struct {
+	int key_code;
+	int key_shift;
+	int key_consol;
+	int port[2];
+	int trig[4];
+	unsigned int adler32;
+} event_frame_t;
+static event_frame_t record_frame;   /* collected during INPUT_Frame() */
+static event_frame_t playback_frame; /* read at the start of INPUT_Frame() */
+
+/* Binary movie format. All numbers are little-endian.
+   The header is "A8MOVIE" 0x1a, version byte, 3 zero bytes and
+   the snapshot interval in frames (4 bytes). Then follow records,
+   each starting with a tag byte:
+   0x80-0xff  A frame. Bits 0-6 of the tag tell which MOVIE_FRAME_* fields
+              changed since the previous frame; only those follow, in the
+              order of the bits: key code (2 bytes, signed), shift (1),
+              console keys (1), port 0 (1), port 1 (1), triggers (1, bits 0-3)
+              and adler32 of the screen (4).
+   'I'        An integer passed to INPUT_RecordInt() (4 bytes).
+   'S'        A snapshot taken before the given frame: frame number (4),
+              Atari800_nframes (4), POKEY random counter (4), last key code
+              (4), last break key (1), last sticks (4), length (4)
+              and the state save file. The frame after a snapshot
+              has all fields, so playback can start there.
+   'E'        End of recording: number of snapshots (4), then the frame
+              number (4) and file offset (4) of each. The file ends with
+              the offset of this record (4) and "A8MX", so the seek index
+              is found without reading the whole file. */
+#define MOVIE_VERSION 1
+#define MOVIE_HEADER_SIZE 16
+#define MOVIE_TAG_FRAME    0x80
+#define MOVIE_TAG_INT      'I'
+#define MOVIE_TAG_SNAPSHOT 'S'
+#define MOVIE_TAG_END      'E'
+#define MOVIE_FRAME_KEY_CODE   0x01
+#define MOVIE_FRAME_KEY_SHIFT  0x02
+#define MOVIE_FRAME_KEY_CONSOL 0x04
+#define MOVIE_FRAME_PORT0      0x08
+#define MOVIE_FRAME_PORT1      0x10
+#define MOVIE_FRAME_TRIG       0x20
+#define MOVIE_FRAME_ADLER32    0x40
+#define MOVIE_FRAME_ALL        0x7f
+static const char movie_magic[8] = { 'A', '8', 'M', 'O', 'V', 'I', 'E', 0x1a };
+static const char movie_index_magic[4] = { 'A', '8', 'M', 'X' };
+static char *movie_record_filename = NULL;
+static int movie_interval = 3000; /* frames between snapshots - 1 minute on PAL */
+static event_frame_t movie_record_last;   /* delta base for recording */
+static event_frame_t movie_playback_last; /* delta base for playback */
+static int movie_record_full = TRUE;      /* write all fields in the next frame */
+static ULONG *movie_index = NULL;         /* frame number, offset pairs */
+static int movie_index_count = 0;
+static int movie_index_size = 0;
+static int open_movie_recording(const char *filename);
+static int open_movie_playback(const char *filename);
+static void close_movie_recording(void);
 #endif
 
 int INPUT_Initialise(int *argc, char *argv[])
@@ -211,10 +289,40 @@ int INPUT_Initialise(int *argc, char *argv[])
 			}
 			else a_m = TRUE;
 		}
+		else if (strcmp(argv[i], "-record-movie") == 0) {
+			if (i_a)
+				movie_record_filename = argv[++i];
+			else a_m = TRUE;
+		}
+		else if (strcmp(argv[i], "-movie-interval") == 0) {
+			if (i_a) {
+				movie_interval = Util_sscandec(argv[++i]);
+				if (movie_interval <= 0) {
+					Log_print("Invalid movie snapshot interval");
+					return FALSE;
+				}
+			}
+			else a_m = TRUE;
+		}
+		else if (strcmp(argv[i], "-playback-seek") == 0) {
+			if (i_a) {
+				playback_seek = Util_sscandec(argv[++i]);
+				if (playback_seek < 0) {
+					Log_print("Invalid playback start frame");
+					return FALSE;
+				}
+			}
+			else a_m = TRUE;
+		}
 		else if (strcmp(argv[i], "-playback") == 0) {
 			if (i_a) {
 				char *pbfilename = argv[++i];
-				if ((playbackfp = gzopen(pbfilename, "rb")) == NULL) {
+				int movie = open_movie_playback(pbfilename);
+				if (movie < 0)
+					return FALSE;
+				if (movie > 0)
+					playingback = TRUE;
+				else if ((playbackfp = gzopen(pbfilename, "rb")) == NULL) {
 					Log_print("Cannot open playback file");
 					return FALSE;
 				}
@@ -270,7 +378,13 @@ int INPUT_Initialise(int *argc, char *argv[])
 				Log_print("\t-cx85 <n>        Emulate CX85 numeric keypad on port <n>");
 				Log_print("\t-multijoy        Emulate MultiJoy4 interface");
 				Log_print("\t-record <file>   Record input to <file>");
+				Log_print("\t-record-movie <file>");
+				Log_print("\t                 Record input to <file> in the binary movie format");
+				Log_print("\t-movie-interval <n>");
+				Log_print("\t                 Save a seek point every <n> frames (default 3000)");
 				Log_print("\t-playback <file> Playback input from <file>");
+				Log_print("\t-playback-seek <n>");
+				Log_print("\t                 Start movie playback at the last seek point before frame <n>");
 			}
 			argv[j++] = argv[i];
 		}
@@ -290,6 +404,15 @@ int INPUT_Initialise(int *argc, char *argv[])
 		return FALSE;
 	}
 
+#ifdef EVENT_RECORDING
+	if (movie_record_filename != NULL && !open_movie_recording(movie_record_filename))
+		return FALSE;
+	if (playback_seek >= 0 && movie_playbackfp == NULL) {
+		Log_print("-playback-seek needs a movie recorded with -record-movie");
+		return FALSE;
+	}
+#endif
+
 	INPUT_CenterMousePointer();
 	*argc = j;
 
@@ -303,8 +426,15 @@ void INPUT_Exit(void) {
 		gzclose(recordfp);
 		recording = FALSE;
 	}
+	if (movie_recordfp != NULL)
+		close_movie_recording();
 	if (playingback) {
-		gzclose(playbackfp);
+		if (movie_playbackfp != NULL) {
+			fclose(movie_playbackfp);
+			movie_playbackfp = NULL;
+		}
+		else
+			gzclose(playbackfp);
 		playingback = FALSE;
 	}
 #endif
@@ -424,15 +554,27 @@ static UBYTE mouse_step(void)
 void INPUT_Frame(void)
 {
 	int i;
-	static int last_key_code = AKEY_NONE;
-	static int last_key_break = 0;
-	static UBYTE last_stick[4] = {INPUT_STICK_CENTRE, INPUT_STICK_CENTRE, INPUT_STICK_CENTRE, INPUT_STICK_CENTRE};
 	static int last_mouse_buttons = 0;
+#ifdef SHM_EXPORT
+	int shm_input;
+	int shm_port[2];
+	int shm_trig[4];
+#endif
 
 	scanline_counter = 10000;	/* do nothing in INPUT_Scanline() */
 
+#ifdef EVENT_RECORDING
+	if (recording || playingback)
+		event_frame_begin();
+#endif
+
 	/* handle keyboard */
 
+#ifdef SHM_EXPORT
+	/* replaces INPUT_key_* if input comes from another process */
+	shm_input = SHMExport_ReadInput(shm_port, shm_trig);
+#endif
+
 	if (Atari800_keyboard_detached) {
 		/* Disable keyboard if it's not connedted. */
 		INPUT_key_code = AKEY_NONE;
@@ -452,12 +594,13 @@ void INPUT_Frame(void)
 	*/
 #ifdef EVENT_RECORDING
 	if (playingback) {
-		gzgets(playbackfp, gzbuf, GZBUFSIZE);
-		sscanf(gzbuf, "%d %d %d ", &INPUT_key_code, &INPUT_key_shift, &INPUT_key_consol);
-	}
-	if (recording) {
-		gzprintf(recordfp, "%d %d %d \n", INPUT_key_code, INPUT_key_shift, INPUT_key_consol);
+		INPUT_key_code = playback_frame.key_code;
+		INPUT_key_shift = playback_frame.key_shift;
+		INPUT_key_consol = playback_frame.key_consol;
 	}
+	record_frame.key_code = INPUT_key_code;
+	record_frame.key_shift = INPUT_key_shift;
+	record_frame.key_consol = INPUT_key_consol;
 #endif
 	i = Atari800_machine_type == Atari800_MACHINE_5200 ? INPUT_key_shift : (INPUT_key_code == AKEY_BREAK);
 	if (i && !last_key_break) {
@@ -535,33 +678,37 @@ void INPUT_Frame(void)
 
 	/* handle joysticks */
 #ifdef EVENT_RECORDING
-	if (playingback) {
-		gzgets(playbackfp, gzbuf, GZBUFSIZE);
-		sscanf(gzbuf,"%d ",&i);
-	} else {
+	if (playingback)
+		i = playback_frame.port[0];
+	else {
+#endif
+#ifdef SHM_EXPORT
+		if (shm_input)
+			i = shm_port[0];
+		else
 #endif
 		i = PLATFORM_PORT(0);
 #ifdef EVENT_RECORDING
 	}
-	if (recording) {
-		gzprintf(recordfp,"%d \n",i);
-	}
+	record_frame.port[0] = i;
 #endif
 
 	STICK[0] = i & 0x0f;
 	STICK[1] = (i >> 4) & 0x0f;
 #ifdef EVENT_RECORDING
-	if (playingback) {
-		gzgets(playbackfp, gzbuf, GZBUFSIZE);
-		sscanf(gzbuf,"%d ",&i);
-	} else {
+	if (playingback)
+		i = playback_frame.port[1];
+	else {
+#endif
+#ifdef SHM_EXPORT
+		if (shm_input)
+			i = shm_port[1];
+		else
 #endif
 		i = PLATFORM_PORT(1);
 #ifdef EVENT_RECORDING
 	}
-	if (recording) {
-		gzprintf(recordfp,"%d \n",i);
-	}
+	record_frame.port[1] = i;
 #endif
 	STICK[2] = i & 0x0f;
 	STICK[3] = (i >> 4) & 0x0f;
@@ -593,20 +740,19 @@ void INPUT_Frame(void)
 			last_stick[i] = STICK[i];
 		/* Joystick Triggers */
 #ifdef EVENT_RECORDING
-		if(playingback){
-			int trigtemp;
-			gzgets(playbackfp, gzbuf, GZBUFSIZE);
-			sscanf(gzbuf,"%d ",&trigtemp);
-			TRIG_input[i] = trigtemp;
-
-		} else {
+		if (playingback)
+			TRIG_input[i] = playback_frame.trig[i];
+		else {
+#endif
+#ifdef SHM_EXPORT
+			if (shm_input)
+				TRIG_input[i] = shm_trig[i];
+			else
 #endif
 			TRIG_input[i] = PLATFORM_TRIG(i);
 #ifdef EVENT_RECORDING
 		}
-		if(recording){
-			gzprintf(recordfp,"%d \n",TRIG_input[i]);
-		}
+		record_frame.trig[i] = TRIG_input[i];
 #endif
 		if ((INPUT_joy_autofire[i] == INPUT_AUTOFIRE_FIRE && !TRIG_input[i]) || (INPUT_joy_autofire[i] == INPUT_AUTOFIRE_CONT))
 			TRIG_input[i] = (Atari800_nframes & 2) ? 1 : 0;
@@ -866,42 +1012,538 @@ void INPUT_Frame(void)
 	}
 
 #ifdef EVENT_RECORDING
-	update_adler32_of_screen();
+	if (recording || playingback)
+		update_adler32_of_screen();
 #endif
 }
 
 #ifdef EVENT_RECORDING
+static void finish_playback(void)
+{
+	playingback = FALSE;
+	if (movie_playbackfp != NULL) {
+		fclose(movie_playbackfp);
+		movie_playbackfp = NULL;
+	}
+	else
+		gzclose(playbackfp);
+	/* This line is parsed by util/regress.pl - keep the format. */
+	Log_print("Playback finished: %d frames, %d mismatches, first mismatch in frame %d",
+	          playback_frames, playback_errors, playback_first_error);
+	Atari800_ErrExit();
+	exit(playback_errors > 0 ? 1 : 0); /* return code indicates errors*/
+}
+
+static void read_text_frame(event_frame_t *f)
+{
+	int i;
+	if (gzgets(playbackfp, gzbuf, GZBUFSIZE) == NULL)
+		finish_playback();
+	sscanf(gzbuf, "%d %d %d ", &f->key_code, &f->key_shift, &f->key_consol);
+	for (i = 0; i < 2; i++) {
+		gzgets(playbackfp, gzbuf, GZBUFSIZE);
+		sscanf(gzbuf, "%d ", &f->port[i]);
+	}
+	for (i = 0; i < 4; i++) {
+		gzgets(playbackfp, gzbuf, GZBUFSIZE);
+		sscanf(gzbuf, "%d ", &f->trig[i]);
+	}
+	gzgets(playbackfp, gzbuf, GZBUFSIZE);
+	sscanf(gzbuf, "%08X ", &f->adler32);
+}
+
+static void write_text_frame(const event_frame_t *f)
+{
+	int i;
+	gzprintf(recordfp, "%d %d %d \n", f->key_code, f->key_shift, f->key_consol);
+	for (i = 0; i < 2; i++)
+		gzprintf(recordfp, "%d \n", f->port[i]);
+	for (i = 0; i < 4; i++)
+		gzprintf(recordfp, "%d \n", f->trig[i]);
+	gzprintf(recordfp, "%08X \n", f->adler32);
+}
+
+static void movie_put16(FILE *fp, int value)
+{
+	fputc(value & 0xff, fp);
+	fputc((value >> 8) & 0xff, fp);
+}
+
+static void movie_put32(FILE *fp, ULONG value)
+{
+	movie_put16(fp, (int) (value & 0xffff));
+	movie_put16(fp, (int) (value >> 16));
+}
+
+/* Returns the byte read or -1 at the end of the file. */
+static int movie_get8(FILE *fp)
+{
+	int c = fgetc(fp);
+	return c == EOF ? -1 : c;
+}
+
+/* Returns the word read or -1 at the end of the file. */
+static int movie_get16(FILE *fp)
+{
+	int lo = movie_get8(fp);
+	int hi = movie_get8(fp);
+	if (lo < 0 || hi < 0)
+		return -1;
+	return (hi << 8) | lo;
+}
+
+static ULONG movie_buf32(const UBYTE *p)
+{
+	return p[0] | (p[1] << 8) | ((ULONG) p[2] << 16) | ((ULONG) p[3] << 24);
+}
+
+/* Stores the long word read at *VALUE. Returns FALSE at the end of the file. */
+static int movie_get32(FILE *fp, ULONG *value)
+{
+	int lo = movie_get16(fp);
+	int hi = movie_get16(fp);
+	if (lo < 0 || hi < 0)
+		return FALSE;
+	*value = ((ULONG) hi << 16) | (ULONG) lo;
+	return TRUE;
+}
+
+static void movie_reset_frame(event_frame_t *f)
+{
+	int i;
+	f->key_code = AKEY_NONE;
+	f->key_shift = 0;
+	f->key_consol = INPUT_CONSOL_NONE;
+	f->port[0] = f->port[1] = 0xff;
+	for (i = 0; i < 4; i++)
+		f->trig[i] = 1;
+	f->adler32 = 0;
+}
+
+/* Returns 1 if FILENAME is a movie and was opened for playback, 0 if it is
+   not a movie, -1 on error. */
+static int open_movie_playback(const char *filename)
+{
+	UBYTE header[MOVIE_HEADER_SIZE];
+	FILE *fp = fopen(filename, "rb");
+	if (fp == NULL)
+		return 0; /* let gzopen() report it */
+	if (fread(header, 1, MOVIE_HEADER_SIZE, fp) != MOVIE_HEADER_SIZE
+	 || memcmp(header, movie_magic, sizeof(movie_magic)) != 0) {
+		fclose(fp);
+		return 0;
+	}
+	if (header[8] > MOVIE_VERSION) {
+		Log_print("Newer version of playback file than this version of Atari800 can handle");
+		fclose(fp);
+		return -1;
+	}
+	movie_interval = (header[12] & 0xff) | ((header[13] & 0xff) << 8)
+	               | ((header[14] & 0xff) << 16) | ((header[15] & 0xff) << 24);
+	if (movie_interval <= 0) {
+		Log_print("Invalid playback file");
+		fclose(fp);
+		return -1;
+	}
+	movie_reset_frame(&movie_playback_last);
+	movie_playbackfp = fp;
+	return 1;
+}
+
+static int open_movie_recording(const char *filename)
+{
+	FILE *fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		Log_print("Cannot open record file");
+		return FALSE;
+	}
+	fwrite(movie_magic, 1, sizeof(movie_magic), fp);
+	fputc(MOVIE_VERSION, fp);
+	fputc(0, fp);
+	movie_put16(fp, 0);
+	movie_put32(fp, (ULONG) movie_interval);
+	movie_reset_frame(&movie_record_last);
+	movie_record_full = TRUE;
+	movie_recordfp = fp;
+	recording = TRUE;
+	return TRUE;
+}
+
+/* Writes the seek index and closes the movie. */
+static void close_movie_recording(void)
+{
+	long end_offset = ftell(movie_recordfp);
+	int i;
+	fputc(MOVIE_TAG_END, movie_recordfp);
+	movie_put32(movie_recordfp, (ULONG) movie_index_count);
+	for (i = 0; i < 2 * movie_index_count; i++)
+		movie_put32(movie_recordfp, movie_index[i]);
+	movie_put32(movie_recordfp, (ULONG) end_offset);
+	fwrite(movie_index_magic, 1, sizeof(movie_index_magic), movie_recordfp);
+	if (fclose(movie_recordfp) != 0)
+		Log_print("Error writing movie file");
+	movie_recordfp = NULL;
+	free(movie_index);
+	movie_index = NULL;
+	movie_index_count = movie_index_size = 0;
+}
+
+static void write_movie_frame(const event_frame_t *f)
+{
+	event_frame_t *last = &movie_record_last;
+	int mask = 0;
+	int i;
+	if (movie_record_full)
+		mask = MOVIE_FRAME_ALL;
+	else {
+		if (f->key_code != last->key_code)
+			mask |= MOVIE_FRAME_KEY_CODE;
+		if (f->key_shift != last->key_shift)
+			mask |= MOVIE_FRAME_KEY_SHIFT;
+		if (f->key_consol != last->key_consol)
+			mask |= MOVIE_FRAME_KEY_CONSOL;
+		if (f->port[0] != last->port[0])
+			mask |= MOVIE_FRAME_PORT0;
+		if (f->port[1] != last->port[1])
+			mask |= MOVIE_FRAME_PORT1;
+		for (i = 0; i < 4; i++)
+			if (f->trig[i] != last->trig[i])
+				mask |= MOVIE_FRAME_TRIG;
+		if (f->adler32 != last->adler32)
+			mask |= MOVIE_FRAME_ADLER32;
+	}
+	fputc(MOVIE_TAG_FRAME | mask, movie_recordfp);
+	if (mask & MOVIE_FRAME_KEY_CODE)
+		movie_put16(movie_recordfp, f->key_code);
+	if (mask & MOVIE_FRAME_KEY_SHIFT)
+		fputc(f->key_shift, movie_recordfp);
+	if (mask & MOVIE_FRAME_KEY_CONSOL)
+		fputc(f->key_consol, movie_recordfp);
+	if (mask & MOVIE_FRAME_PORT0)
+		fputc(f->port[0], movie_recordfp);
+	if (mask & MOVIE_FRAME_PORT1)
+		fputc(f->port[1], movie_recordfp);
+	if (mask & MOVIE_FRAME_TRIG)
+		fputc((f->trig[0] ? 1 : 0) | (f->trig[1] ? 2 : 0) | (f->trig[2] ? 4 : 0) | (f->trig[3] ? 8 : 0), movie_recordfp);
+	if (mask & MOVIE_FRAME_ADLER32)
+		movie_put32(movie_recordfp, f->adler32);
+	*last = *f;
+	movie_record_full = FALSE;
+}
+
+/* Skips records other than frames. Returns FALSE at the end of the movie. */
+static int read_movie_frame(event_frame_t *f)
+{
+	event_frame_t *last = &movie_playback_last;
+	for (;;) {
+		int tag = fgetc(movie_playbackfp);
+		int c;
+		if (tag == MOVIE_TAG_END)
+			return FALSE;
+		if (tag == EOF)
+			break; /* a complete movie ends with the seek index */
+		if (tag == MOVIE_TAG_INT) {
+			if (fseek(movie_playbackfp, 4, SEEK_CUR) != 0)
+				break;
+		}
+		else if (tag == MOVIE_TAG_SNAPSHOT) {
+			ULONG len;
+			if (fseek(movie_playbackfp, 21, SEEK_CUR) != 0
+			 || !movie_get32(movie_playbackfp, &len)
+			 || fseek(movie_playbackfp, (long) len, SEEK_CUR) != 0)
+				break;
+		}
+		else if (tag & MOVIE_TAG_FRAME) {
+			if (tag & MOVIE_FRAME_KEY_CODE) {
+				if ((c = movie_get16(movie_playbackfp)) < 0)
+					break;
+				last->key_code = c >= 0x8000 ? c - 0x10000 : c;
+			}
+			if (tag & MOVIE_FRAME_KEY_SHIFT) {
+				if ((c = movie_get8(movie_playbackfp)) < 0)
+					break;
+				last->key_shift = c;
+			}
+			if (tag & MOVIE_FRAME_KEY_CONSOL) {
+				if ((c = movie_get8(movie_playbackfp)) < 0)
+					break;
+				last->key_consol = c;
+			}
+			if (tag & MOVIE_FRAME_PORT0) {
+				if ((c = movie_get8(movie_playbackfp)) < 0)
+					break;
+				last->port[0] = c;
+			}
+			if (tag & MOVIE_FRAME_PORT1) {
+				if ((c = movie_get8(movie_playbackfp)) < 0)
+					break;
+				last->port[1] = c;
+			}
+			if (tag & MOVIE_FRAME_TRIG) {
+				int i;
+				if ((c = movie_get8(movie_playbackfp)) < 0)
+					break;
+				for (i = 0; i < 4; i++)
+					last->trig[i] = (c >> i) & 1;
+			}
+			if (tag & MOVIE_FRAME_ADLER32) {
+				ULONG adler32;
+				if (!movie_get32(movie_playbackfp, &adler32))
+					break;
+				last->adler32 = (unsigned int) adler32;
+			}
+			*f = *last;
+			return TRUE;
+		}
+		else {
+			Log_print("Invalid playback file");
+			return FALSE;
+		}
+	}
+	Log_print("Truncated playback file");
+	return FALSE;
+}
+
+/* Stores a seek point: the emulator state before frame RECORD_FRAMES. */
+static void write_movie_snapshot(void)
+{
+	char tmpname[FILENAME_MAX];
+	FILE *fp;
+	long offset;
+	int len;
+	int i;
+
+	fp = Util_uniqopen(tmpname, "wb");
+	if (fp == NULL) {
+		Log_print("Cannot create temporary file for movie snapshot");
+		return;
+	}
+	fclose(fp);
+	if (!StateSav_SaveAtariState(tmpname, "wb", FALSE) || (fp = fopen(tmpname, "rb")) == NULL) {
+		Log_print("Cannot save movie snapshot");
+#ifdef HAVE_UTIL_UNLINK
+		Util_unlink(tmpname);
+#endif
+		return;
+	}
+	len = Util_flen(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	offset = ftell(movie_recordfp);
+	fputc(MOVIE_TAG_SNAPSHOT, movie_recordfp);
+	movie_put32(movie_recordfp, (ULONG) record_frames);
+	movie_put32(movie_recordfp, (ULONG) Atari800_nframes);
+	movie_put32(movie_recordfp, POKEY_GetRandomCounter());
+	movie_put32(movie_recordfp, (ULONG) last_key_code);
+	fputc(last_key_break, movie_recordfp);
+	for (i = 0; i < 4; i++)
+		fputc(last_stick[i], movie_recordfp);
+	movie_put32(movie_recordfp, (ULONG) len);
+	for (i = 0; i < len; i++)
+		fputc(fgetc(fp), movie_recordfp);
+	fclose(fp);
+#ifdef HAVE_UTIL_UNLINK
+	Util_unlink(tmpname);
+#endif
+	if (ferror(movie_recordfp)) {
+		/* Drop the partial record, so that the frames overwrite it and
+		   no index entry points to it. */
+		Log_print("Cannot write movie snapshot");
+		clearerr(movie_recordfp);
+		fseek(movie_recordfp, offset, SEEK_SET);
+		return;
+	}
+
+	if (movie_index_count >= movie_index_size) {
+		movie_index_size = movie_index_size == 0 ? 64 : movie_index_size * 2;
+		movie_index = (ULONG *) Util_realloc(movie_index, 2 * movie_index_size * sizeof(ULONG));
+	}
+	movie_index[2 * movie_index_count] = (ULONG) record_frames;
+	movie_index[2 * movie_index_count + 1] = (ULONG) offset;
+	movie_index_count++;
+	/* Let playback start right after the snapshot. */
+	movie_record_full = TRUE;
+}
+
+/* Reads the frame number and the file offset of the seek point N from
+   the index at INDEX_OFFSET. Returns FALSE on error. */
+static int read_movie_index(ULONG index_offset, int n, ULONG *frame, ULONG *offset)
+{
+	return fseek(movie_playbackfp, (long) (index_offset + 5 + 8 * n), SEEK_SET) == 0
+	    && movie_get32(movie_playbackfp, frame)
+	    && movie_get32(movie_playbackfp, offset);
+}
+
+/* Restores the emulator from the last seek point at or before FRAME.
+   Thanks to the fixed snapshot interval this usually reads only one index
+   entry; the index is searched if a snapshot could not be saved. */
+static void seek_movie(int frame)
+{
+	char tmpname[FILENAME_MAX];
+	char magic[4];
+	ULONG index_offset;
+	UBYTE record[25]; /* the snapshot record after its tag */
+	ULONG index_frame;
+	ULONG snapshot_offset;
+	ULONG len;
+	ULONG count;
+	int n;
+	int c;
+	int i;
+	FILE *fp;
+
+	n = frame / movie_interval - 1;
+	if (n < 0)
+		return; /* before the first seek point - play from the start */
+	if (fseek(movie_playbackfp, -8, SEEK_END) != 0
+	 || !movie_get32(movie_playbackfp, &index_offset)
+	 || fread(magic, 1, 4, movie_playbackfp) != 4 || memcmp(magic, movie_index_magic, 4) != 0
+	 || fseek(movie_playbackfp, (long) index_offset, SEEK_SET) != 0
+	 || fgetc(movie_playbackfp) != MOVIE_TAG_END
+	 || !movie_get32(movie_playbackfp, &count)) {
+		Log_print("Movie has no seek index, playing from the start");
+		fseek(movie_playbackfp, MOVIE_HEADER_SIZE, SEEK_SET);
+		return;
+	}
+	if (count == 0) {
+		fseek(movie_playbackfp, MOVIE_HEADER_SIZE, SEEK_SET);
+		return;
+	}
+	if ((ULONG) n >= count)
+		n = (int) count - 1;
+	if (!read_movie_index(index_offset, n, &index_frame, &snapshot_offset)) {
+		Log_print("Truncated playback file");
+		finish_playback();
+	}
+	if (index_frame != (ULONG) ((n + 1) * movie_interval)) {
+		/* Some snapshots are missing - find the last one at or before FRAME. */
+		int lo = 0;
+		int hi = (int) count - 1;
+		n = -1;
+		while (lo <= hi) {
+			int mid = (lo + hi) / 2;
+			if (!read_movie_index(index_offset, mid, &index_frame, &snapshot_offset)) {
+				Log_print("Truncated playback file");
+				finish_playback();
+			}
+			if (index_frame <= (ULONG) frame) {
+				n = mid;
+				lo = mid + 1;
+			}
+			else
+				hi = mid - 1;
+		}
+		if (n < 0) {
+			fseek(movie_playbackfp, MOVIE_HEADER_SIZE, SEEK_SET);
+			return;
+		}
+		read_movie_index(index_offset, n, &index_frame, &snapshot_offset);
+	}
+	/* A damaged index must not start playback at a wrong frame. */
+	if (index_frame > (ULONG) frame
+	 || fseek(movie_playbackfp, (long) snapshot_offset, SEEK_SET) != 0
+	 || fgetc(movie_playbackfp) != MOVIE_TAG_SNAPSHOT
+	 || fread(record, 1, sizeof(record), movie_playbackfp) != sizeof(record)
+	 || movie_buf32(record) != index_frame) {
+		Log_print("Invalid seek index in playback file");
+		finish_playback();
+	}
+	playback_frames = (int) index_frame;
+	Atari800_nframes = (int) movie_buf32(record + 4);
+	POKEY_SetRandomCounter(movie_buf32(record + 8));
+	last_key_code = (int) movie_buf32(record + 12);
+	last_key_break = record[16];
+	for (i = 0; i < 4; i++)
+		last_stick[i] = record[17 + i];
+	len = movie_buf32(record + 21);
+
+	fp = Util_uniqopen(tmpname, "wb");
+	if (fp == NULL) {
+		Log_print("Cannot create temporary file for movie snapshot");
+		finish_playback();
+	}
+	for (; len > 0; len--) {
+		if ((c = movie_get8(movie_playbackfp)) < 0) {
+			Log_print("Truncated playback file");
+			fclose(fp);
+#ifdef HAVE_UTIL_UNLINK
+			Util_unlink(tmpname);
+#endif
+			finish_playback();
+		}
+		fputc(c, fp);
+	}
+	fclose(fp);
+	if (!StateSav_ReadAtariState(tmpname, "rb")) {
+		Log_print("Cannot restore movie snapshot");
+#ifdef HAVE_UTIL_UNLINK
+		Util_unlink(tmpname);
+#endif
+		finish_playback();
+	}
+#ifdef HAVE_UTIL_UNLINK
+	Util_unlink(tmpname);
+#endif
+	Log_print("Playback started at frame %d", playback_frames);
+	/* Screen_atari still holds the screen from before the seek. */
+	playback_skip_compare = TRUE;
+}
+
+/* Called at the start of INPUT_Frame() when recording or playing back. */
+static void event_frame_begin(void)
+{
+	if (playingback && playback_seek >= 0) {
+		seek_movie(playback_seek);
+		playback_seek = -1;
+	}
+	if (movie_recordfp != NULL && record_frames > 0 && record_frames % movie_interval == 0)
+		write_movie_snapshot();
+	if (playingback) {
+		if (movie_playbackfp != NULL) {
+			if (!read_movie_frame(&playback_frame))
+				finish_playback();
+		}
+		else
+			read_text_frame(&playback_frame);
+	}
+}
+
 static void update_adler32_of_screen(void)
 {
 	unsigned int adler32val = 0;
-	static unsigned int adler32_errors = 0;
 	static int first = TRUE;
 	if (first) { /* don't calculate the first frame */
 		first = FALSE;
 		adler32val = 0;
 	}
-	else if (recording || playingback){
+	else {
 		adler32val = compute_adler32_of_screen();
 	}
 
 	if (recording) {
-		gzprintf(recordfp, "%08X \n", adler32val);
+		record_frame.adler32 = adler32val;
+		if (recordfp != NULL)
+			write_text_frame(&record_frame);
+		if (movie_recordfp != NULL)
+			write_movie_frame(&record_frame);
+		record_frames++;
 	}
 	if (playingback) {
-		unsigned int pb_adler32val;
-		gzgets(playbackfp, gzbuf, GZBUFSIZE);
-		sscanf(gzbuf, "%08X ", &pb_adler32val);
-		if (pb_adler32val != adler32val){
-			Log_print("adler32 does not match");
-			adler32_errors++;
+		if (playback_skip_compare)
+			playback_skip_compare = FALSE;
+		else if (playback_frame.adler32 != adler32val){
+			/* Report only the first difference - the following frames
+			   usually diverge as well and would flood the log. */
+			if (playback_first_error < 0) {
+				playback_first_error = playback_frames;
+				Log_print("adler32 does not match in frame %d: expected %08X, got %08X",
+				          playback_frames, playback_frame.adler32, adler32val);
+			}
+			playback_errors++;
 		}
-		
-	}
-	if (playingback && gzeof(playbackfp)) {
-		playingback = FALSE;
-		gzclose(playbackfp);
-		Atari800_ErrExit();
-		exit(adler32_errors > 0 ? 1 : 0); /* return code indicates errors*/
+		playback_frames++;
+		if (movie_playbackfp == NULL && gzeof(playbackfp))
+			finish_playback();
 	}
 }
 /* Compute the adler32 value of the visible screen */
@@ -939,17 +1581,33 @@ int INPUT_Playingback(void)
 void INPUT_RecordInt(int i)
 {
 #ifdef EVENT_RECORDING
-	if (recording) gzprintf(recordfp, "%d\n", i);
+	if (recordfp != NULL) gzprintf(recordfp, "%d\n", i);
+	if (movie_recordfp != NULL) {
+		fputc(MOVIE_TAG_INT, movie_recordfp);
+		movie_put32(movie_recordfp, (ULONG) i);
+	}
 #endif
 }
 
 int INPUT_PlaybackInt(void)
 {
 #ifdef EVENT_RECORDING
-	int i;
+	int i = 0;
 	if (playingback) {
-		gzgets(playbackfp, gzbuf, GZBUFSIZE);
-		sscanf(gzbuf, "%d", &i);
+		if (movie_playbackfp != NULL) {
+			int tag = fgetc(movie_playbackfp);
+			ULONG value;
+			if (tag == MOVIE_TAG_INT) {
+				if (movie_get32(movie_playbackfp, &value))
+					i = (int) value;
+			}
+			else if (tag != EOF)
+				ungetc(tag, movie_playbackfp);
+		}
+		else {
+			gzgets(playbackfp, gzbuf, GZBUFSIZE);
+			sscanf(gzbuf, "%d", &i);
+		}
 	}
 	return i;
 #else
@@ -1026,6 +1684,7 @@ void INPUT_DrawMousePointer(void)
 		int y = mouse_y >> MOUSE_SHIFT;
 		if (x >= 0 && x <= 167 && y >= 0 && y <= 119) {
 			UWORD *ptr = & ((UWORD *) Screen_atari)[12 + x + Screen_WIDTH * y];
+			ANTIC_InvalidateLines(2 * y - 4, 10);
 			PLOT(-2, 0);
 			PLOT(-1, 0);
 			PLOT(1, 0);
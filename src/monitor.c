@@ -2110,12 +2110,18 @@ static void show_POKEY(void)
 		   POKEY_AUDC[POKEY_CHAN1], POKEY_AUDC[POKEY_CHAN2], POKEY_AUDC[POKEY_CHAN3], POKEY_AUDC[POKEY_CHAN4], POKEY_IRQEN, POKEY_IRQST);
 	printf("SKSTAT=%02X    SKCTL= %02X\n", POKEY_SKSTAT, POKEY_SKCTL);
 #ifdef STEREO_SOUND
-	if (POKEYSND_stereo_enabled) {
-		printf("Second chip:\n");
-		printf("AUDF1= %02X    AUDF2= %02X    AUDF3= %02X    AUDF4= %02X    AUDCTL=%02X\n",
-			   POKEY_AUDF[POKEY_CHAN1 + POKEY_CHIP2], POKEY_AUDF[POKEY_CHAN2 + POKEY_CHIP2], POKEY_AUDF[POKEY_CHAN3 + POKEY_CHIP2], POKEY_AUDF[POKEY_CHAN4 + POKEY_CHIP2], POKEY_AUDCTL[1]);
-		printf("AUDC1= %02X    AUDC2= %02X    AUDC3= %02X    AUDC4= %02X\n",
-			   POKEY_AUDC[POKEY_CHAN1 + POKEY_CHIP2], POKEY_AUDC[POKEY_CHAN2 + POKEY_CHIP2], POKEY_AUDC[POKEY_CHAN3 + POKEY_CHIP2], POKEY_AUDC[POKEY_CHAN4 + POKEY_CHIP2]);
+	{
+		static const char * const chip_names[POKEY_MAXPOKEYS] = { "First", "Second", "Third", "Fourth" };
+		int chip;
+		for (chip = 1; chip < POKEYSND_NumChips(); chip++) {
+			const UBYTE *audf = POKEY_AUDF + chip * 4;
+			const UBYTE *audc = POKEY_AUDC + chip * 4;
+			printf("%s chip:\n", chip_names[chip]);
+			printf("AUDF1= %02X    AUDF2= %02X    AUDF3= %02X    AUDF4= %02X    AUDCTL=%02X\n",
+				   audf[POKEY_CHAN1], audf[POKEY_CHAN2], audf[POKEY_CHAN3], audf[POKEY_CHAN4], POKEY_AUDCTL[chip]);
+			printf("AUDC1= %02X    AUDC2= %02X    AUDC3= %02X    AUDC4= %02X\n",
+				   audc[POKEY_CHAN1], audc[POKEY_CHAN2], audc[POKEY_CHAN3], audc[POKEY_CHAN4]);
+		}
 	}
 #endif
 }
@@ -42,6 +42,12 @@
 #include "votraxsnd.h"
 #endif
 #include "sndsave.h"
+#ifdef AVI_RECORDING
+#include "avirec.h"
+#endif
+#ifdef SHM_EXPORT
+#include "shmexport.h"
+#endif
 #endif
 
 #define CONSOLE_VOL 8
@@ -68,7 +74,7 @@ static const double pokeymix[61+CONSOLE_VOL] = { /* Nonlinear POKEY mixing array
 
 #define SND_FILTER_SIZE  2048
 
-#define NPOKEYS 2
+#define NPOKEYS POKEY_MAXPOKEYS
 
 
 /* M_PI was not defined in MSVC headers */
@@ -76,7 +82,12 @@ static const double pokeymix[61+CONSOLE_VOL] = { /* Nonlinear POKEY mixing array
 # define M_PI 3.141592653589793
 #endif
 
-static int num_cur_pokeys = 0;
+static int num_cur_pokeys = 0; /* number of output channels */
+static int num_chips = 0;
+/* Share of each chip in each output channel. When each chip has a channel of
+   its own, the samples are output as they are. */
+static double mix_weight[NPOKEYS][2];
+static int mix_direct;
 
 /* Filter */
 static int sample_rate; /* Hz */
@@ -266,6 +277,9 @@ typedef struct stPokeyState
 
     int speaker;
 
+    /* State of the dither noise generator */
+    ULONG dither;
+
 } PokeyState;
 
 PokeyState pokey_states[NPOKEYS];
@@ -286,12 +300,46 @@ static void event3_pure(PokeyState* ps, int p5v, int p4v, int p917v);
 
 #ifdef SYNCHRONIZED_SOUND
 static int ticks_per_frame;
-static int tick_pos;
-static double samp_pos;
+/* the tick each chip has been advanced to */
+static int chip_tick[NPOKEYS];
+/* The position of the last sample is samp_tick + samp_frac / 2^32 ticks.
+   Each sample advances it by ticks_per_sample + frac_per_sample / 2^32. */
+static int samp_tick;
+static ULONG samp_frac;
+/* number of samples rendered in this frame */
 static int start_sample;
-static double ticks_per_sample;
+static int ticks_per_sample;
+static ULONG frac_per_sample;
 UBYTE *MZPOKEYSND_process_buffer = NULL;
+/* allocated size of MZPOKEYSND_process_buffer; it only grows */
+static int process_buffer_size = 0;
+/* render_to_tick() writes at render_pos, wrapping around from render_end
+   to render_start. This is MZPOKEYSND_process_buffer, except in
+   MZPOKEYSND_UpdateRing(), which renders straight into the ring buffer. */
+static UBYTE *render_start;
+static UBYTE *render_end;
+static UBYTE *render_pos;
+
+/* The writes to the registers and the changes of the console speaker are
+   not applied at once, but queued with their tick. render_to_tick() applies
+   them as it gets to them, so each one advances only its own chip, instead
+   of rendering and advancing all the chips up to it. */
+#define MAX_EVENTS 4096
+#define EVENT_SPEAKER 0xff /* addr of a speaker change */
+typedef struct {
+    int tick;
+    int val;
+    UBYTE chip;
+    UBYTE addr;
+} SoundEvent;
+static SoundEvent events[MAX_EVENTS];
+static int num_events = 0;
+static int next_event = 0;
+
 static void render_to_tick(int last_tick);
+static void queue_event(UBYTE chip, UBYTE addr, int val);
+static void apply_events(int last_tick);
+static void flush_events(void);
 #endif
 
 
@@ -305,6 +353,10 @@ static void ResetPokeyState(PokeyState* ps)
     ps->poly9pos = 0;
     ps->poly17pos = 0;
 
+    /* Different for each chip, so that stereo channels get uncorrelated
+       noise. Must not be 0. */
+    ps->dither = 0x9e3779b9 + (ULONG)(ps - pokey_states);
+
     /* Change queue */
     ps->ovola = 0;
     ps->qebeg = 0;
@@ -1299,6 +1351,34 @@ static void Update_vol_only_sound_mz( void );
 /*****************************************************************************/
 
 void init_mzpokeysnd_sync(void);
+
+static void init_mixer(void)
+{
+    int i;
+    int c;
+    mix_direct = num_chips == num_cur_pokeys;
+    for (i = 0; i < num_chips; i++)
+        for (c = 0; c < num_cur_pokeys; c++)
+        {
+            int weight = POKEYSND_PanWeight(i, c);
+            mix_weight[i][c] = weight / 256.0;
+            if (weight != (i == c ? 256 : 0))
+                mix_direct = FALSE;
+        }
+}
+
+/* Mixes the output values of all chips for output CHANNEL. */
+static double mix_chips(const double *values, int channel)
+{
+    double sum = 0.0;
+    int i;
+    if (mix_direct)
+        return values[channel];
+    for (i = 0; i < num_chips; i++)
+        sum += mix_weight[i][channel] * values[i];
+    return sum;
+}
+
 int MZPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
                         int flags, int quality
 #ifdef __PLUS
@@ -1420,10 +1500,13 @@ int MZPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
 	if (clear_regs)
 #endif
 	{
-		ResetPokeyState(pokey_states);
-		ResetPokeyState(pokey_states + 1);
+		int i;
+		for (i = 0; i < NPOKEYS; i++)
+			ResetPokeyState(pokey_states + i);
 	}
 	num_cur_pokeys = num_pokeys;
+	num_chips = POKEYSND_num_chips;
+	init_mixer();
 
 #ifdef SYNCHRONIZED_SOUND
 	init_mzpokeysnd_sync();
@@ -1976,42 +2059,9 @@ static void Update_c3stop(PokeyState* ps)
 }
 #endif /*NONLINEAR_MIXING*/
 
-#ifdef SYNCHRONIZED_SOUND
-static void Update_synchronized_sound(void)
-{
-    int last_tick = ANTIC_ypos*114+ANTIC_XPOS+1;
-    int i;
-    if (last_tick > ticks_per_frame) last_tick = ticks_per_frame; /* XXX it could go past the frame, fix this */
-    render_to_tick(last_tick); /* only advances to last sample tick */
-    if (last_tick - tick_pos > 0) {
-        for (i = 0; i < (int)num_cur_pokeys; i++)
-        {
-            /* remaining ticks */
-            advance_ticks(pokey_states + i, last_tick - tick_pos);
-        }
-        tick_pos = last_tick;
-    }
-}
-#endif
-/*****************************************************************************/
-/* Function: Update_pokey_sound_mz()                                         */
-/*                                                                           */
-/* Inputs:  addr - the address of the parameter to be changed                */
-/*          val - the new value to be placed in the specified address        */
-/*          chip - chip # for stereo                                         */
-/*          gain - specified as an 8-bit fixed point number - use 1 for no   */
-/*                 amplification (output is multiplied by gain)              */
-/*                                                                           */
-/* Outputs: Adjusts local globals - no return value                          */
-/*                                                                           */
-/*****************************************************************************/
-static void Update_pokey_sound_mz(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain)
+/* Applies a write to a register of the chip PS */
+static void write_register(PokeyState* ps, UWORD addr, UBYTE val)
 {
-    PokeyState* ps = pokey_states+chip;
-
-#ifdef SYNCHRONIZED_SOUND
-    Update_synchronized_sound();
-#endif
     switch(addr & 0x0f)
     {
     case POKEY_OFFSET_AUDF1:
@@ -2144,6 +2194,79 @@ static void Update_pokey_sound_mz(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain)
     }
 }
 
+#ifdef SYNCHRONIZED_SOUND
+/* Advances the chip of EV to its tick and applies it */
+static void apply_event(const SoundEvent *ev)
+{
+    PokeyState* ps = pokey_states + ev->chip;
+    advance_ticks(ps, ev->tick - chip_tick[ev->chip]);
+    if (ev->tick > chip_tick[ev->chip])
+        chip_tick[ev->chip] = ev->tick;
+    if (ev->addr == EVENT_SPEAKER) {
+        ps->speaker = ev->val;
+        ps->forcero = 1;
+    }
+    else
+        write_register(ps, ev->addr, (UBYTE) ev->val);
+}
+
+/* Renders the sound up to LAST_TICK and applies the events until then */
+static void apply_events(int last_tick)
+{
+    render_to_tick(last_tick);
+    while (next_event < num_events && events[next_event].tick <= last_tick)
+        apply_event(&events[next_event++]);
+    if (next_event == num_events)
+        num_events = next_event = 0;
+}
+
+/* Applies all the queued events without rendering */
+static void flush_events(void)
+{
+    while (next_event < num_events)
+        apply_event(&events[next_event++]);
+    num_events = next_event = 0;
+}
+
+/* Queues a change of ADDR of CHIP at the current tick */
+static void queue_event(UBYTE chip, UBYTE addr, int val)
+{
+    int tick = ANTIC_ypos*114+ANTIC_XPOS+1;
+    if (tick > ticks_per_frame) tick = ticks_per_frame; /* XXX it could go past the frame, fix this */
+    if (num_events == MAX_EVENTS) {
+        apply_events(tick);
+        /* the ticks restart in frames that were not rendered */
+        flush_events();
+    }
+    events[num_events].tick = tick;
+    events[num_events].val = val;
+    events[num_events].chip = chip;
+    events[num_events].addr = addr;
+    num_events++;
+}
+#endif
+
+/*****************************************************************************/
+/* Function: Update_pokey_sound_mz()                                         */
+/*                                                                           */
+/* Inputs:  addr - the address of the parameter to be changed                */
+/*          val - the new value to be placed in the specified address        */
+/*          chip - chip # for stereo                                         */
+/*          gain - specified as an 8-bit fixed point number - use 1 for no   */
+/*                 amplification (output is multiplied by gain)              */
+/*                                                                           */
+/* Outputs: Adjusts local globals - no return value                          */
+/*                                                                           */
+/*****************************************************************************/
+static void Update_pokey_sound_mz(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain)
+{
+#ifdef SYNCHRONIZED_SOUND
+    queue_event(chip, (UBYTE) (addr & 0x0f), val);
+#else
+    write_register(pokey_states+chip, addr, val);
+#endif
+}
+
 #if 0
 void mzpokeysnd_debugreset(UBYTE chip)
 {
@@ -2328,6 +2451,10 @@ void mzpokeysnd_debugreset(UBYTE chip)
  optimum value should be selected. My experiments show that
  unbiased rand() noise of amplitude 0.25 LSB is doing well.
 
+ The noise is now triangular (the sum of two uniform random numbers)
+ with the same peak amplitude of 0.25 LSB. It comes from a xorshift
+ generator kept in each PokeyState, see dither_noise().
+
  Test spectral pictures for 8-bit sound, 8kHz sampling rate,
  dithered, show a noise floor of approx. -87dB/Hz.
 
@@ -2335,8 +2462,43 @@ void mzpokeysnd_debugreset(UBYTE chip)
 
 #define MAX_SAMPLE 152
 
+/* Triangular (TPDF) dither noise in the range [-0.25, 0.25) LSB: the sum of
+   two 16-bit uniform random numbers taken from a xorshift generator. This is
+   much cheaper than two calls to rand() and needs no shared state. */
+static double dither_noise(PokeyState *ps)
+{
+    ULONG x = ps->dither;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    ps->dither = x;
+    return (double)((x & 0xffff) + (x >> 16 & 0xffff)) * (0.25 / 65536) - 0.25;
+}
+
+/* Added before truncation to int, so that truncation rounds down like
+   floor() for all values the filter can produce. */
+#define FLOOR_BIAS 65536
+
+/* Converts an output value of the filter to an 8-bit unsigned sample.
+   The result differs from the exact value by at most 0.5 LSB of rounding
+   plus 0.25 LSB of dither. */
+static UBYTE quantise_8(PokeyState *ps, double value)
+{
+    return (UBYTE)((int)((value - MAX_SAMPLE / 2.0) * (255.0 / MAX_SAMPLE / 4 * M_PI * 0.95)
+        + (128 + 0.5 + FLOOR_BIAS) + dither_noise(ps)) - FLOOR_BIAS);
+}
+
+/* Converts an output value of the filter to a 16-bit signed sample,
+   with the same error bound as quantise_8(). */
+static SWORD quantise_16(PokeyState *ps, double value)
+{
+    return (SWORD)((int)((value - MAX_SAMPLE / 2.0) * (65535.0 / MAX_SAMPLE / 4 * M_PI * 0.95)
+        + (0.5 + FLOOR_BIAS) + dither_noise(ps)) - FLOOR_BIAS);
+}
+
 static void mzpokeysnd_process_8(void* sndbuffer, int sndn)
 {
+    double values[NPOKEYS];
     int i;
     int nsam = sndn;
     UBYTE *buffer = (UBYTE *) sndbuffer;
@@ -2344,6 +2506,11 @@ static void mzpokeysnd_process_8(void* sndbuffer, int sndn)
     if(num_cur_pokeys<1)
         return; /* module was not initialized */
 
+#ifdef SYNCHRONIZED_SOUND
+    /* the writes for the synchronized sound apply at once here */
+    flush_events();
+#endif
+
     /* if there are two pokeys, then the signal is stereo
        we assume even sndn */
     while(nsam >= (int) num_cur_pokeys)
@@ -2367,17 +2534,16 @@ static void mzpokeysnd_process_8(void* sndbuffer, int sndn)
             }
 #endif
 
+        for(i=0; i<num_chips; i++)
+        {
+            values[i] = generate_sample(pokey_states + i);
+        }
 #ifdef VOL_ONLY_SOUND
-        buffer[0] = (UBYTE)floor((generate_sample(pokey_states) + POKEYSND_sampout - MAX_SAMPLE / 2.0)
-         * (255.0 / MAX_SAMPLE / 4 * M_PI * 0.95) + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
-#else
-        buffer[0] = (UBYTE)floor((generate_sample(pokey_states) - MAX_SAMPLE / 2.0)
-         * (255.0 / MAX_SAMPLE / 4 * M_PI * 0.95) + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+        values[0] += POKEYSND_sampout;
 #endif
-        for(i=1; i<num_cur_pokeys; i++)
+        for(i=0; i<num_cur_pokeys; i++)
         {
-            buffer[i] = (UBYTE)floor((generate_sample(pokey_states + i) - MAX_SAMPLE / 2.0)
-             * (255.0 / MAX_SAMPLE / 4 * M_PI * 0.95) + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+            buffer[i] = quantise_8(pokey_states + i, mix_chips(values, i));
         }
         buffer += num_cur_pokeys;
         nsam -= num_cur_pokeys;
@@ -2386,6 +2552,7 @@ static void mzpokeysnd_process_8(void* sndbuffer, int sndn)
 
 static void mzpokeysnd_process_16(void* sndbuffer, int sndn)
 {
+    double values[NPOKEYS];
     int i;
     int nsam = sndn;
     SWORD *buffer = (SWORD *) sndbuffer;
@@ -2393,6 +2560,11 @@ static void mzpokeysnd_process_16(void* sndbuffer, int sndn)
     if(num_cur_pokeys<1)
         return; /* module was not initialized */
 
+#ifdef SYNCHRONIZED_SOUND
+    /* the writes for the synchronized sound apply at once here */
+    flush_events();
+#endif
+
     /* if there are two pokeys, then the signal is stereo
        we assume even sndn */
     while(nsam >= (int) num_cur_pokeys)
@@ -2415,17 +2587,16 @@ static void mzpokeysnd_process_16(void* sndbuffer, int sndn)
                 }
             }
 #endif
+        for(i=0; i<num_chips; i++)
+        {
+            values[i] = generate_sample(pokey_states + i);
+        }
 #ifdef VOL_ONLY_SOUND
-        buffer[0] = (SWORD)floor((generate_sample(pokey_states) + POKEYSND_sampout - MAX_SAMPLE / 2.0)
-         * (65535.0 / MAX_SAMPLE / 4 * M_PI * 0.95) + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
-#else
-        buffer[0] = (SWORD)floor((generate_sample(pokey_states) - MAX_SAMPLE / 2.0)
-         * (65535.0 / MAX_SAMPLE / 4 * M_PI * 0.95) + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+        values[0] += POKEYSND_sampout;
 #endif
-        for(i=1; i<num_cur_pokeys; i++)
+        for(i=0; i<num_cur_pokeys; i++)
         {
-            buffer[i] = (SWORD)floor((generate_sample(pokey_states + i) - MAX_SAMPLE / 2.0)
-             * (65535.0 / MAX_SAMPLE / 4 * M_PI * 0.95) + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+            buffer[i] = quantise_16(pokey_states + i, mix_chips(values, i));
         }
         buffer += num_cur_pokeys;
         nsam -= num_cur_pokeys;
@@ -2437,16 +2608,28 @@ void init_mzpokeysnd_sync(void)
 {
     int bytes_per_frame;
     double samples_per_frame;
+    double step;
     samples_per_frame = (double)sample_rate/((Atari800_tv_mode == Atari800_TV_PAL) ? Atari800_FPS_PAL : Atari800_FPS_NTSC);
     ticks_per_frame = Atari800_tv_mode*114;
-    ticks_per_sample = (double)ticks_per_frame / samples_per_frame;
-    tick_pos = 0;
-    bytes_per_frame = (int)ceil(num_cur_pokeys*samples_per_frame*((snd_flags & POKEYSND_BIT16) ? 2:1));
-    free(MZPOKEYSND_process_buffer);
-    MZPOKEYSND_process_buffer = (UBYTE *)Util_malloc(bytes_per_frame);
+    step = (double)ticks_per_frame / samples_per_frame;
+    /* The fraction is rounded to 32 bits, so the samples drift by less
+       than 2^-33 tick each - 0.02 tick per hour at 44100 Hz. */
+    ticks_per_sample = (int)step;
+    frac_per_sample = (ULONG)((step - ticks_per_sample) * 4294967296.0 + 0.5);
+    /* a frame has at most ceil(samples_per_frame) samples per channel */
+    bytes_per_frame = num_cur_pokeys*(int)ceil(samples_per_frame)*((snd_flags & POKEYSND_BIT16) ? 2:1);
+    if (bytes_per_frame > process_buffer_size) {
+        free(MZPOKEYSND_process_buffer);
+        MZPOKEYSND_process_buffer = (UBYTE *)Util_malloc(bytes_per_frame);
+        process_buffer_size = bytes_per_frame;
+    }
     memset(MZPOKEYSND_process_buffer, 0, bytes_per_frame);
-    tick_pos = 0;
-    samp_pos = 0.0;
+    render_start = render_pos = MZPOKEYSND_process_buffer;
+    render_end = MZPOKEYSND_process_buffer + process_buffer_size;
+    memset(chip_tick, 0, sizeof(chip_tick));
+    num_events = next_event = 0;
+    samp_tick = 0;
+    samp_frac = 0;
     start_sample = 0;
 }
 
@@ -2454,55 +2637,130 @@ void init_mzpokeysnd_sync(void)
 static void render_to_tick(int last_tick)
 {
     int i;
-    UBYTE *buffer = (UBYTE *)MZPOKEYSND_process_buffer + start_sample*((snd_flags & POKEYSND_BIT16) ? 2 : 1);
+    int bit16 = (snd_flags & POKEYSND_BIT16) != 0;
+    UBYTE *buffer = render_pos;
 
-    /* the new sample position is a floating point number that can be
-     * between two ticks */
-    double new_samp_pos;
-    int new_tick_pos;
+    /* the new sample position can be between two ticks; it is kept as
+     * an integer tick and a 32-bit fraction */
+    ULONG new_samp_frac;
+    int new_samp_tick;
+    double frac;
+    double values[NPOKEYS];
 
     if (num_cur_pokeys<1)
         return ; /* module was not initialized */
 
     do {
-        /* advance to the next sample position */
-        new_samp_pos = samp_pos + ticks_per_sample;
-        /* the next tick position is the integer part */
-        new_tick_pos = floor(new_samp_pos);
+        /* advance to the next sample position, carrying
+         * the overflow of the fraction */
+        new_samp_frac = samp_frac + frac_per_sample;
+        new_samp_tick = samp_tick + ticks_per_sample + (new_samp_frac < samp_frac);
         /* leave the loop if we went past the desired position */
-        if (new_tick_pos > last_tick) {
+        if (new_samp_tick > last_tick) {
                 break;
         }
-        for (i = 0; i<num_cur_pokeys; i++)
+        /* apply the events before the sample */
+        while (next_event < num_events && events[next_event].tick < new_samp_tick)
+            apply_event(&events[next_event++]);
+        frac = new_samp_frac * (1.0 / 4294967296.0);
+        for (i = 0; i<num_chips; i++)
         {
             /* advance pokey to the new position and produce a sample */
-            advance_ticks(pokey_states + i, new_tick_pos - tick_pos);
-            if (snd_flags & POKEYSND_BIT16) ((SWORD *)buffer)[i] = (SWORD)floor((interp_read_resam_all(pokey_states + i, new_samp_pos - new_tick_pos) - MAX_SAMPLE / 2.0)
-             * (65535.0 / MAX_SAMPLE / 4 * M_PI * 0.95) + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
-            else buffer[i] = (UBYTE)floor((interp_read_resam_all(pokey_states + i, new_samp_pos - new_tick_pos) - MAX_SAMPLE / 2.0)
-             * (255.0 / MAX_SAMPLE / 4 * M_PI * 0.95) + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+            advance_ticks(pokey_states + i, new_samp_tick - chip_tick[i]);
+            chip_tick[i] = new_samp_tick;
+            values[i] = interp_read_resam_all(pokey_states + i, frac);
         }
-        buffer += num_cur_pokeys*((snd_flags & POKEYSND_BIT16) ? 2 : 1 );
-        samp_pos = new_samp_pos;
-        tick_pos = new_tick_pos;
+        for (i = 0; i<num_cur_pokeys; i++)
+        {
+            if (bit16) ((SWORD *)buffer)[i] = quantise_16(pokey_states + i, mix_chips(values, i));
+            else buffer[i] = quantise_8(pokey_states + i, mix_chips(values, i));
+        }
+        buffer += num_cur_pokeys*(bit16 ? 2 : 1);
+        if (buffer == render_end)
+            buffer = render_start;
+        start_sample += num_cur_pokeys;
+        samp_tick = new_samp_tick;
+        samp_frac = new_samp_frac;
     } while (1);
-    /* adjust the starting sample position in the buffer for next time */
-    start_sample = (buffer - (UBYTE *)MZPOKEYSND_process_buffer)/((snd_flags & POKEYSND_BIT16) ? 2 : 1);
+    render_pos = buffer;
 }
 
-int MZPOKEYSND_UpdateProcessBuffer(void)
+/* Renders the rest of the frame and returns the number of samples in it */
+static int end_frame(void)
 {
     int result;
-    render_to_tick(ticks_per_frame);
-    samp_pos = samp_pos - (double)ticks_per_frame;
-    tick_pos = tick_pos - ticks_per_frame;
+    int i;
+    apply_events(ticks_per_frame);
+    samp_tick = samp_tick - ticks_per_frame;
+    for (i = 0; i < num_chips; i++)
+        chip_tick[i] -= ticks_per_frame;
     result = start_sample;
     start_sample = 0;
+    render_start = render_pos = MZPOKEYSND_process_buffer;
+    render_end = MZPOKEYSND_process_buffer + process_buffer_size;
+    return result;
+}
+
+int MZPOKEYSND_UpdateProcessBuffer(void)
+{
+    int result = end_frame();
 #if defined(PBI_XLD) || defined (VOICEBOX)
     VOTRAXSND_Process(MZPOKEYSND_process_buffer,result);
 #endif
 #if !defined(__PLUS) && !defined(ASAP)
     SndSave_WriteToSoundFile((const unsigned char *)MZPOKEYSND_process_buffer, result);
+#endif
+#ifdef AVI_RECORDING
+    AVIRec_Sound((const UBYTE *)MZPOKEYSND_process_buffer, result);
+#endif
+#ifdef SHM_EXPORT
+    SHMExport_Sound((const UBYTE *)MZPOKEYSND_process_buffer, result);
+#endif
+    return result;
+}
+
+int MZPOKEYSND_FrameBytes(void)
+{
+    return process_buffer_size;
+}
+
+int MZPOKEYSND_UpdateRing(UBYTE *ring, int ring_size, int pos)
+{
+    int bps = (snd_flags & POKEYSND_BIT16) ? 2 : 1;
+    /* samples rendered already, when the event queue was full */
+    int early = start_sample*bps;
+    int first;
+    int result;
+
+    first = ring_size - pos;
+    if (first > early)
+        first = early;
+    memcpy(ring + pos, MZPOKEYSND_process_buffer, first);
+    memcpy(ring, MZPOKEYSND_process_buffer + first, early - first);
+    render_start = ring;
+    render_end = ring + ring_size;
+    render_pos = ring + (pos + early)%ring_size;
+    result = end_frame();
+
+    /* the frame is FIRST bytes at POS, then the rest at the start of the
+       ring */
+    first = ring_size - pos;
+    if (first > result*bps)
+        first = result*bps;
+#if defined(PBI_XLD) || defined (VOICEBOX)
+    VOTRAXSND_Process2(ring + pos, first/bps, ring, result - first/bps);
+#endif
+#if !defined(__PLUS) && !defined(ASAP)
+    SndSave_WriteToSoundFile((const unsigned char *)ring + pos, first/bps);
+    SndSave_WriteToSoundFile((const unsigned char *)ring, result - first/bps);
+#endif
+#ifdef AVI_RECORDING
+    AVIRec_Sound((const UBYTE *)ring + pos, first/bps);
+    AVIRec_Sound((const UBYTE *)ring, result - first/bps);
+#endif
+#ifdef SHM_EXPORT
+    SHMExport_Sound((const UBYTE *)ring + pos, first/bps);
+    SHMExport_Sound((const UBYTE *)ring, result - first/bps);
 #endif
     return result;
 }
@@ -2550,11 +2808,8 @@ static void Update_consol_sound_mz( int set )
 {
 #ifdef SYNCHRONIZED_SOUND
     if (!POKEYSND_console_sound_enabled) return;
-    if (set) { /* The set variable is 0 only in VOL_ONLY_SOUND routines */
-	Update_synchronized_sound();
-	pokey_states[0].speaker = GTIA_speaker*CONSOLE_VOL;
-	pokey_states[0].forcero = 1; /* first chip */
-    }
+    if (set) /* The set variable is 0 only in VOL_ONLY_SOUND routines */
+	queue_event(0, EVENT_SPEAKER, GTIA_speaker*CONSOLE_VOL); /* first chip */
 #else /* SYNCHRONIZED_SOUND */
 #ifdef VOL_ONLY_SOUND
   static int prev_atari_speaker=0;
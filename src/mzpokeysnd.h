@@ -18,5 +18,12 @@ int MZPOKEYSND_Init(ULONG freq17,
 #ifdef SYNCHRONIZED_SOUND
 #endif /* SYNCHRONIZED_SOUND */
 int MZPOKEYSND_UpdateProcessBuffer(void);
+/* Renders the frame straight into RING, a ring buffer of RING_SIZE bytes,
+   at byte offset POS, wrapping around its end, instead of into
+   MZPOKEYSND_process_buffer. There must be room for the largest frame.
+   Returns the number of samples rendered. */
+int MZPOKEYSND_UpdateRing(UBYTE *ring, int ring_size, int pos);
+/* Returns the size of the largest frame in bytes */
+int MZPOKEYSND_FrameBytes(void);
 extern UBYTE *MZPOKEYSND_process_buffer;
 #endif /* MZPOKEYSND_H_ */
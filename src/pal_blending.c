@@ -24,12 +24,15 @@
 
 #include "pal_blending.h"
 
+#include <string.h>
+
 #include "artifact.h"
 #include "atari.h"
 #include "colours.h"
 #include "colours_pal.h"
 #include "platform.h"
 #include "screen.h"
+#include "util.h"
 
 #if SUPPORTS_CHANGE_VIDEOMODE
 #include "videomode.h"
@@ -121,73 +124,149 @@ void PAL_BLENDING_Blit16(ULONG *dest, UBYTE *src, int pitch, int width, int heig
 	}
 }
 
+/* Blends one line of SRC with the previous line SRC_PREV into DEST. */
+static void BlendLine32(ULONG *dest, const UBYTE *src, const UBYTE *src_prev, int width, int odd)
+{
+	const ULONG *pal = palette.bpp32[odd];
+	const ULONG *pal_prev = palette.bpp32[odd ^ 1];
+	ULONG mask = shift_mask;
+	int pos;
+	for (pos = 0; pos < width; pos++) {
+		UBYTE c = src[pos];
+		/* Make QUAD_PREV have the same Y component as the current line's pixel. */
+		ULONG quad_prev = pal_prev[(src_prev[pos] & 0xf0) | (c & 0x0f)];
+		ULONG quad = pal[c];
+		/* Since QUAD_PREV and QUAD have the same Y component, computing
+		   averages of even U/V and odd U/V is equal to computing averages
+		   of even and odd RGB components. */
+		/* dest[pos] = ((quad+quad_prev) & shift_mask)/2; */
+		dest[pos] = (quad & quad_prev) + (((quad ^ quad_prev) & mask) >> 1);
+	}
+}
+
+/* Like BlendLine32, for 16-bit colours. */
+static void BlendLine16(UWORD *dest, const UBYTE *src, const UBYTE *src_prev, int width, int odd)
+{
+	const UWORD *pal = palette.bpp16[odd];
+	const UWORD *pal_prev = palette.bpp16[odd ^ 1];
+	ULONG mask = shift_mask & 0xffff;
+	int pos;
+	for (pos = 0; pos < width; pos++) {
+		UBYTE c = src[pos];
+		ULONG quad_prev = pal_prev[(src_prev[pos] & 0xf0) | (c & 0x0f)];
+		ULONG quad = pal[c];
+		dest[pos] = (UWORD) ((quad & quad_prev) + (((quad ^ quad_prev) & mask) >> 1));
+	}
+}
+
 void PAL_BLENDING_Blit32(ULONG *dest, UBYTE *src, int pitch, int width, int height, int start_odd)
 {
-	register ULONG quad, quad_prev;
-	register UBYTE c;
-	register int pos;
 	UBYTE *src_prev = src;
-	int odd_prev = start_odd ^ 1;
 	while (height > 0) {
-		pos = width;
-		do {
-			pos--;
-			c = src[pos];
-			/* Make QUAD_PREV have the same Y component as the current line's pixel. */
-			quad_prev = palette.bpp32[odd_prev][(src_prev[pos] & 0xf0) | (c & 0x0f)];
-			quad = palette.bpp32[start_odd][c];
-			/* Since QUAD_PREV and QUAD have the same Y component, computing
-			   averages of even U/V and odd U/V is equal to computing averages
-			   of even and odd RGB components. */
-			/* dest[pos] = ((quad+quad_prev) & shift_mask)/2; */
-			dest[pos] = (quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1);
-		} while (pos > 0);
+		BlendLine32(dest, src, src_prev, width, start_odd);
 		src_prev = src;
 		src += Screen_WIDTH;
 		dest += pitch;
 		height--;
 		start_odd ^= 1;
-		odd_prev ^= 1;
+	}
+}
+
+/* The scaled blits blend each source line once into blended_line, scale it
+   into scaled_line and copy that to all destination lines that show
+   the source line. */
+static union {
+	UWORD bpp16[Screen_WIDTH];
+	ULONG bpp32[Screen_WIDTH];
+} blended_line;
+static ULONG *scaled_line = NULL;
+static int scaled_line_size = 0;
+
+static ULONG *GetScaledLine(int size)
+{
+	if (size > scaled_line_size) {
+		scaled_line_size = size;
+		scaled_line = (ULONG *) Util_realloc(scaled_line, size * sizeof(ULONG));
+	}
+	return scaled_line;
+}
+
+/* Scales blended_line.bpp32 (WIDTH pixels) to DEST_WIDTH pixels. */
+static void ScaleLine32(ULONG *dest, int width, int dest_width)
+{
+	const ULONG *src = blended_line.bpp32;
+	int pos;
+	if (dest_width == 2 * width) {
+		for (pos = 0; pos < width; pos++) {
+			dest[0] = dest[1] = src[pos];
+			dest += 2;
+		}
+	}
+	else if (dest_width == 3 * width) {
+		for (pos = 0; pos < width; pos++) {
+			dest[0] = dest[1] = dest[2] = src[pos];
+			dest += 3;
+		}
+	}
+	else {
+		int x = (width << 16) - 0x4000;
+		int dx = (width << 16) / dest_width;
+		for (pos = dest_width - 1; pos >= 0; pos--) {
+			dest[pos] = src[x >> 16];
+			x -= dx;
+		}
+	}
+}
+
+/* Scales blended_line.bpp16 (WIDTH pixels) to DEST_WIDTH pixels,
+   two in each ULONG. */
+static void ScaleLine16(ULONG *dest, int width, int dest_width)
+{
+	const UWORD *src = blended_line.bpp16;
+	int pos;
+	if (dest_width == 2 * width) {
+		for (pos = 0; pos < width; pos++)
+			dest[pos] = ((ULONG) src[pos] << 16) | src[pos];
+	}
+	else if (dest_width == 3 * width && (width & 1) == 0) {
+		/* three ULONGs for two source pixels */
+		for (pos = 0; pos < width; pos += 2) {
+			ULONG c0 = src[pos];
+			ULONG c1 = src[pos + 1];
+			dest[0] = (c0 << 16) | c0;
+			dest[1] = (c1 << 16) | c0;
+			dest[2] = (c1 << 16) | c1;
+			dest += 3;
+		}
+	}
+	else {
+		int x = (width << 16) - 0x4000;
+		int dx = (width << 16) / dest_width;
+		for (pos = dest_width / 2 - 1; pos >= 0; pos--) {
+			ULONG quad = (ULONG) src[x >> 16] << 16;
+			x -= dx;
+			dest[pos] = quad | src[x >> 16];
+			x -= dx;
+		}
 	}
 }
 
 void PAL_BLENDING_BlitScaled16(ULONG *dest, UBYTE *src, int pitch, int width, int height, int dest_width, int dest_height, int start_odd)
 {
-	register ULONG quad, quad_prev;
-	register int x;
 	int y = 0x10000;
-	int w1 = dest_width / 2 - 1;
-	int w = width << 16;
-	int h = height << 16;
-	int pos;
-	register int dx = w / dest_width;
-	int dy = h / dest_height;
-	int init_x = (width << 16) - 0x4000;
+	int dy = (height << 16) / dest_height;
 	UBYTE *src_prev = src;
-	int odd_prev = start_odd ^ 1;
-
-	UBYTE c;
+	int line_size = dest_width / 2;
+	ULONG *line = GetScaledLine(line_size);
+	int line_ready = FALSE;
 
 	while (dest_height > 0) {
-		x = init_x;
-		pos = w1;
-		while (pos >= 0) {
-			c = src[x >> 16];
-			/* Make QUAD_PREV have the same Y component as the current line's pixel. */
-			quad_prev = palette.bpp16[odd_prev][(src_prev[x >> 16] & 0xf0) | (c & 0x0f)] << 16;
-			quad = palette.bpp16[start_odd][c] << 16;
-			x -= dx;
-			c = src[x >> 16];
-			quad_prev |= palette.bpp16[odd_prev][(src_prev[x >> 16] & 0xf0) | (c & 0x0f)];
-			quad |= palette.bpp16[start_odd][c];
-			x -= dx;
-			/* Since QUAD_PREV and QUAD have the same Y component, computing
-			   averages of even U/V and odd U/V is equal to computing averages
-			   of even and odd RGB components. */
-			/* dest[pos] = ((quad+quad_prev) & shift_mask)/2; */
-			dest[pos] = (quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1);
-			pos--;
+		if (!line_ready) {
+			BlendLine16(blended_line.bpp16, src, src_prev, width, start_odd);
+			ScaleLine16(line, width, dest_width);
+			line_ready = TRUE;
 		}
+		memcpy(dest, line, line_size * sizeof(ULONG));
 		dest += pitch;
 		y -= dy;
 		--dest_height;
@@ -196,44 +275,26 @@ void PAL_BLENDING_BlitScaled16(ULONG *dest, UBYTE *src, int pitch, int width, in
 			src_prev = src;
 			src += Screen_WIDTH;
 			start_odd ^= 1;
-			odd_prev ^= 1;
+			line_ready = FALSE;
 		}
 	}
 }
 
 void PAL_BLENDING_BlitScaled32(ULONG *dest, UBYTE *src, int pitch, int width, int height, int dest_width, int dest_height, int start_odd)
 {
-	register ULONG quad, quad_prev;
-	register int x;
 	int y = 0x10000;
-	int w1 = dest_width - 1;
-	int w = width << 16;
-	int h = height << 16;
-	int pos;
-	register int dx = w / dest_width;
-	int dy = h / dest_height;
-	int init_x = w - 0x4000;
+	int dy = (height << 16) / dest_height;
 	UBYTE *src_prev = src;
-	int odd_prev = start_odd ^ 1;
-
-	UBYTE c;
+	ULONG *line = GetScaledLine(dest_width);
+	int line_ready = FALSE;
 
 	while (dest_height > 0) {
-		x = init_x;
-		pos = w1;
-		while (pos >= 0) {
-			c = src[x >> 16];
-			/* Make QUAD_PREV have the same Y component as the current line's pixel. */
-			quad_prev = palette.bpp32[odd_prev][(src_prev[x >> 16] & 0xf0) | (c & 0x0f)];
-			quad = palette.bpp32[start_odd][c];
-			x -= dx;
-			/* Since QUAD_PREV and QUAD have the same Y component, computing
-			   averages of even U/V and odd U/V is equal to computing averages
-			   of even and odd RGB components. */
-			/* dest[pos] = ((quad+quad_prev) & shift_mask)/2; */
-			dest[pos] = (quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1);
-			pos--;
+		if (!line_ready) {
+			BlendLine32(blended_line.bpp32, src, src_prev, width, start_odd);
+			ScaleLine32(line, width, dest_width);
+			line_ready = TRUE;
 		}
+		memcpy(dest, line, dest_width * sizeof(ULONG));
 		dest += pitch;
 		y -= dy;
 		--dest_height;
@@ -242,7 +303,7 @@ void PAL_BLENDING_BlitScaled32(ULONG *dest, UBYTE *src, int pitch, int width, in
 			src_prev = src;
 			src += Screen_WIDTH;
 			start_odd ^= 1;
-			odd_prev ^= 1;
+			line_ready = FALSE;
 		}
 	}
 }
@@ -39,6 +39,16 @@ static char proto80_rom_filename[FILENAME_MAX];
 
 int PBI_PROTO80_enabled = FALSE;
 
+#define PROTO80_ROWS 24
+#define PROTO80_CELL_HEIGHT 8
+#define PROTO80_SCREEN 0x9800
+#define PROTO80_FONT 0xe000
+
+UBYTE PBI_PROTO80_scanline_dirty[PBI_PROTO80_SCRN_HEIGHT];
+/* Copies of the screen and the font as of the last PBI_PROTO80_FindChanges. */
+static UBYTE shown_screen[PROTO80_ROWS * 80];
+static UBYTE shown_font[128 * PROTO80_CELL_HEIGHT];
+
 #ifdef PBI_DEBUG
 #define D(a) a
 #else
@@ -124,10 +134,25 @@ int PBI_PROTO80_D1ffPutByte(UBYTE byte)
 	return result;
 }
 
+void PBI_PROTO80_FindChanges(void)
+{
+	int row;
+	if (memcmp(shown_font, MEMORY_mem + PROTO80_FONT, sizeof(shown_font)) != 0) {
+		memcpy(shown_font, MEMORY_mem + PROTO80_FONT, sizeof(shown_font));
+		memcpy(shown_screen, MEMORY_mem + PROTO80_SCREEN, sizeof(shown_screen));
+		memset(PBI_PROTO80_scanline_dirty, 1, PBI_PROTO80_SCRN_HEIGHT);
+		return;
+	}
+	for (row = 0; row < PROTO80_ROWS; row++) {
+		if (memcmp(shown_screen + row * 80, MEMORY_mem + PROTO80_SCREEN + row * 80, 80) != 0) {
+			memcpy(shown_screen + row * 80, MEMORY_mem + PROTO80_SCREEN + row * 80, 80);
+			memset(PBI_PROTO80_scanline_dirty + row * PROTO80_CELL_HEIGHT, 1, PROTO80_CELL_HEIGHT);
+		}
+	}
+}
+
 UBYTE PBI_PROTO80_GetPixels(int scanline, int column)
 {
-#define PROTO80_ROWS 24
-#define PROTO80_CELL_HEIGHT 8
 	UBYTE character;
 	UBYTE invert;
 	UBYTE font_data;
@@ -136,13 +161,13 @@ UBYTE PBI_PROTO80_GetPixels(int scanline, int column)
 	if (row  >= PROTO80_ROWS) {
 		return 0;
 	}
-	character = MEMORY_mem[0x9800 + row*80 + column];
+	character = MEMORY_mem[PROTO80_SCREEN + row*80 + column];
 	invert = 0x00;
 	if (character & 0x80) {
 		invert = 0xff;
 		character &= 0x7f;
 	}
-	font_data = MEMORY_mem[0xe000 + character*8 + line];
+	font_data = MEMORY_mem[PROTO80_FONT + character*8 + line];
 	font_data ^= invert;
 	return font_data;
 }
@@ -10,6 +10,15 @@ int PBI_PROTO80_D1GetByte(UWORD addr, int no_side_effects);
 void PBI_PROTO80_D1PutByte(UWORD addr, UBYTE byte);
 int PBI_PROTO80_D1ffPutByte(UBYTE byte);
 UBYTE PBI_PROTO80_GetPixels(int scanline, int column);
+
+#define PBI_PROTO80_SCRN_HEIGHT 192
+
+/* One entry for each line returned by PBI_PROTO80_GetPixels, set to 1 when
+   the line changes. The board's screen is in plain RAM, so changes are
+   found by PBI_PROTO80_FindChanges, which platform code calls before
+   displaying the screen and clears the entries after that. */
+extern UBYTE PBI_PROTO80_scanline_dirty[PBI_PROTO80_SCRN_HEIGHT];
+void PBI_PROTO80_FindChanges(void);
 extern int PBI_PROTO80_enabled;
 
 #endif /* PBI_PROTO80_H_ */
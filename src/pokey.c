@@ -49,6 +49,7 @@
 #include "log.h"
 #include "input.h"
 #include "pbi.h"
+#include "sched.h"
 
 #ifdef VOICEBOX
 #include "voicebox.h"
@@ -65,15 +66,12 @@ UBYTE POKEY_IRQST;
 UBYTE POKEY_IRQEN;
 UBYTE POKEY_SKSTAT;
 UBYTE POKEY_SKCTL;
-int POKEY_DELAYED_SERIN_IRQ;
-int POKEY_DELAYED_SEROUT_IRQ;
-int POKEY_DELAYED_XMTDONE_IRQ;
 
 /* structures to hold the 9 pokey control bytes */
 UBYTE POKEY_AUDF[4 * POKEY_MAXPOKEYS];	/* AUDFx (D200, D202, D204, D206) */
 UBYTE POKEY_AUDC[4 * POKEY_MAXPOKEYS];	/* AUDCx (D201, D203, D205, D207) */
 UBYTE POKEY_AUDCTL[POKEY_MAXPOKEYS];	/* AUDCTL (D208) */
-int POKEY_DivNIRQ[4], POKEY_DivNMax[4];
+int POKEY_DivNMax[4];
 int POKEY_Base_mult[POKEY_MAXPOKEYS];		/* selects either 64Khz or 15Khz clock mult */
 
 UBYTE POKEY_POT_input[8] = {228, 228, 228, 228, 228, 228, 228, 228};
@@ -83,6 +81,22 @@ UBYTE POKEY_poly9_lookup[511];
 UBYTE POKEY_poly17_lookup[16385];
 static ULONG random_scanline_counter;
 
+/* The serial port IRQs and the timers are events of the scheduler while
+   POKEY runs. In reset mode they stop, and what remains of them is kept
+   here as in the old per-scanline countdowns: the serial delays in
+   scanlines (0 if no IRQ is pending) and the timer counts in cycles
+   (an IRQ comes when the count goes below 0). */
+static int serin_delay;
+static int serout_delay;
+static int xmtdone_delay;
+static int timer_count[4];
+
+static const int timer_event[3] = { SCHED_POKEY_TIMER1, SCHED_POKEY_TIMER2, SCHED_POKEY_TIMER4 };
+static const int timer_chan[3] = { POKEY_CHAN1, POKEY_CHAN2, POKEY_CHAN4 };
+static const UBYTE timer_irq[3] = { 0x01, 0x02, 0x04 };
+
+#define RUNNING ((POKEY_SKCTL & 0x03) != 0)
+
 ULONG POKEY_GetRandomCounter(void)
 {
 	return random_scanline_counter;
@@ -93,12 +107,166 @@ void POKEY_SetRandomCounter(ULONG value)
 	random_scanline_counter = value;
 }
 
+static void SerinIRQ(unsigned int time)
+{
+	/* Load a byte to SERIN - even when the IRQ is disabled. */
+	POKEY_SERIN = SIO_GetByte();
+	if (POKEY_IRQEN & 0x20) {
+		if (POKEY_IRQST & 0x20) {
+			POKEY_IRQST &= 0xdf;
+#ifdef DEBUG2
+			printf("SERIO: SERIN Interrupt triggered, bytevalue %02x\n", POKEY_SERIN);
+#endif
+		}
+		else {
+			POKEY_SKSTAT &= 0xdf;
+#ifdef DEBUG2
+			printf("SERIO: SERIN Interrupt triggered, bytevalue %02x\n", POKEY_SERIN);
+#endif
+		}
+		CPU_GenerateIRQ();
+	}
+#ifdef DEBUG2
+	else {
+		printf("SERIO: SERIN Interrupt missed, bytevalue %02x\n", POKEY_SERIN);
+	}
+#endif
+}
+
+static void SeroutIRQ(unsigned int time)
+{
+	if (POKEY_IRQEN & 0x10) {
+#ifdef DEBUG2
+		printf("SERIO: SEROUT Interrupt triggered\n");
+#endif
+		POKEY_IRQST &= 0xef;
+		CPU_GenerateIRQ();
+	}
+#ifdef DEBUG2
+	else {
+		printf("SERIO: SEROUT Interrupt missed\n");
+	}
+#endif
+}
+
+static void XmtdoneIRQ(unsigned int time)
+{
+	POKEY_IRQST &= 0xf7;
+	if (POKEY_IRQEN & 0x08) {
+#ifdef DEBUG2
+		printf("SERIO: XMTDONE Interrupt triggered\n");
+#endif
+		CPU_GenerateIRQ();
+	}
+#ifdef DEBUG2
+	else
+		printf("SERIO: XMTDONE Interrupt missed\n");
+#endif
+}
+
+static void TimerIRQ(int i, unsigned int time)
+{
+	/* The timer reloads with the current AUDF. It is checked on each
+	   scanline, so a period below one scanline (before AUDF is set)
+	   gives an IRQ on every scanline. */
+	unsigned int next = time + POKEY_DivNMax[timer_chan[i]];
+	if ((int) (next - ANTIC_screenline_cpu_clock) <= 0)
+		next = ANTIC_screenline_cpu_clock + 1;
+	SCHED_Add(timer_event[i], next);
+	if (POKEY_IRQEN & timer_irq[i]) {
+		POKEY_IRQST &= ~timer_irq[i];
+		CPU_GenerateIRQ();
+	}
+}
+
+static void Timer1IRQ(unsigned int time)
+{
+	TimerIRQ(0, time);
+}
+
+static void Timer2IRQ(unsigned int time)
+{
+	TimerIRQ(1, time);
+}
+
+static void Timer4IRQ(unsigned int time)
+{
+	TimerIRQ(2, time);
+}
+
+/* Sets the IRQ of a serial port EVENT to come SCANLINES scanlines after the
+   current one, or cancels it if SCANLINES <= 0. *DELAY holds it in reset
+   mode. */
+static void SetSerialDelay(int event, int *delay, int scanlines)
+{
+	if (scanlines <= 0)
+		scanlines = 0;
+	if (!RUNNING)
+		*delay = scanlines;
+	else if (scanlines > 0)
+		SCHED_Add(event, ANTIC_screenline_cpu_clock + scanlines * ANTIC_LINE_C);
+	else
+		SCHED_Remove(event);
+}
+
+void POKEY_SetSerinDelay(int scanlines)
+{
+	SetSerialDelay(SCHED_POKEY_SERIN, &serin_delay, scanlines);
+}
+
+static int SerialDelay(int event, unsigned int line)
+{
+	unsigned int time;
+	if (!SCHED_Pending(event, &time))
+		return 0;
+	return (int) (time - line) / ANTIC_LINE_C;
+}
+
+/* Converts the pending events to the delays and counts. LINE is the start
+   of the last scanline that POKEY_Scanline() has processed. */
+static void StoreEvents(unsigned int line)
+{
+	int i;
+	unsigned int time;
+	serin_delay = SerialDelay(SCHED_POKEY_SERIN, line);
+	serout_delay = SerialDelay(SCHED_POKEY_SEROUT, line);
+	xmtdone_delay = SerialDelay(SCHED_POKEY_XMTDONE, line);
+	for (i = 0; i < 3; i++)
+		if (SCHED_Pending(timer_event[i], &time))
+			timer_count[timer_chan[i]] = (int) (time - line) - 1;
+}
+
+/* Schedules the events from the delays and counts. */
+static void StartEvents(unsigned int line)
+{
+	int i;
+	if (serin_delay > 0)
+		SCHED_Add(SCHED_POKEY_SERIN, line + serin_delay * ANTIC_LINE_C);
+	if (serout_delay > 0)
+		SCHED_Add(SCHED_POKEY_SEROUT, line + serout_delay * ANTIC_LINE_C);
+	if (xmtdone_delay > 0)
+		SCHED_Add(SCHED_POKEY_XMTDONE, line + xmtdone_delay * ANTIC_LINE_C);
+	for (i = 0; i < 3; i++)
+		SCHED_Add(timer_event[i], line + timer_count[timer_chan[i]] + 1);
+}
+
+static void RemoveEvents(void)
+{
+	int i;
+	SCHED_Remove(SCHED_POKEY_SERIN);
+	SCHED_Remove(SCHED_POKEY_SEROUT);
+	SCHED_Remove(SCHED_POKEY_XMTDONE);
+	for (i = 0; i < 3; i++)
+		SCHED_Remove(timer_event[i]);
+}
+
 UBYTE POKEY_GetByte(UWORD addr, int no_side_effects)
 {
 	UBYTE byte = 0xff;
 
 #ifdef STEREO_SOUND
-	if (addr & 0x0010 && POKEYSND_stereo_enabled)
+	/* the other chips only have sound registers */
+	if ((addr >> 4) & (POKEYSND_NumChips() - 1))
 		return 0;
 #endif
 	addr &= 0x0f;
@@ -178,10 +346,53 @@ static int POKEY_siocheck(void)
 #define POKEYSND_Update(addr, val, chip, gain)
 #endif
 
+#ifdef STEREO_SOUND
+/* Writes to a register of the second, third or fourth chip. Only their
+   sound registers are emulated. */
+static void PutByteExtraChip(int chip, UWORD addr, UBYTE byte)
+{
+	switch (addr) {
+	case POKEY_OFFSET_AUDF1:
+	case POKEY_OFFSET_AUDF2:
+	case POKEY_OFFSET_AUDF3:
+	case POKEY_OFFSET_AUDF4:
+		POKEY_AUDF[chip * 4 + (addr >> 1)] = byte;
+		break;
+	case POKEY_OFFSET_AUDC1:
+	case POKEY_OFFSET_AUDC2:
+	case POKEY_OFFSET_AUDC3:
+	case POKEY_OFFSET_AUDC4:
+		POKEY_AUDC[chip * 4 + (addr >> 1)] = byte;
+		break;
+	case POKEY_OFFSET_AUDCTL:
+		POKEY_AUDCTL[chip] = byte;
+		/* determine the base multiplier for the 'div by n' calculations */
+		if (byte & POKEY_CLOCK_15)
+			POKEY_Base_mult[chip] = POKEY_DIV_15;
+		else
+			POKEY_Base_mult[chip] = POKEY_DIV_64;
+		break;
+	case POKEY_OFFSET_STIMER:
+	case POKEY_OFFSET_SKCTL:
+		break;
+	default:
+		return;
+	}
+	POKEYSND_Update(addr, byte, (UBYTE) chip, SOUND_GAIN);
+}
+#endif /* STEREO_SOUND */
+
 void POKEY_PutByte(UWORD addr, UBYTE byte)
 {
+	int i;
 #ifdef STEREO_SOUND
-	addr &= POKEYSND_stereo_enabled ? 0x1f : 0x0f;
+	/* A4 selects the second chip, A5 the third and fourth with quad POKEY. */
+	int chip = (addr >> 4) & (POKEYSND_NumChips() - 1);
+	addr &= 0x0f;
+	if (chip != 0) {
+		PutByteExtraChip(chip, addr, byte);
+		return;
+	}
 #else
 	addr &= 0x0f;
 #endif
@@ -261,23 +472,24 @@ void POKEY_PutByte(UWORD addr, UBYTE byte)
 		/* check if cassette 2-tone mode has been enabled */
 		if ((POKEY_SKCTL & 0x08) == 0x00) {
 			/* intelligent device */
-			POKEY_DELAYED_SEROUT_IRQ = SIO_SEROUT_INTERVAL;
+			SetSerialDelay(SCHED_POKEY_SEROUT, &serout_delay, SIO_SEROUT_INTERVAL);
 			POKEY_IRQST |= 0x08;
-			POKEY_DELAYED_XMTDONE_IRQ = SIO_XMTDONE_INTERVAL;
+			SetSerialDelay(SCHED_POKEY_XMTDONE, &xmtdone_delay, SIO_XMTDONE_INTERVAL);
 		}
 		else {
 			/* cassette */
 			/* some savers patch the cassette baud rate, so we evaluate it here */
 			/* scanlines per second*10 bit*audiofrequency/(1.79 MHz/2) */
-                        POKEY_DELAYED_SEROUT_IRQ = 312*50*10*(POKEY_AUDF[POKEY_CHAN3] + POKEY_AUDF[POKEY_CHAN4]*0x100)/895000;
+			int delay = 312*50*10*(POKEY_AUDF[POKEY_CHAN3] + POKEY_AUDF[POKEY_CHAN4]*0x100)/895000;
 			/* safety check */
-			if (POKEY_DELAYED_SEROUT_IRQ >= 3) {
-                        	POKEY_IRQST |= 0x08;
-                        	POKEY_DELAYED_XMTDONE_IRQ = 2*POKEY_DELAYED_SEROUT_IRQ - 2;
+			if (delay >= 3) {
+				POKEY_IRQST |= 0x08;
+				SetSerialDelay(SCHED_POKEY_SEROUT, &serout_delay, delay);
+				SetSerialDelay(SCHED_POKEY_XMTDONE, &xmtdone_delay, 2*delay - 2);
 			}
 			else {
-				POKEY_DELAYED_SEROUT_IRQ = 0;
-				POKEY_DELAYED_XMTDONE_IRQ = 0;
+				SetSerialDelay(SCHED_POKEY_SEROUT, &serout_delay, 0);
+				SetSerialDelay(SCHED_POKEY_XMTDONE, &xmtdone_delay, 0);
 			}
 		};
 #ifdef SERIO_SOUND
@@ -285,9 +497,11 @@ void POKEY_PutByte(UWORD addr, UBYTE byte)
 #endif
 		break;
 	case POKEY_OFFSET_STIMER:
-		POKEY_DivNIRQ[POKEY_CHAN1] = POKEY_DivNMax[POKEY_CHAN1];
-		POKEY_DivNIRQ[POKEY_CHAN2] = POKEY_DivNMax[POKEY_CHAN2];
-		POKEY_DivNIRQ[POKEY_CHAN4] = POKEY_DivNMax[POKEY_CHAN4];
+		for (i = 0; i < 3; i++) {
+			timer_count[timer_chan[i]] = POKEY_DivNMax[timer_chan[i]];
+			if (RUNNING)
+				SCHED_Add(timer_event[i], ANTIC_screenline_cpu_clock + timer_count[timer_chan[i]] + 1);
+		}
 		POKEYSND_Update(POKEY_OFFSET_STIMER, byte, 0, SOUND_GAIN);
 #ifdef DEBUG1
 		printf("WR: STIMER = %x\n", byte);
@@ -297,6 +511,12 @@ void POKEY_PutByte(UWORD addr, UBYTE byte)
 #ifdef VOICEBOX
 		VOICEBOX_SKCTLPutByte(byte);
 #endif
+		if (RUNNING && (byte & 0x03) == 0) {
+			StoreEvents(ANTIC_screenline_cpu_clock);
+			RemoveEvents();
+		}
+		else if (!RUNNING && (byte & 0x03) != 0)
+			StartEvents(ANTIC_screenline_cpu_clock);
 		POKEY_SKCTL = byte;
 		POKEYSND_Update(POKEY_OFFSET_SKCTL, byte, 0, SOUND_GAIN);
 		if (byte & 4)
@@ -304,63 +524,13 @@ void POKEY_PutByte(UWORD addr, UBYTE byte)
 		if ((byte & 0x03) == 0) {
 			/* POKEY reset. */
 			/* Stop serial IO. */
-			POKEY_DELAYED_SERIN_IRQ = 0;
-			POKEY_DELAYED_SEROUT_IRQ = 0;
-			POKEY_DELAYED_XMTDONE_IRQ = 0;
+			serin_delay = 0;
+			serout_delay = 0;
+			xmtdone_delay = 0;
 			CASSETTE_ResetPOKEY();
 			/* TODO other registers should also be reset. */
 		}
 		break;
-#ifdef STEREO_SOUND
-	case POKEY_OFFSET_AUDC1 + POKEY_OFFSET_POKEY2:
-		POKEY_AUDC[POKEY_CHAN1 + POKEY_CHIP2] = byte;
-		POKEYSND_Update(POKEY_OFFSET_AUDC1, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_AUDC2 + POKEY_OFFSET_POKEY2:
-		POKEY_AUDC[POKEY_CHAN2 + POKEY_CHIP2] = byte;
-		POKEYSND_Update(POKEY_OFFSET_AUDC2, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_AUDC3 + POKEY_OFFSET_POKEY2:
-		POKEY_AUDC[POKEY_CHAN3 + POKEY_CHIP2] = byte;
-		POKEYSND_Update(POKEY_OFFSET_AUDC3, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_AUDC4 + POKEY_OFFSET_POKEY2:
-		POKEY_AUDC[POKEY_CHAN4 + POKEY_CHIP2] = byte;
-		POKEYSND_Update(POKEY_OFFSET_AUDC4, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_AUDCTL + POKEY_OFFSET_POKEY2:
-		POKEY_AUDCTL[1] = byte;
-		/* determine the base multiplier for the 'div by n' calculations */
-		if (byte & POKEY_CLOCK_15)
-			POKEY_Base_mult[1] = POKEY_DIV_15;
-		else
-			POKEY_Base_mult[1] = POKEY_DIV_64;
-
-		POKEYSND_Update(POKEY_OFFSET_AUDCTL, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_AUDF1 + POKEY_OFFSET_POKEY2:
-		POKEY_AUDF[POKEY_CHAN1 + POKEY_CHIP2] = byte;
-		POKEYSND_Update(POKEY_OFFSET_AUDF1, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_AUDF2 + POKEY_OFFSET_POKEY2:
-		POKEY_AUDF[POKEY_CHAN2 + POKEY_CHIP2] = byte;
-		POKEYSND_Update(POKEY_OFFSET_AUDF2, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_AUDF3 + POKEY_OFFSET_POKEY2:
-		POKEY_AUDF[POKEY_CHAN3 + POKEY_CHIP2] = byte;
-		POKEYSND_Update(POKEY_OFFSET_AUDF3, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_AUDF4 + POKEY_OFFSET_POKEY2:
-		POKEY_AUDF[POKEY_CHAN4 + POKEY_CHIP2] = byte;
-		POKEYSND_Update(POKEY_OFFSET_AUDF4, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_STIMER + POKEY_OFFSET_POKEY2:
-		POKEYSND_Update(POKEY_OFFSET_STIMER, byte, 1, SOUND_GAIN);
-		break;
-	case POKEY_OFFSET_SKCTL + POKEY_OFFSET_POKEY2:
-		POKEYSND_Update(POKEY_OFFSET_SKCTL, byte, 1, SOUND_GAIN);
-		break;
-#endif
 	}
 }
 
@@ -370,9 +540,15 @@ int POKEY_Initialise(int *argc, char *argv[])
 	ULONG reg;
 
 	/* Initialise Serial Port Interrupts */
-	POKEY_DELAYED_SERIN_IRQ = 0;
-	POKEY_DELAYED_SEROUT_IRQ = 0;
-	POKEY_DELAYED_XMTDONE_IRQ = 0;
+	serin_delay = 0;
+	serout_delay = 0;
+	xmtdone_delay = 0;
+	SCHED_SetHandler(SCHED_POKEY_SERIN, SerinIRQ);
+	SCHED_SetHandler(SCHED_POKEY_SEROUT, SeroutIRQ);
+	SCHED_SetHandler(SCHED_POKEY_XMTDONE, XmtdoneIRQ);
+	SCHED_SetHandler(SCHED_POKEY_TIMER1, Timer1IRQ);
+	SCHED_SetHandler(SCHED_POKEY_TIMER2, Timer2IRQ);
+	SCHED_SetHandler(SCHED_POKEY_TIMER4, Timer4IRQ);
 
 	POKEY_KBCODE = 0xff;
 	POKEY_SERIN = 0x00;	/* or 0xff ? */
@@ -392,7 +568,7 @@ int POKEY_Initialise(int *argc, char *argv[])
 	}
 
 	for (i = 0; i < 4; i++)
-		POKEY_DivNIRQ[i] = POKEY_DivNMax[i] = 0;
+		timer_count[i] = POKEY_DivNMax[i] = 0;
 
 	pot_scanline = 0;
 
@@ -463,11 +639,16 @@ void POKEY_Scanline(void)
 
 	/* on nonpatched i/o-operation, enable the cassette timing */
 	if (!ESC_enable_sio_patch) {
-		if (CASSETTE_AddScanLine())
-			POKEY_DELAYED_SERIN_IRQ = 1;
+		if (CASSETTE_AddScanLine()) {
+			/* SERIN IRQ on this scanline */
+			if (RUNNING)
+				SCHED_Add(SCHED_POKEY_SERIN, ANTIC_screenline_cpu_clock);
+			else
+				serin_delay = 1;
+		}
 	}
 
-	if ((POKEY_SKCTL & 0x03) == 0)
+	if (!RUNNING)
 		/* Don't process timers when POKEY is in reset mode. */
 		return;
 
@@ -476,88 +657,8 @@ void POKEY_Scanline(void)
 
 	random_scanline_counter += ANTIC_LINE_C;
 
-	if (POKEY_DELAYED_SERIN_IRQ > 0) {
-		if (--POKEY_DELAYED_SERIN_IRQ == 0) {
-			/* Load a byte to SERIN - even when the IRQ is disabled. */
-			POKEY_SERIN = SIO_GetByte();
-			if (POKEY_IRQEN & 0x20) {
-				if (POKEY_IRQST & 0x20) {
-					POKEY_IRQST &= 0xdf;
-#ifdef DEBUG2
-					printf("SERIO: SERIN Interrupt triggered, bytevalue %02x\n", POKEY_SERIN);
-#endif
-				}
-				else {
-					POKEY_SKSTAT &= 0xdf;
-#ifdef DEBUG2
-					printf("SERIO: SERIN Interrupt triggered, bytevalue %02x\n", POKEY_SERIN);
-#endif
-				}
-				CPU_GenerateIRQ();
-			}
-#ifdef DEBUG2
-			else {
-				printf("SERIO: SERIN Interrupt missed, bytevalue %02x\n", POKEY_SERIN);
-			}
-#endif
-		}
-	}
-
-	if (POKEY_DELAYED_SEROUT_IRQ > 0) {
-		if (--POKEY_DELAYED_SEROUT_IRQ == 0) {
-			if (POKEY_IRQEN & 0x10) {
-#ifdef DEBUG2
-				printf("SERIO: SEROUT Interrupt triggered\n");
-#endif
-				POKEY_IRQST &= 0xef;
-				CPU_GenerateIRQ();
-			}
-#ifdef DEBUG2
-			else {
-				printf("SERIO: SEROUT Interrupt missed\n");
-			}
-#endif
-		}
-	}
-
-	if (POKEY_DELAYED_XMTDONE_IRQ > 0)
-		if (--POKEY_DELAYED_XMTDONE_IRQ == 0) {
-			POKEY_IRQST &= 0xf7;
-			if (POKEY_IRQEN & 0x08) {
-#ifdef DEBUG2
-				printf("SERIO: XMTDONE Interrupt triggered\n");
-#endif
-				CPU_GenerateIRQ();
-			}
-#ifdef DEBUG2
-			else
-				printf("SERIO: XMTDONE Interrupt missed\n");
-#endif
-		}
-
-	if ((POKEY_DivNIRQ[POKEY_CHAN1] -= ANTIC_LINE_C) < 0 ) {
-		POKEY_DivNIRQ[POKEY_CHAN1] += POKEY_DivNMax[POKEY_CHAN1];
-		if (POKEY_IRQEN & 0x01) {
-			POKEY_IRQST &= 0xfe;
-			CPU_GenerateIRQ();
-		}
-	}
-
-	if ((POKEY_DivNIRQ[POKEY_CHAN2] -= ANTIC_LINE_C) < 0 ) {
-		POKEY_DivNIRQ[POKEY_CHAN2] += POKEY_DivNMax[POKEY_CHAN2];
-		if (POKEY_IRQEN & 0x02) {
-			POKEY_IRQST &= 0xfd;
-			CPU_GenerateIRQ();
-		}
-	}
-
-	if ((POKEY_DivNIRQ[POKEY_CHAN4] -= ANTIC_LINE_C) < 0 ) {
-		POKEY_DivNIRQ[POKEY_CHAN4] += POKEY_DivNMax[POKEY_CHAN4];
-		if (POKEY_IRQEN & 0x04) {
-			POKEY_IRQST &= 0xfb;
-			CPU_GenerateIRQ();
-		}
-	}
+	/* serial port and timer IRQs */
+	SCHED_Run(ANTIC_screenline_cpu_clock);
 }
 
 /*****************************************************************************/
@@ -646,15 +747,18 @@ void POKEY_StateSave(void)
 
 	StateSav_SaveINT(&shift_key, 1);
 	StateSav_SaveINT(&keypressed, 1);
-	StateSav_SaveINT(&POKEY_DELAYED_SERIN_IRQ, 1);
-	StateSav_SaveINT(&POKEY_DELAYED_SEROUT_IRQ, 1);
-	StateSav_SaveINT(&POKEY_DELAYED_XMTDONE_IRQ, 1);
+	/* The state is saved between frames, after the last scanline. */
+	if (RUNNING)
+		StoreEvents(ANTIC_screenline_cpu_clock - ANTIC_LINE_C);
+	StateSav_SaveINT(&serin_delay, 1);
+	StateSav_SaveINT(&serout_delay, 1);
+	StateSav_SaveINT(&xmtdone_delay, 1);
 
 	StateSav_SaveUBYTE(&POKEY_AUDF[0], 4);
 	StateSav_SaveUBYTE(&POKEY_AUDC[0], 4);
 	StateSav_SaveUBYTE(&POKEY_AUDCTL[0], 1);
 
-	StateSav_SaveINT(&POKEY_DivNIRQ[0], 4);
+	StateSav_SaveINT(&timer_count[0], 4);
 	StateSav_SaveINT(&POKEY_DivNMax[0], 4);
 	StateSav_SaveINT(&POKEY_Base_mult[0], 1);
 }
@@ -672,9 +776,9 @@ void POKEY_StateRead(void)
 
 	StateSav_ReadINT(&shift_key, 1);
 	StateSav_ReadINT(&keypressed, 1);
-	StateSav_ReadINT(&POKEY_DELAYED_SERIN_IRQ, 1);
-	StateSav_ReadINT(&POKEY_DELAYED_SEROUT_IRQ, 1);
-	StateSav_ReadINT(&POKEY_DELAYED_XMTDONE_IRQ, 1);
+	StateSav_ReadINT(&serin_delay, 1);
+	StateSav_ReadINT(&serout_delay, 1);
+	StateSav_ReadINT(&xmtdone_delay, 1);
 
 	StateSav_ReadUBYTE(&POKEY_AUDF[0], 4);
 	StateSav_ReadUBYTE(&POKEY_AUDC[0], 4);
@@ -685,9 +789,13 @@ void POKEY_StateRead(void)
 	}
 	POKEY_PutByte(POKEY_OFFSET_AUDCTL, POKEY_AUDCTL[0]);
 
-	StateSav_ReadINT(&POKEY_DivNIRQ[0], 4);
+	StateSav_ReadINT(&timer_count[0], 4);
 	StateSav_ReadINT(&POKEY_DivNMax[0], 4);
 	StateSav_ReadINT(&POKEY_Base_mult[0], 1);
+
+	RemoveEvents();
+	if (RUNNING)
+		StartEvents(ANTIC_screenline_cpu_clock - ANTIC_LINE_C);
 }
 
 #endif
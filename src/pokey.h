@@ -39,6 +39,8 @@
 #define POKEY_OFFSET_SKSTAT 0x0f
 
 #define POKEY_OFFSET_POKEY2 0x10			/* offset to second pokey chip (STEREO expansion) */
+#define POKEY_OFFSET_POKEY3 0x20			/* offsets to third and fourth pokey chips (QUAD expansion) */
+#define POKEY_OFFSET_POKEY4 0x30
 
 #ifndef ASAP
 
@@ -47,9 +49,6 @@ extern UBYTE POKEY_IRQST;
 extern UBYTE POKEY_IRQEN;
 extern UBYTE POKEY_SKSTAT;
 extern UBYTE POKEY_SKCTL;
-extern int POKEY_DELAYED_SERIN_IRQ;
-extern int POKEY_DELAYED_SEROUT_IRQ;
-extern int POKEY_DELAYED_XMTDONE_IRQ;
 
 extern UBYTE POKEY_POT_input[8];
 
@@ -60,6 +59,9 @@ void POKEY_PutByte(UWORD addr, UBYTE byte);
 int POKEY_Initialise(int *argc, char *argv[]);
 void POKEY_Frame(void);
 void POKEY_Scanline(void);
+/* Loads SERIN and raises the SERIN IRQ SCANLINES scanlines after the
+   current one. SCANLINES <= 0 cancels a pending one. */
+void POKEY_SetSerinDelay(int scanlines);
 void POKEY_StateSave(void);
 void POKEY_StateRead(void);
 
@@ -95,7 +97,7 @@ void POKEY_StateRead(void);
 #define POKEY_POLY9_SIZE  0x01ff
 #define POKEY_POLY17_SIZE 0x0001ffff
 
-#define POKEY_MAXPOKEYS         2		/* max number of emulated chips */
+#define POKEY_MAXPOKEYS         4		/* max number of emulated chips */
 
 /* channel/chip definitions */
 #define POKEY_CHAN1       0
@@ -113,7 +115,7 @@ extern UBYTE POKEY_AUDF[4 * POKEY_MAXPOKEYS];	/* AUDFx (D200, D202, D204, D206)
 extern UBYTE POKEY_AUDC[4 * POKEY_MAXPOKEYS];	/* AUDCx (D201, D203, D205, D207) */
 extern UBYTE POKEY_AUDCTL[POKEY_MAXPOKEYS];		/* AUDCTL (D208) */
 
-extern int POKEY_DivNIRQ[4], POKEY_DivNMax[4];
+extern int POKEY_DivNMax[4];
 extern int POKEY_Base_mult[POKEY_MAXPOKEYS];	/* selects either 64Khz or 15Khz clock mult */
 
 extern UBYTE POKEY_poly9_lookup[POKEY_POLY9_SIZE];
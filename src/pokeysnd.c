@@ -23,6 +23,8 @@
 */
 
 #include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
 
 #ifdef ASAP /* external project, see http://asap.sf.net */
 #include "asap_internal.h"
@@ -30,11 +32,18 @@
 #include "atari.h"
 #ifndef __PLUS
 #include "sndsave.h"
+#ifdef AVI_RECORDING
+#include "avirec.h"
+#endif
+#ifdef SHM_EXPORT
+#include "shmexport.h"
+#endif
 #else
 #include "sound_win.h"
 #endif
 #endif
 #include "mzpokeysnd.h"
+#include "bleppokeysnd.h"
 #include "pokeysnd.h"
 #if defined(PBI_XLD) || defined (VOICEBOX)
 #include "votraxsnd.h"
@@ -148,6 +157,7 @@ static int	sampout2;			/* last out volume */
 static ULONG snd_freq17 = POKEYSND_FREQ_17_EXACT;
 int POKEYSND_playback_freq = 44100;
 UBYTE POKEYSND_num_pokeys = 1;
+UBYTE POKEYSND_num_chips = 1;
 int POKEYSND_snd_flags = 0;
 static int mz_quality = 0;		/* default quality for mzpokeysnd */
 #ifdef __PLUS
@@ -155,6 +165,7 @@ int mz_clear_regs = 0;
 #endif
 
 int POKEYSND_enable_new_pokey = TRUE;
+int POKEYSND_enable_blep_pokey = FALSE;
 int POKEYSND_bienias_fix = TRUE;  /* when TRUE, high frequencies get emulated: better sound but slower */
 #if defined(__PLUS) && !defined(_WX_)
 #define BIENIAS_FIX (g_Sound.nBieniasFix)
@@ -164,6 +175,9 @@ int POKEYSND_bienias_fix = TRUE;  /* when TRUE, high frequencies get emulated: b
 #ifndef ASAP
 int POKEYSND_stereo_enabled = FALSE;
 #endif
+int POKEYSND_quad_enabled = FALSE;
+/* the chips at D200 and D220 play on the left, D210 and D230 on the right */
+int POKEYSND_pan[POKEY_MAXPOKEYS] = {-100, 100, -100, 100};
 
 /* multiple sound engine interface */
 static void pokeysnd_process_8(void *sndbuffer, int sndn);
@@ -242,19 +256,80 @@ void (*POKEYSND_UpdateVolOnly)(void) = null_vol_only_sound;
 static int pokeysnd_init_rf(ULONG freq17, int playback_freq,
            UBYTE num_pokeys, int flags);
 
+#ifndef ASAP
+/* Register log written by POKEYSND_Update, see POKEYSND_OpenLog() */
+static FILE *log_file = NULL;
+static unsigned int log_clock;
+static void (*log_engine_update)(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain);
+
+static void Update_pokey_sound_log(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain)
+{
+	unsigned int clock = ANTIC_CPU_CLOCK;
+	fprintf(log_file, "%u %d %X %02X\n", clock - log_clock, chip, addr, val);
+	log_clock = clock;
+	log_engine_update(addr, val, chip, gain);
+}
+
+/* Puts the log in front of the sound engine's POKEYSND_Update. */
+static void HookLog(void)
+{
+	if (log_file != NULL && POKEYSND_Update != Update_pokey_sound_log) {
+		log_engine_update = POKEYSND_Update;
+		POKEYSND_Update = Update_pokey_sound_log;
+	}
+}
+
+int POKEYSND_OpenLog(const char *filename)
+{
+	POKEYSND_CloseLog();
+	log_file = fopen(filename, "w");
+	if (log_file == NULL)
+		return FALSE;
+	fprintf(log_file, "# POKEY register log: cycles since the previous write, chip, register, value\n");
+	log_clock = ANTIC_CPU_CLOCK;
+	HookLog();
+	return TRUE;
+}
+
+void POKEYSND_CloseLog(void)
+{
+	if (log_file == NULL)
+		return;
+	/* the cycles from the last write to the end of the log */
+	fprintf(log_file, "%u\n", ANTIC_CPU_CLOCK - log_clock);
+	fclose(log_file);
+	log_file = NULL;
+	if (POKEYSND_Update == Update_pokey_sound_log)
+		POKEYSND_Update = log_engine_update;
+}
+#endif /* ASAP */
+
 int POKEYSND_DoInit(void)
 {
+	int result;
 	SndSave_CloseSoundFile();
+	/* With quad POKEY, four chips are mixed to the two channels. */
+	POKEYSND_num_chips = POKEYSND_num_pokeys > 1 && POKEYSND_quad_enabled ? 4 : POKEYSND_num_pokeys;
+#ifndef SYNCHRONIZED_SOUND
+	if (POKEYSND_enable_blep_pokey)
+		result = BLEPPOKEYSND_Init(snd_freq17, POKEYSND_playback_freq,
+				POKEYSND_num_pokeys, POKEYSND_snd_flags);
+	else
+#endif
 	if (POKEYSND_enable_new_pokey)
-		return MZPOKEYSND_Init(snd_freq17, POKEYSND_playback_freq,
+		result = MZPOKEYSND_Init(snd_freq17, POKEYSND_playback_freq,
 				POKEYSND_num_pokeys, POKEYSND_snd_flags, mz_quality
 #ifdef __PLUS
 				, mz_clear_regs
 #endif
 		);
 	else
-		return pokeysnd_init_rf(snd_freq17, POKEYSND_playback_freq,
+		result = pokeysnd_init_rf(snd_freq17, POKEYSND_playback_freq,
 				POKEYSND_num_pokeys, POKEYSND_snd_flags);
+#ifndef ASAP
+	HookLog();
+#endif
+	return result;
 }
 
 int POKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
@@ -278,6 +353,70 @@ int POKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
 	return POKEYSND_DoInit();
 }
 
+int POKEYSND_NumChips(void)
+{
+#ifdef STEREO_SOUND
+	if (POKEYSND_stereo_enabled)
+		return POKEYSND_quad_enabled ? 4 : 2;
+#endif
+	return 1;
+}
+
+/* Returns the share of CHIP's sound in the output CHANNEL, in 1/256,
+   before scaling it to the other chips. */
+static int RawPanWeight(int chip, int channel)
+{
+	if (POKEYSND_num_pokeys < 2)
+		return 256;
+	if (channel == 0)
+		return (100 - POKEYSND_pan[chip]) * 128 / 100;
+	return (100 + POKEYSND_pan[chip]) * 128 / 100;
+}
+
+int POKEYSND_PanWeight(int chip, int channel)
+{
+	int max_total = 256;
+	int c;
+	int i;
+	/* Scale the chips down if together they could overflow a channel. */
+	for (c = 0; c < POKEYSND_num_pokeys; c++) {
+		int total = 0;
+		for (i = 0; i < POKEYSND_num_chips; i++)
+			total += RawPanWeight(i, c);
+		if (total > max_total)
+			max_total = total;
+	}
+	return RawPanWeight(chip, channel) * 256 / max_total;
+}
+
+int POKEYSND_SetPanning(const char *list)
+{
+	int pan[POKEY_MAXPOKEYS];
+	int n = 0;
+	int i;
+	for (;;) {
+		char *end;
+		long value = strtol(list, &end, 10);
+		if (end == list || value < -100 || value > 100 || n >= POKEY_MAXPOKEYS)
+			return FALSE;
+		pan[n++] = (int) value;
+		if (*end == '\0')
+			break;
+		if (*end != ',')
+			return FALSE;
+		list = end + 1;
+	}
+	/* chips that are not listed keep their position */
+	for (i = 0; i < n; i++)
+		POKEYSND_pan[i] = pan[i];
+	return TRUE;
+}
+
+void POKEYSND_GetPanning(char *list)
+{
+	sprintf(list, "%d,%d,%d,%d", POKEYSND_pan[0], POKEYSND_pan[1], POKEYSND_pan[2], POKEYSND_pan[3]);
+}
+
 void POKEYSND_SetMzQuality(int quality)	/* specially for win32, perhaps not needed? */
 {
 	mz_quality = quality;
@@ -292,6 +431,14 @@ void POKEYSND_Process(void *sndbuffer, int sndn)
 #if !defined(__PLUS) && !defined(ASAP)
 	SndSave_WriteToSoundFile((const unsigned char *)sndbuffer, sndn);
 #endif
+#if defined(AVI_RECORDING) && !defined(SDL)
+	/* SDL calls this from its audio thread; it records sound only
+	   with SYNCHRONIZED_SOUND, in MZPOKEYSND_UpdateProcessBuffer(). */
+	AVIRec_Sound((const UBYTE *)sndbuffer, sndn);
+#endif
+#ifdef SHM_EXPORT
+	SHMExport_Sound((const UBYTE *)sndbuffer, sndn);
+#endif
 }
 
 static int pokeysnd_init_rf(ULONG freq17, int playback_freq,
@@ -373,6 +520,11 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 	UBYTE chan_mask;
 	UBYTE chip_offs;
 
+	/* Each chip plays on its own channel, so with quad POKEY only the
+	   first two are heard. */
+	if (chip >= Num_pokeys)
+		return;
+
 	/* calculate the chip_offs for the channel arrays */
 	chip_offs = chip << 2;
 
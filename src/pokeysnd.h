@@ -82,11 +82,17 @@ extern "C" {
 #define POKEYSND_BIT16	1
 
 extern SLONG POKEYSND_playback_freq;
-extern UBYTE POKEYSND_num_pokeys;
+extern UBYTE POKEYSND_num_pokeys; /* number of output channels */
+extern UBYTE POKEYSND_num_chips; /* number of chips mixed to them */
 extern int POKEYSND_snd_flags;
 
 extern int POKEYSND_enable_new_pokey;
+extern int POKEYSND_enable_blep_pokey; /* overrides POKEYSND_enable_new_pokey */
 extern int POKEYSND_stereo_enabled;
+extern int POKEYSND_quad_enabled; /* four chips instead of two with stereo */
+/* Position of each chip's sound between the left (-100) and right (100)
+   channel. */
+extern int POKEYSND_pan[POKEY_MAXPOKEYS];
 extern int POKEYSND_serio_sound_enabled;
 extern int POKEYSND_console_sound_enabled;
 extern int POKEYSND_bienias_fix;
@@ -107,6 +113,29 @@ void POKEYSND_Process(void *sndbuffer, int sndn);
 int POKEYSND_DoInit(void);
 void POKEYSND_SetMzQuality(int quality);
 
+/* Returns the number of chips at D200 with the current settings: 1, 2 with
+   stereo or 4 with quad POKEY. */
+int POKEYSND_NumChips(void);
+/* Returns the share of CHIP's sound in the output CHANNEL, in 1/256.
+   The shares in a channel add up to at most 256, so that the mix of all
+   chips has the range of a single chip. */
+int POKEYSND_PanWeight(int chip, int channel);
+/* Sets POKEYSND_pan from a comma-separated list such as "-100,100,-50,50".
+   Returns FALSE if the list is invalid. */
+int POKEYSND_SetPanning(const char *list);
+/* Writes POKEYSND_pan in the format of POKEYSND_SetPanning() to LIST, which
+   must hold POKEY_MAXPOKEYS * 5 characters. */
+void POKEYSND_GetPanning(char *list);
+
+/* Writes each call of POKEYSND_Update to a text file, one per line:
+   the CPU cycles since the previous write, the chip, the register offset
+   (hex) and the value (hex). The last line holds only the cycles from the
+   last write to POKEYSND_CloseLog(). Lines starting with '#' are comments.
+   util/pokeybench.c replays such logs. Returns FALSE if the file cannot be
+   created. */
+int POKEYSND_OpenLog(const char *filename);
+void POKEYSND_CloseLog(void);
+
 /* Volume only emulations declarations */
 #ifdef VOL_ONLY_SOUND
 
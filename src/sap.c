@@ -0,0 +1,353 @@
+/*
+ * sap.c - SAP music file support
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atari.h"
+#include "cpu.h"
+#include "log.h"
+#include "memory.h"
+#include "pia.h"
+#include "sap.h"
+#include "util.h"
+
+int SAP_song = -1;
+int SAP_stereo = FALSE;
+double SAP_time = 0.0;
+
+/* A SAP file is a text header followed by Atari binary file blocks. */
+#define SAP_MAX_SIZE 0x20000
+
+/* Hardware registers written by the player loop */
+#define NMIEN  0xd40e
+#define VCOUNT 0xd40b
+#define IRQEN  0xd20e
+#define SKCTL  0xd20f
+
+static UBYTE code[256];
+static int code_len;
+
+static void Emit(int b)
+{
+	code[code_len++] = (UBYTE) b;
+}
+
+static void Emit16(int w)
+{
+	Emit(w & 0xff);
+	Emit(w >> 8);
+}
+
+/* Parses "mm:ss" or "mm:ss.xxx", returns seconds or 0 on error. */
+static double ParseTime(const char *s)
+{
+	int minutes = 0;
+	double seconds;
+	while (*s >= '0' && *s <= '9')
+		minutes = minutes * 10 + *s++ - '0';
+	if (*s++ != ':')
+		return 0.0;
+	seconds = strtod(s, NULL);
+	return minutes * 60 + seconds;
+}
+
+/* Returns the address after the end of RAM that can hold SAP data. */
+static int RamTop(void)
+{
+	if (Atari800_machine_type == Atari800_MACHINE_XLXE && MEMORY_ram_size >= 64)
+		return 0x10000; /* with the OS ROM disabled */
+	return MEMORY_ram_size * 1024 > 0xd000 ? 0xd000 : MEMORY_ram_size * 1024;
+}
+
+int SAP_Load(const char *filename)
+{
+	FILE *fp;
+	UBYTE *buf;
+	int len;
+	int pos;
+	int type = 0;
+	int init = -1;
+	int player = -1;
+	int music = -1;
+	int songs = 1;
+	int defsong = 0;
+	int fastplay = -1;
+	int ntsc = FALSE;
+	int song;
+	int lines;
+	int ram_top;
+	int data_top = 0;
+	int page;
+	int loop_addr;
+	int target;
+	int next;
+	int n;
+	UBYTE used[256];
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL)
+		return FALSE;
+	buf = (UBYTE *) Util_malloc(SAP_MAX_SIZE);
+	len = fread(buf, 1, SAP_MAX_SIZE, fp);
+	fclose(fp);
+	if (len < 6 || memcmp(buf, "SAP\r\n", 5) != 0) {
+		free(buf);
+		return FALSE;
+	}
+
+	SAP_stereo = FALSE;
+	SAP_time = 0.0;
+	n = 0; /* number of TIME tags */
+	pos = 5;
+	while (pos + 1 < len && !(buf[pos] == 0xff && buf[pos + 1] == 0xff)) {
+		char line[256];
+		const char *arg;
+		int i = 0;
+		while (pos < len && buf[pos] != '\r' && buf[pos] != '\n' && i < (int) sizeof(line) - 1)
+			line[i++] = buf[pos++];
+		line[i] = '\0';
+		while (pos < len && (buf[pos] == '\r' || buf[pos] == '\n'))
+			pos++;
+		arg = strchr(line, ' ');
+		arg = arg == NULL ? "" : arg + 1;
+		if (strncmp(line, "TYPE ", 5) == 0)
+			type = arg[0];
+		else if (strncmp(line, "INIT ", 5) == 0)
+			init = Util_sscanhex(arg);
+		else if (strncmp(line, "PLAYER ", 7) == 0)
+			player = Util_sscanhex(arg);
+		else if (strncmp(line, "MUSIC ", 6) == 0)
+			music = Util_sscanhex(arg);
+		else if (strncmp(line, "SONGS ", 6) == 0)
+			songs = Util_sscandec(arg);
+		else if (strncmp(line, "DEFSONG ", 8) == 0)
+			defsong = Util_sscandec(arg);
+		else if (strncmp(line, "FASTPLAY ", 9) == 0)
+			fastplay = Util_sscandec(arg);
+		else if (strcmp(line, "STEREO") == 0)
+			SAP_stereo = TRUE;
+		else if (strcmp(line, "NTSC") == 0)
+			ntsc = TRUE;
+		else if (strncmp(line, "TIME ", 5) == 0) {
+			song = SAP_song >= 0 ? SAP_song : defsong;
+			if (n++ == song)
+				SAP_time = ParseTime(arg);
+		}
+	}
+
+	song = SAP_song >= 0 ? SAP_song : defsong;
+	if (type != 'B' && type != 'C') {
+		Log_print("%s: only SAP files of type B and C are supported", filename);
+		free(buf);
+		return FALSE;
+	}
+	if (player < 0 || (type == 'B' && init < 0) || (type == 'C' && music < 0)
+	 || songs < 1 || song < 0 || song >= songs || fastplay == 0 || fastplay > 312) {
+		Log_print("%s: bad SAP header", filename);
+		free(buf);
+		return FALSE;
+	}
+	if (Atari800_machine_type == Atari800_MACHINE_5200) {
+		Log_print("SAP files need an Atari computer");
+		free(buf);
+		return FALSE;
+	}
+
+	/* Check the blocks and find the pages that they use. */
+	ram_top = RamTop();
+	memset(used, 0, sizeof(used));
+	used[0] = used[1] = 1; /* zero page and stack */
+	n = pos;
+	while (n < len) {
+		int start;
+		int end;
+		if (n + 1 < len && buf[n] == 0xff && buf[n + 1] == 0xff)
+			n += 2;
+		if (n + 4 > len)
+			break;
+		start = buf[n] + (buf[n + 1] << 8);
+		end = buf[n + 2] + (buf[n + 3] << 8);
+		n += 4;
+		if (end < start || n + end - start + 1 > len || end >= ram_top
+		 || (end >= 0xd000 && start < 0xd800)) {
+			Log_print("%s: bad SAP data block", filename);
+			free(buf);
+			return FALSE;
+		}
+		for (page = start >> 8; page <= end >> 8; page++)
+			used[page] = 1;
+		if (end >= data_top)
+			data_top = end + 1;
+		n += end - start + 1;
+	}
+
+	/* Find a free page below the OS area for the player loop. */
+	for (page = (ram_top > 0xc000 ? 0xc000 : ram_top) / 256 - 1; page > 1; page--)
+		if (!used[page])
+			break;
+	if (page <= 1) {
+		Log_print("%s: no free memory for the player loop", filename);
+		free(buf);
+		return FALSE;
+	}
+
+	Atari800_SetTVMode(ntsc ? Atari800_TV_NTSC : Atari800_TV_PAL);
+	Atari800_Coldstart();
+	if (data_top > 0xc000) {
+		/* disable the OS ROM */
+		PIA_PutByte(PIA_OFFSET_PBCTL, 0x38);
+		PIA_PutByte(PIA_OFFSET_PORTB, 0xff);
+		PIA_PutByte(PIA_OFFSET_PBCTL, 0x3c);
+		PIA_PutByte(PIA_OFFSET_PORTB, 0xfe);
+	}
+	n = pos;
+	while (n + 4 <= len) {
+		int start;
+		int end;
+		if (buf[n] == 0xff && buf[n + 1] == 0xff)
+			n += 2;
+		if (n + 4 > len)
+			break;
+		start = buf[n] + (buf[n + 1] << 8);
+		end = buf[n + 2] + (buf[n + 3] << 8);
+		n += 4;
+		MEMORY_dCopyToMem(buf + n, start, end - start + 1);
+		n += end - start + 1;
+	}
+	free(buf);
+
+	/* The player loop. Interrupts are off; the player is called when VCOUNT
+	   reaches "target". "next" is the line of the next call. It counts on
+	   from frame to frame, so the calls stay evenly spaced when FASTPLAY
+	   doesn't divide the number of lines in a frame. Both variables are
+	   kept at the end of the loop's page. */
+	target = page * 256 + 0xfd;
+	next = page * 256 + 0xfe;
+	lines = Atari800_tv_mode;
+	if (fastplay < 0 || fastplay > lines)
+		fastplay = lines;
+	else if (fastplay < 2)
+		fastplay = 2; /* VCOUNT counts pairs of lines */
+	code_len = 0;
+	Emit(0x78);                  /* SEI */
+	Emit(0xd8);                  /* CLD */
+	Emit(0xa2); Emit(0xff);      /* LDX #$ff */
+	Emit(0x9a);                  /* TXS */
+	Emit(0xa9); Emit(0x00);      /* LDA #0 */
+	Emit(0x8d); Emit16(NMIEN);   /* STA NMIEN */
+	Emit(0x8d); Emit16(IRQEN);   /* STA IRQEN */
+	if (SAP_stereo) {
+		Emit(0x8d); Emit16(IRQEN + 0x10);
+	}
+	Emit(0xa9); Emit(0x03);      /* LDA #3 */
+	Emit(0x8d); Emit16(SKCTL);   /* STA SKCTL */
+	if (SAP_stereo) {
+		Emit(0x8d); Emit16(SKCTL + 0x10);
+	}
+	if (type == 'B') {
+		Emit(0xa9); Emit(song);  /* LDA #song */
+		Emit(0x20); Emit16(init); /* JSR INIT */
+	}
+	else {
+		Emit(0xa9); Emit(0x70);  /* LDA #$70 */
+		Emit(0xa2); Emit(music & 0xff); /* LDX #<MUSIC */
+		Emit(0xa0); Emit(music >> 8); /* LDY #>MUSIC */
+		Emit(0x20); Emit16(player + 3); /* JSR PLAYER+3 */
+		Emit(0xa9); Emit(0x00);  /* LDA #0 */
+		Emit(0xa2); Emit(song);  /* LDX #song */
+		Emit(0x20); Emit16(player + 3); /* JSR PLAYER+3 */
+	}
+	Emit(0xa9); Emit(0x00);      /* LDA #0 */
+	Emit(0x8d); Emit16(target);  /* STA target */
+	Emit(0x8d); Emit16(next);    /* STA next */
+	Emit(0x8d); Emit16(next + 1); /* STA next+1 */
+	loop_addr = page * 256 + code_len;
+	Emit(0xad); Emit16(VCOUNT);  /* loop: LDA VCOUNT */
+	Emit(0xcd); Emit16(target);  /* CMP target */
+	Emit(0xd0); Emit(0xf8);      /* BNE loop */
+	Emit(0x20); Emit16(type == 'B' ? player : player + 6); /* JSR PLAYER */
+	Emit(0xad); Emit16(VCOUNT);  /* done: LDA VCOUNT */
+	Emit(0xcd); Emit16(target);  /* CMP target */
+	Emit(0xf0); Emit(0xf8);      /* BEQ done */
+	Emit(0x18);                  /* CLC */
+	Emit(0xad); Emit16(next);    /* LDA next */
+	Emit(0x69); Emit(fastplay & 0xff); /* ADC #<FASTPLAY */
+	Emit(0x8d); Emit16(next);    /* STA next */
+	Emit(0xad); Emit16(next + 1); /* LDA next+1 */
+	Emit(0x69); Emit(fastplay >> 8); /* ADC #>FASTPLAY */
+	Emit(0x8d); Emit16(next + 1); /* STA next+1 */
+	Emit(0x38);                  /* SEC */
+	Emit(0xad); Emit16(next);    /* LDA next */
+	Emit(0xe9); Emit(lines & 0xff); /* SBC #<lines */
+	Emit(0xaa);                  /* TAX */
+	Emit(0xad); Emit16(next + 1); /* LDA next+1 */
+	Emit(0xe9); Emit(lines >> 8); /* SBC #>lines */
+	Emit(0x90); Emit(0x06);      /* BCC half */
+	Emit(0x8d); Emit16(next + 1); /* STA next+1 */
+	Emit(0x8e); Emit16(next);    /* STX next */
+	Emit(0xad); Emit16(next + 1); /* half: LDA next+1 */
+	Emit(0x4a);                  /* LSR A */
+	Emit(0xad); Emit16(next);    /* LDA next */
+	Emit(0x6a);                  /* ROR A */
+	Emit(0x8d); Emit16(target);  /* STA target */
+	Emit(0x4c); Emit16(loop_addr); /* JMP loop */
+	MEMORY_dCopyToMem(code, page * 256, code_len);
+	CPU_regPC = page * 256;
+	return TRUE;
+}
+
+int SAP_Initialise(int *argc, char *argv[])
+{
+	int i;
+	int j;
+	for (i = j = 1; i < *argc; i++) {
+		int i_a = (i + 1 < *argc);		/* is argument available? */
+		int a_m = FALSE;			/* error, argument missing! */
+
+		if (strcmp(argv[i], "-sapsong") == 0) {
+			if (i_a) {
+				SAP_song = Util_sscandec(argv[++i]) - 1;
+				if (SAP_song < 0) {
+					Log_print("Invalid SAP song number - must be 1 or more");
+					return FALSE;
+				}
+			}
+			else a_m = TRUE;
+		}
+		else {
+			if (strcmp(argv[i], "-help") == 0)
+				Log_print("\t-sapsong <n>     Play song n of a SAP file (default: the file's default)");
+			argv[j++] = argv[i];
+		}
+
+		if (a_m) {
+			Log_print("Missing argument for '%s'", argv[i]);
+			return FALSE;
+		}
+	}
+	*argc = j;
+	return TRUE;
+}
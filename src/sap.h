@@ -0,0 +1,21 @@
+#ifndef SAP_H_
+#define SAP_H_
+
+#include "atari.h"
+
+/* Song of a SAP file to play, counted from 0. -1 means the file's default. */
+extern int SAP_song;
+/* TRUE if the loaded SAP file uses two POKEYs. */
+extern int SAP_stereo;
+/* Length of the loaded song in seconds, from the TIME tag; 0 if unknown. */
+extern double SAP_time;
+
+int SAP_Initialise(int *argc, char *argv[]);
+
+/* Loads a SAP file of type B or C into memory and starts playing it. The
+   player routine is called by a small 6502 loop that waits for the lines
+   given by FASTPLAY, so the Atari OS doesn't run at all.
+   Returns FALSE on error. */
+int SAP_Load(const char *filename);
+
+#endif /* SAP_H_ */
@@ -0,0 +1,132 @@
+/*
+ * sched.c - events of peripherals on the CPU clock
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+
+#include "atari.h"
+#include "sched.h"
+
+static SCHED_handler_t handlers[SCHED_NUM_EVENTS];
+static unsigned int times[SCHED_NUM_EVENTS];
+
+/* The pending events as a binary min-heap ordered by time, and the
+   position of each event in it plus one (0 if the event is not pending). */
+static int heap[SCHED_NUM_EVENTS];
+static int heap_pos[SCHED_NUM_EVENTS];
+static int heap_size = 0;
+
+/* The clock wraps around, so times are compared by their difference. */
+static int Earlier(int a, int b)
+{
+	int diff = (int) (times[a] - times[b]);
+	return diff < 0 || (diff == 0 && a < b);
+}
+
+static void Place(int i, int event)
+{
+	heap[i] = event;
+	heap_pos[event] = i + 1;
+}
+
+static void SiftUp(int i)
+{
+	int event = heap[i];
+	while (i > 0) {
+		int parent = (i - 1) >> 1;
+		if (!Earlier(event, heap[parent]))
+			break;
+		Place(i, heap[parent]);
+		i = parent;
+	}
+	Place(i, event);
+}
+
+static void SiftDown(int i)
+{
+	int event = heap[i];
+	for (;;) {
+		int child = 2 * i + 1;
+		if (child >= heap_size)
+			break;
+		if (child + 1 < heap_size && Earlier(heap[child + 1], heap[child]))
+			child++;
+		if (!Earlier(heap[child], event))
+			break;
+		Place(i, heap[child]);
+		i = child;
+	}
+	Place(i, event);
+}
+
+void SCHED_SetHandler(int event, SCHED_handler_t handler)
+{
+	handlers[event] = handler;
+}
+
+void SCHED_Add(int event, unsigned int time)
+{
+	int i = heap_pos[event] - 1;
+	times[event] = time;
+	if (i < 0) {
+		i = heap_size++;
+		Place(i, event);
+		SiftUp(i);
+	}
+	else {
+		SiftUp(i);
+		SiftDown(heap_pos[event] - 1);
+	}
+}
+
+void SCHED_Remove(int event)
+{
+	int i = heap_pos[event] - 1;
+	int last;
+	if (i < 0)
+		return;
+	heap_pos[event] = 0;
+	if (i == --heap_size)
+		return;
+	/* move the last event into the gap */
+	last = heap[heap_size];
+	Place(i, last);
+	SiftUp(i);
+	SiftDown(heap_pos[last] - 1);
+}
+
+int SCHED_Pending(int event, unsigned int *time)
+{
+	if (heap_pos[event] == 0)
+		return FALSE;
+	*time = times[event];
+	return TRUE;
+}
+
+void SCHED_Run(unsigned int now)
+{
+	while (heap_size > 0 && (int) (times[heap[0]] - now) <= 0) {
+		int event = heap[0];
+		SCHED_Remove(event);
+		handlers[event](times[event]);
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef SCHED_H_
+#define SCHED_H_
+
+/* Events that peripherals schedule at a time of the CPU clock (see
+   ANTIC_CPU_CLOCK), instead of counting down on every scanline.
+   POKEY_Scanline() runs the events at the start of each scanline, so an
+   event is handled at the start of the first scanline at or after its time.
+   Events due at the same time run in the order of this list. */
+enum {
+	SCHED_POKEY_SERIN,
+	SCHED_POKEY_SEROUT,
+	SCHED_POKEY_XMTDONE,
+	SCHED_POKEY_TIMER1,
+	SCHED_POKEY_TIMER2,
+	SCHED_POKEY_TIMER4,
+	SCHED_NUM_EVENTS
+};
+
+/* Called with the time the event was scheduled at. It may schedule events,
+   including itself. */
+typedef void (*SCHED_handler_t)(unsigned int time);
+
+void SCHED_SetHandler(int event, SCHED_handler_t handler);
+
+/* Schedules EVENT at TIME, replacing its pending time if it has one.
+   The times of pending events must be within 2^31 cycles of each other. */
+void SCHED_Add(int event, unsigned int time);
+
+void SCHED_Remove(int event);
+
+/* Returns TRUE and stores the time at *TIME if EVENT is pending. */
+int SCHED_Pending(int event, unsigned int *time);
+
+/* Runs the events due at or before NOW in the order of their times. */
+void SCHED_Run(unsigned int now);
+
+#endif /* SCHED_H_ */
@@ -32,6 +32,13 @@
 #ifdef HAVE_LIBPNG
 #include <png.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 #include "antic.h"
 #include "atari.h"
@@ -42,6 +49,9 @@
 #include "screen.h"
 #include "sio.h"
 #include "util.h"
+#ifdef AVI_RECORDING
+#include "avirec.h"
+#endif
 
 #define ATARI_VISIBLE_WIDTH 336
 #define ATARI_LEFT_MARGIN 24
@@ -82,6 +92,26 @@ int Screen_show_1200_leds = TRUE;
 static char screenshot_filename_format[FILENAME_MAX] = DEFAULT_SCREENSHOT_FILENAME_FORMAT;
 static int screenshot_no_max = 1000;
 
+/* Burst mode: every burst_step-th of burst_frames frames is saved. */
+static int burst_frames = 0;
+static int burst_step = 1;
+static int burst_left = 0;
+static int burst_pos;
+
+/* Interlaced screenshot waiting for its second field. */
+static FILE *interlace_fp = NULL;
+static int interlace_is_png;
+static UBYTE *interlace_field = NULL;
+
+#if defined(HAVE_FORK) && defined(HAVE_WAITPID) && defined(HAVE_SYS_WAIT_H)
+/* Screenshots are compressed and written by child processes, which see
+   their own copy of the screen, so saving doesn't pause the emulation. */
+#define ASYNC_SCREENSHOTS
+#define MAX_SCREENSHOT_WRITERS 4
+static pid_t writer_pids[MAX_SCREENSHOT_WRITERS];
+static int n_writers = 0;
+#endif
+
 /* converts "foo%bar##.pcx" to "foo%%bar%02d.pcx" */
 static void Screen_SetScreenshotFilenamePattern(const char *p)
 {
@@ -135,6 +165,21 @@ int Screen_Initialise(int *argc, char *argv[])
 				Screen_SetScreenshotFilenamePattern(argv[++i]);
 			else a_m = TRUE;
 		}
+		else if (strcmp(argv[i], "-burst-frames") == 0) {
+			if (i_a)
+				burst_frames = Util_sscandec(argv[++i]);
+			else a_m = TRUE;
+		}
+		else if (strcmp(argv[i], "-burst-step") == 0) {
+			if (i_a) {
+				burst_step = Util_sscandec(argv[++i]);
+				if (burst_step < 1) {
+					Log_print("Invalid burst step");
+					return FALSE;
+				}
+			}
+			else a_m = TRUE;
+		}
 		else if (strcmp(argv[i], "-showspeed") == 0) {
 			Screen_show_atari_speed = TRUE;
 		}
@@ -142,6 +187,8 @@ int Screen_Initialise(int *argc, char *argv[])
 			if (strcmp(argv[i], "-help") == 0) {
 				help_only = TRUE;
 				Log_print("\t-screenshots <p> Set filename pattern for screenshots");
+				Log_print("\t-burst-frames <n> Screenshot key saves a burst of <n> frames");
+				Log_print("\t-burst-step <n>  Save every <n>th frame of a burst");
 				Log_print("\t-showspeed       Show percentage of actual speed");
 			}
 			argv[j++] = argv[i];
@@ -397,6 +444,7 @@ void Screen_DrawAtariSpeed(double cur_time)
 			          	+ (Screen_visible_y2 - SMALLFONT_HEIGHT) * Screen_WIDTH;
 			SmallFont_DrawChar(screen, SMALLFONT_PERCENT, 0x0c, 0x00);
 			SmallFont_DrawInt(screen - SMALLFONT_WIDTH, percent_display, 0x0c, 0x00);
+			ANTIC_InvalidateLines(Screen_visible_y2 - SMALLFONT_HEIGHT, SMALLFONT_HEIGHT);
 		}
 	}
 }
@@ -409,6 +457,7 @@ void Screen_DrawDiskLED(void)
 			SIO_last_op_time--;
 		screen = (UBYTE *) Screen_atari + Screen_visible_x2 - SMALLFONT_WIDTH
 			+ (Screen_visible_y2 - SMALLFONT_HEIGHT) * Screen_WIDTH;
+		ANTIC_InvalidateLines(Screen_visible_y2 - SMALLFONT_HEIGHT, SMALLFONT_HEIGHT);
 		if (SIO_last_drive == 0x60 || SIO_last_drive == 0x61) {
 			if (CASSETTE_status != CASSETTE_STATUS_NONE) {
 				if (Screen_show_disk_led)
@@ -443,6 +492,7 @@ void Screen_Draw1200LED(void)
 		UBYTE *screen = (UBYTE *) Screen_atari + Screen_visible_x1 + SMALLFONT_WIDTH * 10
 			+ (Screen_visible_y2 - SMALLFONT_HEIGHT) * Screen_WIDTH;
 		UBYTE portb = PIA_PORTB | PIA_PORTB_mask;
+		ANTIC_InvalidateLines(Screen_visible_y2 - SMALLFONT_HEIGHT, SMALLFONT_HEIGHT);
 		if ((portb & 0x04) == 0) {
 			SmallFont_DrawChar(screen, SMALLFONT_L, 0x00, 0x36);
 			SmallFont_DrawChar(screen + SMALLFONT_WIDTH, 1, 0x00, 0x36);
@@ -626,13 +676,67 @@ static void Screen_SavePNG(FILE *fp, UBYTE *ptr1, UBYTE *ptr2)
 }
 #endif /* HAVE_LIBPNG */
 
+/* Writes the screenshot and closes FP. */
+static void WriteScreenshot(FILE *fp, int is_png, UBYTE *ptr1, UBYTE *ptr2)
+{
+#ifdef HAVE_LIBPNG
+	if (is_png)
+		Screen_SavePNG(fp, ptr1, ptr2);
+	else
+#endif
+		Screen_SavePCX(fp, ptr1, ptr2);
+	fclose(fp);
+}
+
+#ifdef ASYNC_SCREENSHOTS
+/* Forgets the writers that have finished. If BLOCK, first waits until
+   one of them finishes. */
+static void ReapWriters(int block)
+{
+	int i = 0;
+	while (i < n_writers) {
+		if (waitpid(writer_pids[i], NULL, block ? 0 : WNOHANG) == 0)
+			i++;
+		else {
+			writer_pids[i] = writer_pids[--n_writers];
+			block = FALSE;
+		}
+	}
+}
+#endif /* ASYNC_SCREENSHOTS */
+
+/* Like WriteScreenshot, but in a child process if possible.
+   PTR1 and PTR2 may be reused as soon as this returns. */
+static void StartWriteScreenshot(FILE *fp, int is_png, UBYTE *ptr1, UBYTE *ptr2)
+{
+#ifdef ASYNC_SCREENSHOTS
+	pid_t pid;
+	ReapWriters(n_writers >= MAX_SCREENSHOT_WRITERS);
+	/* don't let the child repeat buffered output */
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0) {
+#ifdef AVI_RECORDING
+		AVIRec_CloseInChild();
+#endif
+		WriteScreenshot(fp, is_png, ptr1, ptr2);
+		_exit(0);
+	}
+	if (pid > 0) {
+		/* nothing has been written through our copy of fp */
+		fclose(fp);
+		writer_pids[n_writers++] = pid;
+		return;
+	}
+	/* no child process - write here */
+#endif /* ASYNC_SCREENSHOTS */
+	WriteScreenshot(fp, is_png, ptr1, ptr2);
+}
+
 int Screen_SaveScreenshot(const char *filename, int interlaced)
 {
 	int is_png;
 	FILE *fp;
-	ULONG *main_screen_atari;
-	UBYTE *ptr1;
-	UBYTE *ptr2;
 	if (striendswith(filename, ".pcx"))
 		is_png = 0;
 #ifdef HAVE_LIBPNG
@@ -641,30 +745,21 @@ int Screen_SaveScreenshot(const char *filename, int interlaced)
 #endif
 	else
 		return FALSE;
+	if (interlaced && interlace_fp != NULL)
+		return FALSE; /* one is already waiting for the next frame */
 	fp = fopen(filename, "wb");
 	if (fp == NULL)
 		return FALSE;
-	main_screen_atari = Screen_atari;
-	ptr1 = (UBYTE *) Screen_atari + ATARI_LEFT_MARGIN;
 	if (interlaced) {
-		Screen_atari = (ULONG *) Util_malloc(Screen_WIDTH * Screen_HEIGHT);
-		ptr2 = (UBYTE *) Screen_atari + ATARI_LEFT_MARGIN;
-		ANTIC_Frame(TRUE); /* draw on Screen_atari */
+		/* the second field is taken from the next frame in Screen_Frame() */
+		if (interlace_field == NULL)
+			interlace_field = (UBYTE *) Util_malloc(Screen_WIDTH * Screen_HEIGHT);
+		memcpy(interlace_field, Screen_atari, Screen_WIDTH * Screen_HEIGHT);
+		interlace_fp = fp;
+		interlace_is_png = is_png;
 	}
-	else {
-		ptr2 = NULL;
-	}
-#ifdef HAVE_LIBPNG
-	if (is_png)
-		Screen_SavePNG(fp, ptr1, ptr2);
 	else
-#endif
-		Screen_SavePCX(fp, ptr1, ptr2);
-	fclose(fp);
-	if (interlaced) {
-		free(Screen_atari);
-		Screen_atari = main_screen_atari;
-	}
+		StartWriteScreenshot(fp, is_png, (UBYTE *) Screen_atari + ATARI_LEFT_MARGIN, NULL);
 	return TRUE;
 }
 
@@ -675,6 +770,49 @@ void Screen_SaveNextScreenshot(int interlaced)
 	Screen_SaveScreenshot(filename, interlaced);
 }
 
+int Screen_StartScreenshotBurst(void)
+{
+	if (burst_frames <= 0)
+		return FALSE;
+	burst_left = burst_frames;
+	burst_pos = 0;
+	return TRUE;
+}
+
+void Screen_Frame(void)
+{
+	if (interlace_fp != NULL) {
+		StartWriteScreenshot(interlace_fp, interlace_is_png,
+			interlace_field + ATARI_LEFT_MARGIN, (UBYTE *) Screen_atari + ATARI_LEFT_MARGIN);
+		interlace_fp = NULL;
+	}
+	if (burst_left > 0) {
+		if (burst_pos++ % burst_step == 0)
+			Screen_SaveNextScreenshot(FALSE);
+		burst_left--;
+	}
+#ifdef ASYNC_SCREENSHOTS
+	if (n_writers > 0)
+		ReapWriters(FALSE);
+#endif
+}
+
+void Screen_Exit(void)
+{
+	if (interlace_fp != NULL) {
+		/* the second field is taken from the last frame */
+		WriteScreenshot(interlace_fp, interlace_is_png,
+			interlace_field + ATARI_LEFT_MARGIN, (UBYTE *) Screen_atari + ATARI_LEFT_MARGIN);
+		interlace_fp = NULL;
+	}
+	free(interlace_field);
+	interlace_field = NULL;
+#ifdef ASYNC_SCREENSHOTS
+	while (n_writers > 0)
+		ReapWriters(TRUE);
+#endif
+}
+
 void Screen_EntireDirty(void)
 {
 #ifdef DIRTYRECT
@@ -51,8 +51,20 @@ void Screen_DrawAtariSpeed(double);
 void Screen_DrawDiskLED(void);
 void Screen_Draw1200LED(void);
 void Screen_FindScreenshotFilename(char *buffer, unsigned bufsize);
+/* Saves Screen_atari as a PCX or PNG file, depending on the extension
+   of FILENAME. The file is written in the background if possible.
+   An interlaced screenshot averages Screen_atari with the next frame. */
 int Screen_SaveScreenshot(const char *filename, int interlaced);
 void Screen_SaveNextScreenshot(int interlaced);
+/* Starts saving a burst of screenshots with the next frames, if enabled
+   with -burst-frames. Returns FALSE if not enabled. */
+int Screen_StartScreenshotBurst(void);
+/* Must be called after ANTIC_Frame(TRUE), before anything else is drawn
+   on Screen_atari. */
+void Screen_Frame(void);
+/* Finishes a pending interlaced screenshot and waits for the screenshots
+   still being written. */
+void Screen_Exit(void);
 void Screen_EntireDirty(void);
 
 #endif /* SCREEN_H_ */
@@ -315,6 +315,7 @@ int PLATFORM_Keyboard(void)
 		case SDL_VIDEOEXPOSE:
 			/* When window is "uncovered", and we are in the emulator's menu,
 			   we need to refresh display manually. */
+			SDL_VIDEO_full_redraw = TRUE;
 			PLATFORM_DisplayScreen();
 			break;
 		case SDL_QUIT:
@@ -25,6 +25,7 @@
 #include <SDL.h>
 #include "../sound.h"
 #include "atari.h"
+#include "cassette.h"
 #include "config.h"
 #include "log.h"
 #include "mzpokeysnd.h"
@@ -48,17 +49,53 @@ static int dsprate = 44100;
 #ifdef SYNCHRONIZED_SOUND
 /* latency (in ms) and thus target buffer size */
 static int snddelay = 20;
-/* allowed "spread" between too many and too few samples in the buffer (ms) */
+/* print the statistics of the sound buffer on exit */
+static int sndstats = FALSE;
+/* keep the buffer filled by resampling (TRUE) or only by changing the speed
+   of the emulation (FALSE) */
+static int sndresample = TRUE;
+/* allowed "spread" between too many and too few samples in the buffer (ms),
+   when changing the speed */
 static int sndspread = 7;
-/* estimated gap */
-static int gap_est = 0;
-/* cumulative audio difference */
-static double avg_gap;
-/* dsp_write_pos, dsp_read_pos and callbacktick are accessed in two different threads: */
+/* dsp_write_pos, dsp_read_pos, callbacktick and stat_underflows are accessed
+   in two different threads and protected by ring_mutex. The callback signals
+   ring_space after it has taken sound from the buffer. */
 static int dsp_write_pos;
 static int dsp_read_pos;
 /* tick at which callback occured */
 static int callbacktick = 0;
+static SDL_mutex *ring_mutex = NULL;
+static SDL_cond *ring_space = NULL;
+
+/* Unless -no-sndresample is given, the sound of each frame is resampled by
+   a ratio close to 1 that keeps snddelay ms of sound in the buffer. The
+   ratio comes from a PI controller on the filtered fill level; the gains
+   are per frame, for the error relative to snddelay. With -no-sndresample
+   the sound is rendered straight into the ring buffer instead. */
+#define RATE_KP 0.01
+#define RATE_KI 0.0001
+/* largest change of the ratio - 0.5% is a pitch change of 9 cents */
+#define RATE_MAX_ADJUST 0.005
+/* filtered fill level of the buffer, in ms */
+static double fill_avg;
+/* integral part of the controller's output */
+static double rate_integral;
+/* output samples per emulated sample */
+static double rate_ratio = 1.0;
+/* position of the next output sample in the emulated samples of the next
+   frame; sample -1 is the last one of the previous frame. It is in
+   [-1, 1/rate_ratio - 1), so it is slightly above 0 when the ratio is below
+   1 and the last step of a frame went past the frame's last sample. */
+static double resample_pos;
+static int last_frame[2];
+
+/* statistics since the sound was set up */
+static int stat_updates;
+static double stat_fill_min;
+static double stat_fill_max;
+static double stat_fill_sum;
+static int stat_underflows;
+static int stat_overflows;
 #endif
 
 void Sound_Pause(void)
@@ -80,84 +117,199 @@ void Sound_Continue(void)
 #ifdef SYNCHRONIZED_SOUND
 /* returns a factor (1.0 by default) to adjust the speed of the emulation
  * so that if the sound buffer is too full or too empty, the emulation
- * slows down or speeds up to match the actual speed of sound output */
+ * slows down or speeds up to match the actual speed of sound output.
+ * When resampling, this is done only while the integral part of the ratio
+ * is at its limit, i.e. when the sound output's clock is too far off for
+ * resampling alone. */
 double PLATFORM_AdjustSpeed(void)
 {
-	int bytes_per_sample = (POKEYSND_stereo_enabled ? 2 : 1)*((sound_bits == 16) ? 2:1);
+	if (!sound_enabled)
+		return 1.0;
+	if (sndresample && rate_integral > -RATE_MAX_ADJUST && rate_integral < RATE_MAX_ADJUST)
+		return 1.0;
+	if (fill_avg < snddelay)
+		return 0.95;
+	if (fill_avg > snddelay + sndspread)
+		return 1.05;
+	return 1.0;
+}
 
+/* Filters the fill level of the buffer, FILL ms, and when resampling sets
+   rate_ratio from it. */
+static void UpdateRate(double fill)
+{
 	double alpha = 2.0/(1.0+40.0);
-	int gap_too_small;
-	int gap_too_large;
-	static int inited = FALSE;
+	double error;
+	double adjust;
+
+	/* the fill level jumps at each callback */
+	fill_avg += alpha * (fill - fill_avg);
+
+	if (stat_updates == 0 || fill < stat_fill_min)
+		stat_fill_min = fill;
+	if (stat_updates == 0 || fill > stat_fill_max)
+		stat_fill_max = fill;
+	stat_fill_sum += fill;
+	stat_updates++;
+
+	if (!sndresample)
+		return;
+	error = (snddelay - fill_avg) / snddelay;
+	rate_integral += RATE_KI * error;
+	if (rate_integral > RATE_MAX_ADJUST)
+		rate_integral = RATE_MAX_ADJUST;
+	else if (rate_integral < -RATE_MAX_ADJUST)
+		rate_integral = -RATE_MAX_ADJUST;
+	adjust = RATE_KP * error + rate_integral;
+	if (adjust > RATE_MAX_ADJUST)
+		adjust = RATE_MAX_ADJUST;
+	else if (adjust < -RATE_MAX_ADJUST)
+		adjust = -RATE_MAX_ADJUST;
+	rate_ratio = 1.0 + adjust;
+}
+
+/* Returns the most frames that Resample() can write for FRAMES frames. */
+static int ResampleMax(int frames)
+{
+	if (frames == 0)
+		return 0;
+	/* one more for the rounding of the steps */
+	return (int) ((frames - 1 - resample_pos) * rate_ratio) + 2;
+}
+
+/* Resamples FRAMES frames of CHANNELS samples from MZPOKEYSND_process_buffer
+   by rate_ratio, interpolating linearly, straight into dsp_buffer at byte
+   offset START, wrapping around its end. Returns the number of frames
+   written. */
+static int Resample(int frames, int channels, int start)
+{
+	double step = 1.0 / rate_ratio;
+	double pos = resample_pos;
+	int out = 0;
+	int c;
 
-	if (!inited) {
-		inited = TRUE;
-		avg_gap = gap_est;
+	if (frames == 0)
+		return 0;
+	if (sound_bits == 16) {
+		const SWORD *in = (const SWORD *) MZPOKEYSND_process_buffer;
+		SWORD *ring = (SWORD *) dsp_buffer;
+		SWORD *end = ring + dsp_buffer_bytes/2;
+		SWORD *dst = ring + start/2;
+		for (; pos < frames - 1; pos += step, out++) {
+			int i = (int) (pos + 1.0) - 1;
+			double f = pos - i;
+			for (c = 0; c < channels; c++) {
+				int a = i < 0 ? last_frame[c] : in[i*channels + c];
+				int b = in[(i + 1)*channels + c];
+				*dst++ = (SWORD) (a + (b - a) * f);
+			}
+			if (dst == end)
+				dst = ring;
+		}
+		for (c = 0; c < channels; c++)
+			last_frame[c] = in[(frames - 1)*channels + c];
 	}
 	else {
-		avg_gap = avg_gap + alpha * (gap_est - avg_gap);
+		const UBYTE *in = (const UBYTE *) MZPOKEYSND_process_buffer;
+		UBYTE *ring = (UBYTE *) dsp_buffer;
+		UBYTE *end = ring + dsp_buffer_bytes;
+		UBYTE *dst = ring + start;
+		for (; pos < frames - 1; pos += step, out++) {
+			int i = (int) (pos + 1.0) - 1;
+			double f = pos - i;
+			for (c = 0; c < channels; c++) {
+				int a = i < 0 ? last_frame[c] : in[i*channels + c];
+				int b = in[(i + 1)*channels + c];
+				*dst++ = (UBYTE) (a + (b - a) * f);
+			}
+			if (dst == end)
+				dst = ring;
+		}
+		for (c = 0; c < channels; c++)
+			last_frame[c] = in[(frames - 1)*channels + c];
 	}
+	resample_pos = pos - frames;
+	return out;
+}
 
-	gap_too_small = (snddelay*dsprate*bytes_per_sample)/1000;
-	gap_too_large = ((snddelay+sndspread)*dsprate*bytes_per_sample)/1000;
-	if (avg_gap < gap_too_small) {
-		double speed = 0.95;
-		return speed;
-	}
-	if (avg_gap > gap_too_large) {
-		double speed = 1.05;
-		return speed;
-	}
-	return 1.0;
+void Sound_GetStats(Sound_stats_t *stats)
+{
+	if (ring_mutex != NULL)
+		SDL_LockMutex(ring_mutex);
+	stats->fill_min = stat_fill_min;
+	stats->fill_avg = stat_updates == 0 ? 0.0 : stat_fill_sum / stat_updates;
+	stats->fill_max = stat_fill_max;
+	stats->ratio = rate_ratio;
+	stats->underflows = stat_underflows;
+	stats->overflows = stat_overflows;
+	if (ring_mutex != NULL)
+		SDL_UnlockMutex(ring_mutex);
 }
 #endif /* SYNCHRONIZED_SOUND */
 
 void Sound_Update(void)
 {
 #ifdef SYNCHRONIZED_SOUND
-	int bytes_written = 0;
+	int bytes_written;
+	int max_bytes;
 	int samples_written;
 	int gap;
-	int newpos;
+	int start;
+	int channels = POKEYSND_stereo_enabled ? 2 : 1;
 	int bytes_per_sample;
 	double bytes_per_ms;
+	double fill;
 
-	if (!sound_enabled || Atari800_turbo) return;
-	/* produce samples from the sound emulation */
-	samples_written = MZPOKEYSND_UpdateProcessBuffer();
-	bytes_per_sample = (POKEYSND_stereo_enabled ? 2 : 1)*((sound_bits == 16) ? 2:1);
+	if (!sound_enabled || Atari800_turbo || CASSETTE_Turbo()) return;
+	bytes_per_sample = channels*((sound_bits == 16) ? 2:1);
 	bytes_per_ms = (bytes_per_sample)*(dsprate/1000.0);
-	bytes_written = (sound_bits == 8 ? samples_written : samples_written*2);
-	SDL_LockAudio();
+	SDL_LockMutex(ring_mutex);
 	/* this is the gap as of the most recent callback */
 	gap = dsp_write_pos - dsp_read_pos;
 	/* an estimation of the current gap, adding time since then */
-	if (callbacktick != 0) {
-		gap_est = gap - (bytes_per_ms)*(SDL_GetTicks() - callbacktick);
+	fill = gap / bytes_per_ms;
+	if (callbacktick != 0)
+		fill -= SDL_GetTicks() - callbacktick;
+	SDL_UnlockMutex(ring_mutex);
+
+	UpdateRate(fill);
+	if (sndresample) {
+		/* produce samples from the sound emulation */
+		samples_written = MZPOKEYSND_UpdateProcessBuffer();
+		max_bytes = ResampleMax(samples_written/channels)*bytes_per_sample;
 	}
+	else
+		/* the frame is rendered below, straight into the ring */
+		max_bytes = MZPOKEYSND_FrameBytes();
+
+	SDL_LockMutex(ring_mutex);
+	gap = dsp_write_pos - dsp_read_pos;
 	/* if there isn't enough room... */
-	while (gap + bytes_written > dsp_buffer_bytes) {
-		/* then we allow the callback to run.. */
-		SDL_UnlockAudio();
-		/* and delay until it runs and allows space. */
-		SDL_Delay(1);
-		SDL_LockAudio();
-		/*printf("sound buffer overflow:%d %d\n",gap, dsp_buffer_bytes);*/
-		gap = dsp_write_pos - dsp_read_pos;
-	}
-	/* now we copy the data into the buffer and adjust the positions */
-	newpos = dsp_write_pos + bytes_written;
-	if (newpos/dsp_buffer_bytes == dsp_write_pos/dsp_buffer_bytes) {
-		/* no wrap */
-		memcpy(dsp_buffer+(dsp_write_pos%dsp_buffer_bytes), MZPOKEYSND_process_buffer, bytes_written);
-	}
-	else {
-		/* wraps */
-		int first_part_size = dsp_buffer_bytes - (dsp_write_pos%dsp_buffer_bytes);
-		memcpy(dsp_buffer+(dsp_write_pos%dsp_buffer_bytes), MZPOKEYSND_process_buffer, first_part_size);
-		memcpy(dsp_buffer, MZPOKEYSND_process_buffer+first_part_size, bytes_written-first_part_size);
+	if (gap + max_bytes > dsp_buffer_bytes) {
+		stat_overflows++;
+		do {
+			/* then wait until the callback makes room */
+			if (SDL_CondWaitTimeout(ring_space, ring_mutex, 100) == SDL_MUTEX_TIMEDOUT
+			    && sndresample) {
+				/* the audio is stopped, drop this frame */
+				SDL_UnlockMutex(ring_mutex);
+				return;
+			}
+			gap = dsp_write_pos - dsp_read_pos;
+		} while (gap + max_bytes > dsp_buffer_bytes);
 	}
-	dsp_write_pos = newpos;
+	start = dsp_write_pos%dsp_buffer_bytes;
+	SDL_UnlockMutex(ring_mutex);
+
+	/* The callback reads only before dsp_write_pos, so the free part of
+	   the buffer is written without holding the lock. */
+	if (sndresample)
+		bytes_written = Resample(samples_written/channels, channels, start)*bytes_per_sample;
+	else
+		bytes_written = MZPOKEYSND_UpdateRing(dsp_buffer, dsp_buffer_bytes, start)*((sound_bits == 16) ? 2 : 1);
+
+	SDL_LockMutex(ring_mutex);
+	dsp_write_pos += bytes_written;
 	if (callbacktick == 0) {
 		/* Sound callback has not yet been called */
 		dsp_read_pos += bytes_written;
@@ -170,7 +322,7 @@ void Sound_Update(void)
 		dsp_write_pos -= dsp_buffer_bytes;
 		dsp_read_pos -= dsp_buffer_bytes;
 	}
-	SDL_UnlockAudio();
+	SDL_UnlockMutex(ring_mutex);
 #else /* SYNCHRONIZED_SOUND */
 	/* fake function */
 #endif /* SYNCHRONIZED_SOUND */
@@ -191,10 +343,12 @@ static void SoundCallback(void *userdata, Uint8 *stream, int len)
 #define MAX_SAMPLE_SIZE 4
 	static char last_bytes[MAX_SAMPLE_SIZE];
 	int bytes_per_sample = (POKEYSND_stereo_enabled ? 2 : 1)*((sound_bits == 16) ? 2:1);
+	SDL_LockMutex(ring_mutex);
 	gap = dsp_write_pos - dsp_read_pos;
 	if (gap < len) {
 		underflow_amount = len - gap;
 		len = gap;
+		stat_underflows++;
 		/*return;*/
 	}
 	newpos = dsp_read_pos + len;
@@ -221,6 +375,8 @@ static void SoundCallback(void *userdata, Uint8 *stream, int len)
 	}
 	dsp_read_pos = newpos;
 	callbacktick = SDL_GetTicks();
+	SDL_CondSignal(ring_space);
+	SDL_UnlockMutex(ring_mutex);
 #endif /* SYNCHRONIZED_SOUND */
 }
 
@@ -263,9 +419,22 @@ static void SoundSetup(void)
 			int dsp_buffer_samps = frag_samps*DSP_BUFFER_FRAGS +specified_delay_samps;
 			int bytes_per_sample = (POKEYSND_stereo_enabled ? 2 : 1)*((sound_bits == 16) ? 2:1);
 			dsp_buffer_bytes = desired.channels*dsp_buffer_samps*(sound_bits == 8 ? 1 : 2);
+			if (ring_mutex == NULL) {
+				ring_mutex = SDL_CreateMutex();
+				ring_space = SDL_CreateCond();
+			}
 			dsp_read_pos = 0;
 			dsp_write_pos = (specified_delay_samps+frag_samps)*bytes_per_sample;
-			avg_gap = 0.0;
+			callbacktick = 0;
+			fill_avg = snddelay;
+			rate_integral = 0.0;
+			rate_ratio = 1.0;
+			resample_pos = -1.0;
+			last_frame[0] = last_frame[1] = (sound_bits == 8 ? 0x80 : 0);
+			stat_updates = 0;
+			stat_fill_min = stat_fill_max = stat_fill_sum = 0.0;
+			stat_underflows = 0;
+			stat_overflows = 0;
 		}
 #else
 		dsp_buffer_bytes = desired.channels*frag_samps*(sound_bits == 8 ? 1 : 2);
@@ -312,11 +481,23 @@ int Sound_Initialise(int *argc, char *argv[])
 			else a_m = TRUE;
 		}
 #ifdef SYNCHRONIZED_SOUND
-		else if (strcmp(argv[i], "-snddelay") == 0)
+		else if (strcmp(argv[i], "-snddelay") == 0) {
 			if (i_a) {
 				snddelay = Util_sscandec(argv[++i]);
+				if (snddelay < 1) {
+					Log_print("Invalid sound delay - must be at least 1 ms");
+					sound_enabled = FALSE;
+					return FALSE;
+				}
 			}
 			else a_m = TRUE;
+		}
+		else if (strcmp(argv[i], "-sndstats") == 0)
+			sndstats = TRUE;
+		else if (strcmp(argv[i], "-sndresample") == 0)
+			sndresample = TRUE;
+		else if (strcmp(argv[i], "-no-sndresample") == 0)
+			sndresample = FALSE;
 #endif
 		else {
 			if (strcmp(argv[i], "-help") == 0) {
@@ -328,6 +509,9 @@ int Sound_Initialise(int *argc, char *argv[])
 				Log_print("\t-dsprate <rate>  Set DSP rate in Hz");
 #ifdef SYNCHRONIZED_SOUND
 				Log_print("\t-snddelay <ms>   Set audio latency in ms");
+				Log_print("\t-sndstats        Show statistics of the sound buffer on exit");
+				Log_print("\t-sndresample     Keep the sound buffer filled by resampling (default)");
+				Log_print("\t-no-sndresample  Keep it filled only by changing the speed");
 #endif
 			}
 			argv[j++] = argv[i];
@@ -358,6 +542,23 @@ int Sound_Initialise(int *argc, char *argv[])
 
 void Sound_Exit(void)
 {
+#ifdef SYNCHRONIZED_SOUND
+	if (sndstats && sound_enabled) {
+		Sound_stats_t stats;
+		Sound_GetStats(&stats);
+		Log_print("Sound buffer: %.1f/%.1f/%.1f ms min/avg/max, ratio %.5f, %d underflows, %d overflows",
+		          stats.fill_min, stats.fill_avg, stats.fill_max, stats.ratio,
+		          stats.underflows, stats.overflows);
+	}
+#endif
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
 	sound_enabled = FALSE;
+#ifdef SYNCHRONIZED_SOUND
+	if (ring_mutex != NULL) {
+		SDL_DestroyCond(ring_space);
+		SDL_DestroyMutex(ring_mutex);
+		ring_space = NULL;
+		ring_mutex = NULL;
+	}
+#endif
 }
@@ -23,12 +23,18 @@
 */
 
 #include <SDL.h>
+#include <string.h>
+#include <time.h>
 
 #include "af80.h"
+#include "antic.h"
 #include "artifact.h"
 #include "atari.h"
 #include "colours.h"
 #include "config.h"
+#ifdef HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#endif
 #include "filter_ntsc.h"
 #include "log.h"
 #ifdef PAL_BLENDING
@@ -76,6 +82,31 @@ int SDL_VIDEO_vsync_available;
 
 static int window_maximised = FALSE;
 
+int SDL_VIDEO_full_redraw = TRUE;
+
+int SDL_VIDEO_blink = FALSE;
+/* Frame counter for SDL_VIDEO_blink. */
+static int blink_frame = 0;
+
+/* Runs of changed lines separated by at most this many unchanged lines are
+   merged, as each run has its own cost (rectangle update, texture upload). */
+#define DIRTY_LINES_GAP 8
+
+/* Display statistics, printed on exit with -video-stats. */
+static int show_stats = FALSE;
+static unsigned long stats_frames = 0;
+static unsigned long stats_skipped = 0;
+static double stats_lines = 0.0;
+static double stats_bytes = 0.0;
+static clock_t stats_cpu = 0;
+/* Frame pacing of the OpenGL path, see SDL_VIDEO_PacingDone. */
+static unsigned long pacing_frames = 0;
+static unsigned long pacing_orphaned = 0;
+static double pacing_upload = 0.0;
+static double pacing_upload_max = 0.0;
+static double pacing_swap = 0.0;
+static double pacing_swap_max = 0.0;
+
 #if HAVE_WINDOWS_H
 /* Contains TRUE if the user chose a video backend by setting
    the SDL_VIDEODRIVER environment variable. */
@@ -101,6 +132,7 @@ void SDL_VIDEO_UpdatePaletteLookup(VIDEOMODE_MODE_t mode, int bpp_32)
 
 void PLATFORM_PaletteUpdate(void)
 {
+	SDL_VIDEO_full_redraw = TRUE;
 	if (SDL_VIDEO_current_display_mode == VIDEOMODE_MODE_NTSC_FILTER)
 		FILTER_NTSC_Update(FILTER_NTSC_emu);
 	else {
@@ -208,6 +240,7 @@ void PLATFORM_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed, VIDE
 #endif
 	SDL_VIDEO_current_display_mode = mode;
 	UpdateNtscFilter(mode);
+	SDL_VIDEO_full_redraw = TRUE;
 	PLATFORM_DisplayScreen();
 
 	/* For unknown reason (maybe window manager-related), when SDL_SetVideoMode
@@ -272,14 +305,143 @@ int PLATFORM_WindowMaximised(void)
 	return window_maximised;
 }
 
+/* Advances the blink phase of the 80-column displays and finds
+   the changed lines of the Proto80 screen. */
+static void Update80Column(void)
+{
+	switch (SDL_VIDEO_current_display_mode) {
+	case VIDEOMODE_MODE_PROTO80:
+		PBI_PROTO80_FindChanges();
+		return;
+	case VIDEOMODE_MODE_XEP80:
+	case VIDEOMODE_MODE_AF80:
+		if (++blink_frame == 60)
+			blink_frame = 0;
+		if ((blink_frame >= 30) != SDL_VIDEO_blink) {
+			/* blinking characters can be anywhere */
+			SDL_VIDEO_blink = !SDL_VIDEO_blink;
+			SDL_VIDEO_full_redraw = TRUE;
+		}
+		return;
+	default:
+		return;
+	}
+}
+
 void PLATFORM_DisplayScreen(void)
 {
+	clock_t start = 0;
+	if (show_stats)
+		start = clock();
+	Update80Column();
 #if HAVE_OPENGL
 	if (SDL_VIDEO_opengl)
 		SDL_VIDEO_GL_DisplayScreen();
 	else
 #endif
 		SDL_VIDEO_SW_DisplayScreen();
+	if (show_stats)
+		stats_cpu += clock() - start;
+}
+
+double SDL_VIDEO_StatsTime(void)
+{
+#ifdef HAVE_GETTIMEOFDAY
+	/* SDL_GetTicks() is too coarse to time a single frame */
+	struct timeval tp;
+	if (!show_stats)
+		return 0.0;
+	gettimeofday(&tp, NULL);
+	return tp.tv_sec + 1e-6 * tp.tv_usec;
+#else
+	if (!show_stats)
+		return 0.0;
+	return SDL_GetTicks() * 1e-3;
+#endif
+}
+
+void SDL_VIDEO_PacingDone(double upload, double swap, int orphaned)
+{
+	if (!show_stats)
+		return;
+	pacing_frames++;
+	pacing_orphaned += orphaned;
+	pacing_upload += upload;
+	if (upload > pacing_upload_max)
+		pacing_upload_max = upload;
+	pacing_swap += swap;
+	if (swap > pacing_swap_max)
+		pacing_swap_max = swap;
+}
+
+/* Returns the flags of changed lines of the source of the current display
+   mode and stores their number in *SIZE, or returns NULL if changes
+   are not tracked. */
+static UBYTE *DirtyLines(int *size)
+{
+	switch (SDL_VIDEO_current_display_mode) {
+	case VIDEOMODE_MODE_XEP80:
+		*size = XEP80_MAX_SCRN_HEIGHT;
+		return XEP80_scanline_dirty;
+	case VIDEOMODE_MODE_PROTO80:
+		*size = PBI_PROTO80_SCRN_HEIGHT;
+		return PBI_PROTO80_scanline_dirty;
+	case VIDEOMODE_MODE_AF80:
+		*size = AF80_SCRN_HEIGHT;
+		return AF80_scanline_dirty;
+	default:
+#ifndef NO_RENDER_CACHE
+		*size = Screen_HEIGHT;
+		return ANTIC_scanline_dirty;
+#else
+		return NULL;
+#endif
+	}
+}
+
+int SDL_VIDEO_NextDirtyLines(int partial, int *y, int *height)
+{
+	int first = *y;
+	int size;
+	UBYTE const *dirty;
+	if (first >= (int) VIDEOMODE_src_height)
+		return FALSE;
+	if (partial && !SDL_VIDEO_full_redraw && (dirty = DirtyLines(&size)) != NULL) {
+		int end;
+		int gap = 0;
+		dirty += VIDEOMODE_src_offset_top;
+		while (!dirty[first]) {
+			if (++first >= (int) VIDEOMODE_src_height)
+				return FALSE;
+		}
+		for (end = first + 1; end < (int) VIDEOMODE_src_height && gap <= DIRTY_LINES_GAP; end++) {
+			if (dirty[end])
+				gap = 0;
+			else
+				gap++;
+		}
+		*y = first;
+		*height = end - gap - first;
+		return TRUE;
+	}
+	if (first > 0)
+		return FALSE;
+	*height = VIDEOMODE_src_height;
+	return TRUE;
+}
+
+void SDL_VIDEO_DisplayDone(int lines, int bytes)
+{
+	int size;
+	UBYTE *dirty = DirtyLines(&size);
+	if (dirty != NULL)
+		memset(dirty, 0, size);
+	SDL_VIDEO_full_redraw = FALSE;
+	stats_frames++;
+	if (lines == 0)
+		stats_skipped++;
+	stats_lines += lines;
+	stats_bytes += bytes;
 }
 
 int SDL_VIDEO_ReadConfig(char *option, char *parameters)
@@ -398,6 +560,8 @@ int SDL_VIDEO_Initialise(int *argc, char *argv[])
 			SDL_VIDEO_vsync = TRUE;
 		else if (strcmp(argv[i], "-no-vsync") == 0)
 			SDL_VIDEO_vsync = FALSE;
+		else if (strcmp(argv[i], "-video-stats") == 0)
+			show_stats = TRUE;
 		else {
 			if (strcmp(argv[i], "-help") == 0) {
 				help_only = TRUE;
@@ -410,6 +574,7 @@ int SDL_VIDEO_Initialise(int *argc, char *argv[])
 #endif /* HAVE_OPENGL */
 				Log_print("\t-vsync            Synchronize display to vertical retrace");
 				Log_print("\t-no-vsync         Don't synchronize display to vertical retrace");
+				Log_print("\t-video-stats      Print display statistics on exit");
 			}
 			argv[j++] = argv[i];
 		}
@@ -448,6 +613,14 @@ int SDL_VIDEO_Initialise(int *argc, char *argv[])
 
 void SDL_VIDEO_Exit(void)
 {
+	if (show_stats && stats_frames > 0)
+		Log_print("Video: %lu frames displayed, %lu unchanged; per frame: %.1f lines, %.1f KB converted, %.3f ms CPU",
+		          stats_frames, stats_skipped, stats_lines / stats_frames, stats_bytes / stats_frames / 1024,
+		          (double) stats_cpu * 1000 / CLOCKS_PER_SEC / stats_frames);
+	if (show_stats && pacing_frames > 0)
+		Log_print("OpenGL: %lu frames swapped; upload %.3f ms (max %.3f), swap wait %.3f ms (max %.3f); %lu busy PBOs orphaned",
+		          pacing_frames, pacing_upload * 1000 / pacing_frames, pacing_upload_max * 1000,
+		          pacing_swap * 1000 / pacing_frames, pacing_swap_max * 1000, pacing_orphaned);
 	SDL_VIDEO_QuitSDL();
 	if (FILTER_NTSC_emu) {
 		/* Turning filter off */
@@ -753,6 +926,7 @@ void SDL_VIDEO_SetScanlinesPercentage(int value)
 	else if (value > 100)
 		value = 100;
 	SDL_VIDEO_scanlines_percentage = value;
+	SDL_VIDEO_full_redraw = TRUE;
 #if HAVE_OPENGL
 	SDL_VIDEO_GL_ScanlinesPercentageChanged();
 #endif /* HAVE_OPENGL */
@@ -761,6 +935,7 @@ void SDL_VIDEO_SetScanlinesPercentage(int value)
 void SDL_VIDEO_SetInterpolateScanlines(int value)
 {
 	SDL_VIDEO_interpolate_scanlines = value;
+	SDL_VIDEO_full_redraw = TRUE;
 #if HAVE_OPENGL
 	SDL_VIDEO_GL_InterpolateScanlinesChanged();
 #endif /* HAVE_OPENGL */
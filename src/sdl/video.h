@@ -80,4 +80,34 @@ void SDL_VIDEO_BlitAF80_32(Uint32 *dest, int first_column, int last_column, int
 /* Update lookup tables for the blit functions. */
 void SDL_VIDEO_UpdatePaletteLookup(VIDEOMODE_MODE_t mode, int bpp_32);
 
+/* Set to TRUE when the displayed image no longer matches Screen_atari
+   (e.g. after a video mode or palette change), so that the next
+   PLATFORM_DisplayScreen() redraws it all. */
+extern int SDL_VIDEO_full_redraw;
+
+/* TRUE in the half of the blink cycle in which the 80-column displays hide
+   their blinking characters and cursor. Updated by PLATFORM_DisplayScreen(). */
+extern int SDL_VIDEO_blink;
+
+/* Finds the next run of lines of the displayed area that must be redrawn,
+   starting at line *Y (counted from VIDEOMODE_src_offset_top). Stores the
+   first line of the run in *Y and its length in *HEIGHT, or returns FALSE
+   if there are no more such lines. If PARTIAL is FALSE, the whole area is
+   returned at once. */
+int SDL_VIDEO_NextDirtyLines(int partial, int *y, int *height);
+
+/* Called at the end of PLATFORM_DisplayScreen() with the number of LINES
+   and BYTES converted to the host format (0 if the frame was skipped).
+   Marks all lines of the current display mode as displayed. */
+void SDL_VIDEO_DisplayDone(int lines, int bytes);
+
+/* Returns the wall-clock time in seconds, or 0 if display statistics
+   are not collected (-video-stats). */
+double SDL_VIDEO_StatsTime(void);
+
+/* Called by the OpenGL path after each buffer swap with the time in seconds
+   spent on the texture UPLOAD and waiting in SWAP, and the number of PBOs
+   that were still in use and had to be ORPHANED. */
+void SDL_VIDEO_PacingDone(double upload, double swap, int orphaned);
+
 #endif /* SDL_VIDEO_H_ */
@@ -94,8 +94,22 @@ struct
 	void(APIENTRY*BufferData)(GLenum, GLsizeiptr, const GLvoid*, GLenum);
 	void*(APIENTRY*MapBuffer)(GLenum, GLenum);
 	GLboolean(APIENTRY*UnmapBuffer)(GLenum);
+	/* GL_ARB_sync, optional. Sync objects are passed as void *. */
+	void*(APIENTRY*FenceSync)(GLenum, GLbitfield);
+	void(APIENTRY*GetSynciv)(void*, GLenum, GLsizei, GLsizei*, GLint*);
+	void(APIENTRY*DeleteSync)(void*);
 } gl;
 
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_STATUS
+#define GL_SYNC_STATUS 0x9114
+#endif
+#ifndef GL_SIGNALED
+#define GL_SIGNALED 0x9119
+#endif
+
 static void DisplayNormal(GLvoid *dest);
 static void DisplayNTSCEmu(GLvoid *dest);
 static void DisplayXEP80(GLvoid *dest);
@@ -113,6 +127,21 @@ static void (* blit_funcs[VIDEOMODE_MODE_SIZE])(GLvoid *) = {
 	&DisplayAF80
 };
 
+static void DisplayNormalLines(GLvoid *dest, int y, int height);
+static void DisplayXEP80Lines(GLvoid *dest, int y, int height);
+static void DisplayProto80Lines(GLvoid *dest, int y, int height);
+static void DisplayAF80Lines(GLvoid *dest, int y, int height);
+
+/* Functions that convert only the given lines of the screen, for the modes
+   that can upload just the changed lines. NULL for the other modes. */
+static void (* lines_funcs[VIDEOMODE_MODE_SIZE])(GLvoid *, int, int) = {
+	&DisplayNormalLines,
+	NULL,
+	&DisplayXEP80Lines,
+	&DisplayProto80Lines,
+	&DisplayAF80Lines
+};
+
 /* GL textures - [0] is screen, [1] is scanlines. */
 static GLuint textures[2];
 
@@ -121,8 +150,19 @@ int SDL_VIDEO_GL_pbo = TRUE;
 /* Indicates whether Pixel Buffer Objects GL extension is available.
    Available from OpenGL 2.1, it gives a significant boost in blit speed. */
 static int pbo_available;
-/* Name of the main screen Pixel Buffer Object. */
-static GLuint screen_pbo;
+/* Indicates whether fence sync objects (GL_ARB_sync) are available. */
+static int sync_available;
+/* The screen is written to a ring of Pixel Buffer Objects, each frame to
+   the next one, so that the CPU doesn't wait for the upload of the previous
+   frame to finish. Each upload is followed by a fence; a PBO whose fence
+   hasn't signalled yet is orphaned instead of waited for. */
+#define PBO_RING_SIZE 3
+static GLuint screen_pbos[PBO_RING_SIZE];
+static void *pbo_fences[PBO_RING_SIZE];
+static int pbo_index = 0;
+/* Number of PBOs orphaned since the last frame, for the statistics. */
+static int pbo_orphaned = 0;
+#define PBO_SIZE (1024*512*(bpp_32 ? sizeof(Uint32) : sizeof(Uint16)))
 
 /* Data for the screen texture. not used when PBOs are used. */
 static GLvoid *screen_texture = NULL;
@@ -241,20 +281,29 @@ static void InitGlContext(void)
 	gl.MatrixMode(GL_MODELVIEW);
 	gl.LoadIdentity();
 	screen_dlist = gl.GenLists(1);
-	if (SDL_VIDEO_GL_pbo)
-		gl.GenBuffers(1, &screen_pbo);
+	if (SDL_VIDEO_GL_pbo) {
+		gl.GenBuffers(PBO_RING_SIZE, screen_pbos);
+		pbo_index = 0;
+	}
 }
 
 /* Cleans up the structures allocated in InitGlContext. */
 static void CleanGlContext(void)
 {
-		if (SDL_VIDEO_GL_pbo)
-			gl.DeleteBuffers(1, &screen_pbo);
+		if (SDL_VIDEO_GL_pbo) {
+			int i;
+			for (i = 0; i < PBO_RING_SIZE; i++)
+				if (pbo_fences[i] != NULL) {
+					gl.DeleteSync(pbo_fences[i]);
+					pbo_fences[i] = NULL;
+				}
+			gl.DeleteBuffers(PBO_RING_SIZE, screen_pbos);
+		}
 		gl.DeleteLists(screen_dlist, 1);
 		gl.DeleteTextures(2, textures);
 }
 
-/* Sets up the initial parameters of all used textures and the PBO. */
+/* Sets up the initial parameters of all used textures and the PBOs. */
 static void InitGlTextures(void)
 {
 	/* Texture for the display surface. */
@@ -273,8 +322,11 @@ static void InitGlTextures(void)
 		              GL_BGRA, GL_UNSIGNED_SHORT_1_5_5_5_REV,
 		              scanline_tex16);
 	if (SDL_VIDEO_GL_pbo) {
-		gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, screen_pbo);
-		gl.BufferData(GL_PIXEL_UNPACK_BUFFER_ARB, 1024*512*(bpp_32 ? sizeof(Uint32) : sizeof(Uint16)), NULL, GL_DYNAMIC_DRAW_ARB);
+		int i;
+		for (i = 0; i < PBO_RING_SIZE; i++) {
+			gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, screen_pbos[i]);
+			gl.BufferData(GL_PIXEL_UNPACK_BUFFER_ARB, PBO_SIZE, NULL, GL_STREAM_DRAW_ARB);
+		}
 		gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
 	}
 }
@@ -413,15 +465,46 @@ static void SetGlDisplayList(void)
 	gl.EndList();
 }
 
+/* Binds the next PBO of the ring and maps it for writing. If the GPU may
+   still be reading the PBO, its storage is orphaned: the driver then gives
+   it new memory instead of blocking until the previous upload is done.
+   Returns NULL if mapping fails. */
+static GLvoid *MapPbo(void)
+{
+	void *fence;
+	pbo_index = (pbo_index + 1) % PBO_RING_SIZE;
+	gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, screen_pbos[pbo_index]);
+	fence = pbo_fences[pbo_index];
+	if (!sync_available || fence != NULL) {
+		GLint status = GL_SIGNALED;
+		if (fence != NULL) {
+			gl.GetSynciv(fence, GL_SYNC_STATUS, 1, NULL, &status);
+			gl.DeleteSync(fence);
+			pbo_fences[pbo_index] = NULL;
+		}
+		if (!sync_available || status != GL_SIGNALED) {
+			gl.BufferData(GL_PIXEL_UNPACK_BUFFER_ARB, PBO_SIZE, NULL, GL_STREAM_DRAW_ARB);
+			pbo_orphaned++;
+		}
+	}
+	return gl.MapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+}
+
+/* Puts a fence after the uploads from the current PBO and unbinds it. */
+static void UnbindPbo(void)
+{
+	if (sync_available)
+		pbo_fences[pbo_index] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+}
+
 /* Resets the screen texture/PBO to all-black. */
 static void CleanDisplayTexture(void)
 {
 	GLvoid *ptr;
 	gl.BindTexture(GL_TEXTURE_2D, textures[0]);
-	if (SDL_VIDEO_GL_pbo) {
-		gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, screen_pbo);
-		ptr = gl.MapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
-	}
+	if (SDL_VIDEO_GL_pbo)
+		ptr = MapPbo();
 	else
 		ptr = screen_texture;
 	if (bpp_32) {
@@ -446,7 +529,7 @@ static void CleanDisplayTexture(void)
 				GL_RGB, GL_UNSIGNED_SHORT_5_6_5,
 				ptr);
 	if (SDL_VIDEO_GL_pbo)
-		gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+		UnbindPbo();
 }
 
 /* Sets pointers to OpenGL functions. Returns TRUE on success, FALSE on failure. */
@@ -499,6 +582,10 @@ static int InitGlPbo(void)
 	    (gl.UnmapBuffer = (GLboolean(APIENTRY*)(GLenum))GetGlFunc("glUnmapBufferARB")) == NULL)
 		return FALSE;
 
+	sync_available = strstr((char *)extensions, "GL_ARB_sync") != NULL &&
+	    (gl.FenceSync = (void*(APIENTRY*)(GLenum, GLbitfield))GetGlFunc("glFenceSync")) != NULL &&
+	    (gl.GetSynciv = (void(APIENTRY*)(void*, GLenum, GLsizei, GLsizei*, GLint*))GetGlFunc("glGetSynciv")) != NULL &&
+	    (gl.DeleteSync = (void(APIENTRY*)(void*))GetGlFunc("glDeleteSync")) != NULL;
 	return TRUE;
 }
 
@@ -578,7 +665,7 @@ int SDL_VIDEO_GL_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed, V
 		if (new) {
 			Log_print("OpenGL initialized successfully. Version: %s", gl.GetString(GL_VERSION));
 			if (pbo_available)
-				Log_print("OpenGL Pixel Buffer Objects available.");
+				Log_print("OpenGL Pixel Buffer Objects available%s.", sync_available ? ", with fences" : "");
 			else
 			Log_print("OpenGL Pixel Buffer Objects not available.");
 		}
@@ -600,11 +687,16 @@ int SDL_VIDEO_GL_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed, V
 
 	if (mode == VIDEOMODE_MODE_NORMAL) {
 #ifdef PAL_BLENDING
-		if (ARTIFACT_mode == ARTIFACT_PAL_BLEND)
+		if (ARTIFACT_mode == ARTIFACT_PAL_BLEND) {
 			blit_funcs[0] = &DisplayPalBlending;
+			lines_funcs[0] = NULL;
+		}
 		else
 #endif /* PAL_BLENDING */
+		{
 			blit_funcs[0] = &DisplayNormal;
+			lines_funcs[0] = &DisplayNormalLines;
+		}
 	}
 
 	gl.Viewport(VIDEOMODE_dest_offset_left, VIDEOMODE_dest_offset_top, VIDEOMODE_dest_width, VIDEOMODE_dest_height);
@@ -620,21 +712,28 @@ int SDL_VIDEO_GL_SupportsVideomode(VIDEOMODE_MODE_t mode, int stretch, int rotat
 	return TRUE;
 }
 
-static void DisplayNormal(GLvoid *dest)
+/* Writes HEIGHT lines starting at line Y of the displayed area
+   into the texture buffer DEST. */
+static void DisplayNormalLines(GLvoid *dest, int y, int height)
 {
-	Uint8 *screen = (Uint8 *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	Uint8 *screen = (Uint8 *)Screen_atari + Screen_WIDTH * (VIDEOMODE_src_offset_top + y) + VIDEOMODE_src_offset_left;
 	if (bpp_32)
-		SDL_VIDEO_BlitNormal32((Uint32*)dest, screen, VIDEOMODE_actual_width, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp32);
+		SDL_VIDEO_BlitNormal32((Uint32*)dest + VIDEOMODE_actual_width * y, screen, VIDEOMODE_actual_width, VIDEOMODE_src_width, height, SDL_PALETTE_buffer.bpp32);
 	else {
 		int pitch;
 		if (VIDEOMODE_actual_width & 0x01)
 			pitch = VIDEOMODE_actual_width / 2 + 1;
 		else
 			pitch = VIDEOMODE_actual_width / 2;
-		SDL_VIDEO_BlitNormal16((Uint32*)dest, screen, pitch, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp16);
+		SDL_VIDEO_BlitNormal16((Uint32*)dest + pitch * y, screen, pitch, VIDEOMODE_src_width, height, SDL_PALETTE_buffer.bpp16);
 	}
 }
 
+static void DisplayNormal(GLvoid *dest)
+{
+	DisplayNormalLines(dest, 0, VIDEOMODE_src_height);
+}
+
 #ifdef PAL_BLENDING
 static void DisplayPalBlending(GLvoid *dest)
 {
@@ -664,74 +763,122 @@ static void DisplayNTSCEmu(GLvoid *dest)
 		VIDEOMODE_actual_width * (bpp_32 ? 4 : 2));
 }
 
-static void DisplayXEP80(GLvoid *dest)
+static void DisplayXEP80Lines(GLvoid *dest, int y, int height)
 {
-	static int xep80Frame = 0;
-	Uint8 *screen;
-	xep80Frame++;
-	if (xep80Frame == 60) xep80Frame = 0;
-	if (xep80Frame > 29)
-		screen = XEP80_screen_1;
-	else
-		screen = XEP80_screen_2;
-
-	screen += XEP80_SCRN_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	Uint8 *screen = SDL_VIDEO_blink ? XEP80_screen_2 : XEP80_screen_1;
+	screen += XEP80_SCRN_WIDTH * (VIDEOMODE_src_offset_top + y) + VIDEOMODE_src_offset_left;
 	if (bpp_32)
-		SDL_VIDEO_BlitXEP80_32((Uint32*)dest, screen, VIDEOMODE_actual_width, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp32);
+		SDL_VIDEO_BlitXEP80_32((Uint32*)dest + VIDEOMODE_actual_width * y, screen, VIDEOMODE_actual_width, VIDEOMODE_src_width, height, SDL_PALETTE_buffer.bpp32);
 	else
-		SDL_VIDEO_BlitXEP80_16((Uint32*)dest, screen, VIDEOMODE_actual_width / 2, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp16);
+		SDL_VIDEO_BlitXEP80_16((Uint32*)dest + VIDEOMODE_actual_width / 2 * y, screen, VIDEOMODE_actual_width / 2, VIDEOMODE_src_width, height, SDL_PALETTE_buffer.bpp16);
 }
 
-static void DisplayProto80(GLvoid *dest)
+static void DisplayXEP80(GLvoid *dest)
+{
+	DisplayXEP80Lines(dest, 0, VIDEOMODE_src_height);
+}
+
+static void DisplayProto80Lines(GLvoid *dest, int y, int height)
 {
 	int first_column = (VIDEOMODE_src_offset_left+7) / 8;
 	int last_column = (VIDEOMODE_src_offset_left + VIDEOMODE_src_width) / 8;
-	int first_line = VIDEOMODE_src_offset_top;
-	int last_line = first_line + VIDEOMODE_src_height;
+	int first_line = VIDEOMODE_src_offset_top + y;
+	int last_line = first_line + height;
 	if (bpp_32)
-		SDL_VIDEO_BlitProto80_32((Uint32*)dest, first_column, last_column, VIDEOMODE_actual_width, first_line, last_line, SDL_PALETTE_buffer.bpp32);
+		SDL_VIDEO_BlitProto80_32((Uint32*)dest + VIDEOMODE_actual_width * y, first_column, last_column, VIDEOMODE_actual_width, first_line, last_line, SDL_PALETTE_buffer.bpp32);
 	else
-		SDL_VIDEO_BlitProto80_16((Uint32*)dest, first_column, last_column, VIDEOMODE_actual_width/2, first_line, last_line, SDL_PALETTE_buffer.bpp16);
+		SDL_VIDEO_BlitProto80_16((Uint32*)dest + VIDEOMODE_actual_width / 2 * y, first_column, last_column, VIDEOMODE_actual_width/2, first_line, last_line, SDL_PALETTE_buffer.bpp16);
 }
 
-static void DisplayAF80(GLvoid *dest)
+static void DisplayProto80(GLvoid *dest)
+{
+	DisplayProto80Lines(dest, 0, VIDEOMODE_src_height);
+}
+
+static void DisplayAF80Lines(GLvoid *dest, int y, int height)
 {
 	int first_column = (VIDEOMODE_src_offset_left+7) / 8;
 	int last_column = (VIDEOMODE_src_offset_left + VIDEOMODE_src_width) / 8;
-	int first_line = VIDEOMODE_src_offset_top;
-	int last_line = first_line + VIDEOMODE_src_height;
-	static int AF80Frame = 0;
-	int blink;
-	AF80Frame++;
-	if (AF80Frame == 60) AF80Frame = 0;
-	blink = AF80Frame >= 30;
+	int first_line = VIDEOMODE_src_offset_top + y;
+	int last_line = first_line + height;
 	if (bpp_32)
-		SDL_VIDEO_BlitAF80_32((Uint32*)dest, first_column, last_column, VIDEOMODE_actual_width, first_line, last_line, blink, SDL_PALETTE_buffer.bpp32);
+		SDL_VIDEO_BlitAF80_32((Uint32*)dest + VIDEOMODE_actual_width * y, first_column, last_column, VIDEOMODE_actual_width, first_line, last_line, SDL_VIDEO_blink, SDL_PALETTE_buffer.bpp32);
 	else
-		SDL_VIDEO_BlitAF80_16((Uint32*)dest, first_column, last_column, VIDEOMODE_actual_width/2, first_line, last_line, blink, SDL_PALETTE_buffer.bpp16);
+		SDL_VIDEO_BlitAF80_16((Uint32*)dest + VIDEOMODE_actual_width / 2 * y, first_column, last_column, VIDEOMODE_actual_width/2, first_line, last_line, SDL_VIDEO_blink, SDL_PALETTE_buffer.bpp16);
+}
+
+static void DisplayAF80(GLvoid *dest)
+{
+	DisplayAF80Lines(dest, 0, VIDEOMODE_src_height);
 }
 
 void SDL_VIDEO_GL_DisplayScreen(void)
 {
-	gl.BindTexture(GL_TEXTURE_2D, textures[0]);
-	if (SDL_VIDEO_GL_pbo) {
+	/* Modes with a lines function upload just the changed lines; the
+	   texture keeps the rest of the previous frame. */
+	void (*lines_func)(GLvoid *, int, int) = lines_funcs[SDL_VIDEO_current_display_mode];
+	int partial = lines_func != NULL;
+	int y = 0;
+	int height;
+	double start = SDL_VIDEO_StatsTime();
+	double upload_end;
+	if (SDL_VIDEO_NextDirtyLines(partial, &y, &height)) {
+		static int run_y[XEP80_MAX_SCRN_HEIGHT];
+		static int run_height[XEP80_MAX_SCRN_HEIGHT];
+		/* size of a texture line, with the default GL_UNPACK_ALIGNMENT of 4 */
+		int pitch = bpp_32 ? VIDEOMODE_actual_width * 4 : (VIDEOMODE_actual_width + 1) / 2 * 4;
+		int n = 0;
+		int lines = 0;
+		int i;
 		GLvoid *ptr;
-		gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, screen_pbo);
-		ptr = gl.MapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
-		(*blit_funcs[SDL_VIDEO_current_display_mode])(ptr);
-		gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB);
-		gl.TexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, VIDEOMODE_actual_width, VIDEOMODE_src_height,
-		                 pixel_formats[SDL_VIDEO_GL_pixel_format].format, pixel_formats[SDL_VIDEO_GL_pixel_format].type,
-		                 NULL);
-		gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
-	} else {
-		(*blit_funcs[SDL_VIDEO_current_display_mode])(screen_texture);
-		gl.TexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, VIDEOMODE_actual_width, VIDEOMODE_src_height,
-		                 pixel_formats[SDL_VIDEO_GL_pixel_format].format, pixel_formats[SDL_VIDEO_GL_pixel_format].type,
-		                 screen_texture);
+		gl.BindTexture(GL_TEXTURE_2D, textures[0]);
+		if (SDL_VIDEO_GL_pbo) {
+			/* The PBO holds only the lines written in this frame,
+			   and only those are uploaded from it. */
+			ptr = MapPbo();
+			if (ptr == NULL) {
+				UnbindPbo();
+				return;
+			}
+		}
+		else
+			ptr = screen_texture;
+		do {
+			if (partial)
+				(*lines_func)(ptr, y, height);
+			else
+				(*blit_funcs[SDL_VIDEO_current_display_mode])(ptr);
+			run_y[n] = y;
+			run_height[n] = height;
+			n++;
+			lines += height;
+			y += height;
+		} while (SDL_VIDEO_NextDirtyLines(partial, &y, &height));
+		if (SDL_VIDEO_GL_pbo) {
+			gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB);
+			/* offsets within the PBO */
+			ptr = NULL;
+		}
+		for (i = 0; i < n; i++)
+			gl.TexSubImage2D(GL_TEXTURE_2D, 0, 0, run_y[i], VIDEOMODE_actual_width, run_height[i],
+			                 pixel_formats[SDL_VIDEO_GL_pixel_format].format, pixel_formats[SDL_VIDEO_GL_pixel_format].type,
+			                 (Uint8 *)ptr + run_y[i] * pitch);
+		if (SDL_VIDEO_GL_pbo)
+			UnbindPbo();
+		SDL_VIDEO_DisplayDone(lines, lines * pitch);
+	}
+	else {
+		SDL_VIDEO_DisplayDone(0, 0);
+		/* Nothing changed since the previous frame. With vsync the buffer
+		   swap still paces the emulation. */
+		if (!SDL_VIDEO_vsync)
+			return;
 	}
 	gl.CallList(screen_dlist);
+	upload_end = SDL_VIDEO_StatsTime();
 	SDL_GL_SwapBuffers();
+	SDL_VIDEO_PacingDone(upload_end - start, SDL_VIDEO_StatsTime() - upload_end, pbo_orphaned);
+	pbo_orphaned = 0;
 }
 
 int SDL_VIDEO_GL_ReadConfig(char *option, char *parameters)
@@ -72,6 +72,21 @@ static void (*blit_funcs[VIDEOMODE_MODE_SIZE])(void) = {
 	&DisplayAF80
 };
 
+static void DisplayLinesWithoutScaling(int y, int height);
+static void DisplayXEP80Lines(int y, int height);
+static void DisplayProto80Lines(int y, int height);
+static void DisplayAF80Lines(int y, int height);
+
+/* Functions that display only the given lines of the screen, for the modes
+   that can redraw just the changed lines. NULL for the other modes. */
+static void (*lines_funcs[VIDEOMODE_MODE_SIZE])(int, int) = {
+	&DisplayLinesWithoutScaling,
+	NULL,
+	&DisplayXEP80Lines,
+	&DisplayProto80Lines,
+	&DisplayAF80Lines
+};
+
 static void Set8BitPalette(VIDEOMODE_MODE_t mode)
 {
 	int *pal = SDL_PALETTE_tab[mode].palette;
@@ -209,6 +224,7 @@ void SDL_VIDEO_SW_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed,
 	SDL_ShowCursor(SDL_DISABLE);	/* hide mouse cursor */
 
 	if (mode == VIDEOMODE_MODE_NORMAL) {
+		lines_funcs[0] = NULL;
 		if (rotate90)
 			blit_funcs[0] = &DisplayRotated;
 #ifdef PAL_BLENDING
@@ -219,8 +235,10 @@ void SDL_VIDEO_SW_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed,
 				blit_funcs[0] = &DisplayPalBlendingScaled;
 		}
 #endif /* PAL_BLENDING */
-		else if (VIDEOMODE_src_width == VIDEOMODE_dest_width && VIDEOMODE_src_height == VIDEOMODE_dest_height)
+		else if (VIDEOMODE_src_width == VIDEOMODE_dest_width && VIDEOMODE_src_height == VIDEOMODE_dest_height) {
 			blit_funcs[0] = &DisplayWithoutScaling;
+			lines_funcs[0] = &DisplayLinesWithoutScaling;
+		}
 		else
 			blit_funcs[0] = &DisplayWithScaling;
 	}
@@ -441,37 +459,59 @@ static void scanLines_32(void* pBuffer, int width, int height, int pitch, int sc
 	}
 }
 
-static void DisplayXEP80(void)
+/* The 80-column modes draw each line of the source as two lines of the
+   SDL screen, the second one being a scanline. Returns the first SDL screen
+   line that shows line Y of the source. */
+static Uint8 *Pixels80(int y)
 {
-	static int xep80Frame = 0;
-	int pitch4 = SDL_VIDEO_screen->pitch / 2;
-	UBYTE *screen;
-	Uint8 *pixels = (Uint8 *) SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
-	xep80Frame++;
-	if (xep80Frame == 60) xep80Frame = 0;
-	if (xep80Frame > 29) {
-		screen = XEP80_screen_1;
+	Uint8 *pixels = (Uint8 *) SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * (VIDEOMODE_dest_offset_top + 2 * y);
+	return pixels + VIDEOMODE_dest_offset_left * SDL_VIDEO_screen->format->BytesPerPixel;
+}
+
+/* Updates the scanlines after redrawing HEIGHT lines starting at line Y
+   of an 80-column screen. With interpolation a scanline depends on the lines
+   above and below it, so one more line is taken at each side. */
+static void Scanlines80(int y, int height)
+{
+	if (y > 0) {
+		y--;
+		height++;
 	}
-	else {
-		screen = XEP80_screen_2;
+	if (y + height < (int) VIDEOMODE_src_height)
+		height++;
+	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
+	case 16:
+		scanLines_16((void *)Pixels80(y), VIDEOMODE_dest_width, height * 2, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		break;
+	case 32:
+		scanLines_32((void *)Pixels80(y), VIDEOMODE_dest_width, height * 2, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		break;
 	}
+}
+
+static void DisplayXEP80Lines(int y, int height)
+{
+	int pitch4 = SDL_VIDEO_screen->pitch / 2;
+	UBYTE *screen = SDL_VIDEO_blink ? XEP80_screen_2 : XEP80_screen_1;
+	Uint8 *pixels = Pixels80(y);
 
-	screen += XEP80_SCRN_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	screen += XEP80_SCRN_WIDTH * (VIDEOMODE_src_offset_top + y) + VIDEOMODE_src_offset_left;
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
 	case 8:
-		pixels += VIDEOMODE_dest_offset_left;
-		SDL_VIDEO_BlitXEP80_8((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, VIDEOMODE_src_height);
+		SDL_VIDEO_BlitXEP80_8((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, height);
 		break;
 	case 16:
-		pixels += VIDEOMODE_dest_offset_left * 2;
-		SDL_VIDEO_BlitXEP80_16((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp16);
-		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		SDL_VIDEO_BlitXEP80_16((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, height, SDL_PALETTE_buffer.bpp16);
 		break;
 	default:
-		pixels += VIDEOMODE_dest_offset_left * 4;
-		SDL_VIDEO_BlitXEP80_32((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp32);
-		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		SDL_VIDEO_BlitXEP80_32((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, height, SDL_PALETTE_buffer.bpp32);
 	}
+	Scanlines80(y, height);
+}
+
+static void DisplayXEP80(void)
+{
+	DisplayXEP80Lines(0, VIDEOMODE_src_height);
 }
 
 static void DisplayNTSCEmu(void)
@@ -504,63 +544,58 @@ static void DisplayNTSCEmu(void)
 	}
 }
 
-static void DisplayProto80(void)
+static void DisplayProto80Lines(int y, int height)
 {
 	int first_column = (VIDEOMODE_src_offset_left+7) / 8;
 	int last_column = (VIDEOMODE_src_offset_left + VIDEOMODE_src_width) / 8;
-	int first_line = VIDEOMODE_src_offset_top;
-	int last_line = first_line + VIDEOMODE_src_height;
+	int first_line = VIDEOMODE_src_offset_top + y;
+	int last_line = first_line + height;
 	int pitch4 = SDL_VIDEO_screen->pitch / 2;
-	Uint8 *pixels = (Uint8*)SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	Uint8 *pixels = Pixels80(y);
 
-	
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
 	case 8:
-		pixels += VIDEOMODE_dest_offset_left;
 		SDL_VIDEO_BlitProto80_8((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line);
 		break;
 	case 16:
-		pixels += VIDEOMODE_dest_offset_left * 2;
 		SDL_VIDEO_BlitProto80_16((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, SDL_PALETTE_buffer.bpp16);
-		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
 		break;
 	default:
-		pixels += VIDEOMODE_dest_offset_left * 4;
 		SDL_VIDEO_BlitProto80_32((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, SDL_PALETTE_buffer.bpp32);
-		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
 	}
+	Scanlines80(y, height);
 }
 
-static void DisplayAF80(void)
+static void DisplayProto80(void)
+{
+	DisplayProto80Lines(0, VIDEOMODE_src_height);
+}
+
+static void DisplayAF80Lines(int y, int height)
 {
 	int first_column = (VIDEOMODE_src_offset_left+7) / 8;
 	int last_column = (VIDEOMODE_src_offset_left + VIDEOMODE_src_width) / 8;
-	int first_line = VIDEOMODE_src_offset_top;
-	int last_line = first_line + VIDEOMODE_src_height;
+	int first_line = VIDEOMODE_src_offset_top + y;
+	int last_line = first_line + height;
 	int pitch4 = SDL_VIDEO_screen->pitch / 2;
-	Uint8 *pixels = (Uint8*)SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	Uint8 *pixels = Pixels80(y);
 
-	static int AF80Frame = 0;
-	int blink;
-	AF80Frame++;
-	if (AF80Frame == 60) AF80Frame = 0;
-	blink = AF80Frame >= 30;
-	
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
 	case 8:
-		pixels += VIDEOMODE_dest_offset_left;
-		SDL_VIDEO_BlitAF80_8((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, blink);
+		SDL_VIDEO_BlitAF80_8((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, SDL_VIDEO_blink);
 		break;
 	case 16:
-		pixels += VIDEOMODE_dest_offset_left * 2;
-		SDL_VIDEO_BlitAF80_16((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, blink, SDL_PALETTE_buffer.bpp16);
-		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		SDL_VIDEO_BlitAF80_16((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, SDL_VIDEO_blink, SDL_PALETTE_buffer.bpp16);
 		break;
 	default:
-		pixels += VIDEOMODE_dest_offset_left * 4;
-		SDL_VIDEO_BlitAF80_32((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, blink, SDL_PALETTE_buffer.bpp32);
-		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		SDL_VIDEO_BlitAF80_32((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, SDL_VIDEO_blink, SDL_PALETTE_buffer.bpp32);
 	}
+	Scanlines80(y, height);
+}
+
+static void DisplayAF80(void)
+{
+	DisplayAF80Lines(0, VIDEOMODE_src_height);
 }
 
 static void DisplayRotated(void)
@@ -583,28 +618,34 @@ static void DisplayRotated(void)
 	}
 }
 
-static void DisplayWithoutScaling(void)
+/* Displays HEIGHT lines starting at line Y of the displayed area. */
+static void DisplayLinesWithoutScaling(int y, int height)
 {
 	int pitch4 = SDL_VIDEO_screen->pitch / 4;
-	UBYTE *screen = (UBYTE *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
-	Uint8 *pixels = (Uint8 *) SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	UBYTE *screen = (UBYTE *)Screen_atari + Screen_WIDTH * (VIDEOMODE_src_offset_top + y) + VIDEOMODE_src_offset_left;
+	Uint8 *pixels = (Uint8 *) SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * (VIDEOMODE_dest_offset_top + y);
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
 	/* Possible values are 8, 16 and 32, as checked earlier in the
 	 * PLATFORM_SetVideoMode() function. */
 	case 8:
 		pixels += VIDEOMODE_dest_offset_left;
-		SDL_VIDEO_BlitNormal8((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, VIDEOMODE_src_height);
+		SDL_VIDEO_BlitNormal8((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, height);
 		break;
 	case 16:
 		pixels += VIDEOMODE_dest_offset_left * 2;
-		SDL_VIDEO_BlitNormal16((Uint32*)pixels, screen, pitch4, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp16);
+		SDL_VIDEO_BlitNormal16((Uint32*)pixels, screen, pitch4, VIDEOMODE_src_width, height, SDL_PALETTE_buffer.bpp16);
 		break;
 	default: /* SDL_VIDEO_screen->format->BitsPerPixel == 32 */
 		pixels += VIDEOMODE_dest_offset_left * 4;
-		SDL_VIDEO_BlitNormal32((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp32);
+		SDL_VIDEO_BlitNormal32((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, height, SDL_PALETTE_buffer.bpp32);
 	}
 }
 
+static void DisplayWithoutScaling(void)
+{
+	DisplayLinesWithoutScaling(0, VIDEOMODE_src_height);
+}
+
 static void DisplayWithScaling(void)
 {
 	register Uint32 quad;
@@ -740,7 +781,19 @@ static void DisplayPalBlendingScaled(void)
 
 void SDL_VIDEO_SW_DisplayScreen(void)
 {
-	if (SDL_LockSurface(SDL_VIDEO_screen) != 0)
+	/* Only the unscaled normal mode and the 80-column modes can redraw just
+	   the changed lines. With double buffering, the back buffer holds an
+	   older frame. */
+	void (*lines_func)(int, int) = lines_funcs[SDL_VIDEO_current_display_mode];
+	int partial = lines_func != NULL && !(SDL_VIDEO_screen->flags & SDL_DOUBLEBUF);
+	int y = 0;
+	int height;
+	if (!SDL_VIDEO_NextDirtyLines(partial, &y, &height)) {
+		/* Nothing changed since the previous frame. */
+		SDL_VIDEO_DisplayDone(0, 0);
+		return;
+	}
+	if (SDL_LockSurface(SDL_VIDEO_screen) != 0) {
 		/* When the window manager decides to switch the SDL display from
 		   fullscreen to windowed mode (eg. by minimising the window after the
 		   user pressed Alt+Tab in Windows), hardware surface gets disabled
@@ -748,7 +801,39 @@ void SDL_VIDEO_SW_DisplayScreen(void)
 		   don't blit to screen as it would cause a segfault. When fullscreen
 		   mode gets re-enabled, surface locking will work again and screen
 		   displaying will be restored */
-		   return;
+		SDL_VIDEO_full_redraw = TRUE;
+		return;
+	}
+	if (partial) {
+		static SDL_Rect rects[XEP80_MAX_SCRN_HEIGHT];
+		/* 2 in the 80-column modes */
+		int mult = VIDEOMODE_dest_height / VIDEOMODE_src_height;
+		int n = 0;
+		int lines = 0;
+		do {
+			int top = y;
+			int bottom = y + height;
+			(*lines_func)(y, height);
+			if (mult > 1) {
+				/* the scanlines next to the run were updated too */
+				if (top > 0)
+					top--;
+				if (bottom < (int) VIDEOMODE_src_height)
+					bottom++;
+			}
+			rects[n].x = VIDEOMODE_dest_offset_left;
+			rects[n].y = VIDEOMODE_dest_offset_top + top * mult;
+			rects[n].w = VIDEOMODE_dest_width;
+			rects[n].h = (bottom - top) * mult;
+			n++;
+			lines += height;
+			y += height;
+		} while (SDL_VIDEO_NextDirtyLines(partial, &y, &height));
+		SDL_UnlockSurface(SDL_VIDEO_screen);
+		SDL_UpdateRects(SDL_VIDEO_screen, n, rects);
+		SDL_VIDEO_DisplayDone(lines, lines * mult * VIDEOMODE_dest_width * SDL_VIDEO_screen->format->BytesPerPixel);
+		return;
+	}
 	/* Use function corresponding to the current_display_mode. */
 	(*blit_funcs[SDL_VIDEO_current_display_mode])();
 	SDL_UnlockSurface(SDL_VIDEO_screen);
@@ -758,6 +843,7 @@ void SDL_VIDEO_SW_DisplayScreen(void)
 		SDL_Flip(SDL_VIDEO_screen);
 	else
 		SDL_UpdateRect(SDL_VIDEO_screen, VIDEOMODE_dest_offset_left, VIDEOMODE_dest_offset_top, VIDEOMODE_dest_width, VIDEOMODE_dest_height);
+	SDL_VIDEO_DisplayDone(VIDEOMODE_dest_height, VIDEOMODE_dest_height * VIDEOMODE_dest_width * SDL_VIDEO_screen->format->BytesPerPixel);
 }
 
 int SDL_VIDEO_SW_ReadConfig(char *option, char *parameters)
@@ -0,0 +1,229 @@
+/*
+ * shmexport.c - screen, sound and input through POSIX shared memory
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#define _POSIX_C_SOURCE 200112L /* for shm_open */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "akey.h"
+#include "atari.h"
+#include "atari800_shm.h"
+#include "colours.h"
+#include "input.h"
+#include "log.h"
+#include "screen.h"
+#include "shmexport.h"
+#include "util.h"
+#ifdef SOUND
+#include "pokeysnd.h"
+#endif
+
+/* The exported area is the same as in screenshots. */
+#define FRAME_WIDTH 336
+#define FRAME_LEFT ((Screen_WIDTH - FRAME_WIDTH) / 2)
+#define FRAME_SLOTS 8
+#define FRAME_SLOT_SIZE ((sizeof(A8SHM_Frame) + FRAME_WIDTH * Screen_HEIGHT + 63) & ~63)
+#define AUDIO_SIZE 0x40000
+#define HEADER_SIZE ((sizeof(A8SHM_Header) + 63) & ~63)
+#define SHM_SIZE (HEADER_SIZE + FRAME_SLOTS * FRAME_SLOT_SIZE + AUDIO_SIZE)
+
+/* Orders the stores seen by the other process. */
+#ifdef __GNUC__
+#define BARRIER() __sync_synchronize()
+#else
+#define BARRIER()
+#endif
+
+static char shm_name[FILENAME_MAX] = "";
+static volatile A8SHM_Header *header = NULL;
+static UBYTE *shm_base;
+
+static void Close(void)
+{
+	if (header == NULL)
+		return;
+	munmap(shm_base, SHM_SIZE);
+	shm_unlink(shm_name);
+	header = NULL;
+}
+
+static int Open(void)
+{
+	int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (fd < 0)
+		return FALSE;
+	if (ftruncate(fd, SHM_SIZE) != 0) {
+		close(fd);
+		shm_unlink(shm_name);
+		return FALSE;
+	}
+	shm_base = (UBYTE *) mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm_base == (UBYTE *) MAP_FAILED) {
+		shm_unlink(shm_name);
+		return FALSE;
+	}
+	memset(shm_base, 0, SHM_SIZE);
+	header = (volatile A8SHM_Header *) shm_base;
+	header->version = A8SHM_VERSION;
+	header->emulator_pid = (unsigned int) getpid();
+	header->width = FRAME_WIDTH;
+	header->height = Screen_HEIGHT;
+	header->frame_slots = FRAME_SLOTS;
+	header->frame_slot_size = FRAME_SLOT_SIZE;
+	header->frame_offset = HEADER_SIZE;
+	header->audio_offset = HEADER_SIZE + FRAME_SLOTS * FRAME_SLOT_SIZE;
+	header->audio_size = AUDIO_SIZE;
+	header->input.key_code = AKEY_NONE;
+	header->input.key_consol = INPUT_CONSOL_NONE;
+	header->input.port[0] = header->input.port[1] = 0xff;
+	header->input.trig[0] = header->input.trig[1] = header->input.trig[2] = header->input.trig[3] = 1;
+	BARRIER();
+	/* the header is valid now */
+	header->magic = A8SHM_MAGIC;
+	return TRUE;
+}
+
+void SHMExport_Frame(void)
+{
+	unsigned int n;
+	volatile A8SHM_Frame *frame;
+	const UBYTE *src;
+	UBYTE *dst;
+	int i;
+	if (header == NULL)
+		return;
+	n = header->frame_count;
+	frame = (volatile A8SHM_Frame *) (shm_base + HEADER_SIZE + n % FRAME_SLOTS * FRAME_SLOT_SIZE);
+	frame->seq++; /* odd: being written */
+	BARRIER();
+	frame->frame_number = Atari800_nframes;
+	for (i = 0; i < 256; i++) {
+		frame->palette[i * 3] = Colours_GetR(i);
+		frame->palette[i * 3 + 1] = Colours_GetG(i);
+		frame->palette[i * 3 + 2] = Colours_GetB(i);
+	}
+	src = (const UBYTE *) Screen_atari + FRAME_LEFT;
+	dst = (UBYTE *) frame + sizeof(A8SHM_Frame);
+	for (i = 0; i < Screen_HEIGHT; i++) {
+		memcpy(dst, src, FRAME_WIDTH);
+		src += Screen_WIDTH;
+		dst += FRAME_WIDTH;
+	}
+	header->fps_x1000 = (unsigned int) ((Atari800_tv_mode == Atari800_TV_PAL ? Atari800_FPS_PAL : Atari800_FPS_NTSC) * 1000);
+	BARRIER();
+	frame->seq++; /* even: complete */
+	BARRIER();
+	header->frame_count = n + 1;
+}
+
+void SHMExport_Sound(const UBYTE *buffer, unsigned int size)
+{
+	unsigned int pos;
+	UBYTE *ring;
+	if (header == NULL || buffer == NULL)
+		return;
+#ifdef SOUND
+	header->audio_freq = POKEYSND_playback_freq;
+	header->audio_channels = POKEYSND_num_pokeys;
+	header->audio_bits = POKEYSND_snd_flags & POKEYSND_BIT16 ? 16 : 8;
+	if (POKEYSND_snd_flags & POKEYSND_BIT16)
+		size <<= 1;
+#endif
+	/* only the newest AUDIO_SIZE bytes can be kept */
+	if (size > AUDIO_SIZE) {
+		header->audio_written += size - AUDIO_SIZE;
+		buffer += size - AUDIO_SIZE;
+		size = AUDIO_SIZE;
+	}
+	ring = shm_base + header->audio_offset;
+	pos = header->audio_written % AUDIO_SIZE;
+	if (pos + size > AUDIO_SIZE) {
+		memcpy(ring + pos, buffer, AUDIO_SIZE - pos);
+		memcpy(ring, buffer + AUDIO_SIZE - pos, size - (AUDIO_SIZE - pos));
+	}
+	else
+		memcpy(ring + pos, buffer, size);
+	BARRIER();
+	header->audio_written += size;
+}
+
+int SHMExport_ReadInput(int port[2], int trig[4])
+{
+	int i;
+	if (header == NULL || !header->input.input_enabled)
+		return FALSE;
+	BARRIER();
+	INPUT_key_code = header->input.key_code;
+	INPUT_key_shift = header->input.key_shift;
+	INPUT_key_consol = header->input.key_consol;
+	port[0] = header->input.port[0];
+	port[1] = header->input.port[1];
+	for (i = 0; i < 4; i++)
+		trig[i] = header->input.trig[i];
+	return TRUE;
+}
+
+int SHMExport_Initialise(int *argc, char *argv[])
+{
+	int i;
+	int j;
+	for (i = j = 1; i < *argc; i++) {
+		int i_a = (i + 1 < *argc);		/* is argument available? */
+		int a_m = FALSE;			/* error, argument missing! */
+
+		if (strcmp(argv[i], "-shm") == 0) {
+			if (i_a)
+				Util_strlcpy(shm_name, argv[++i], sizeof(shm_name));
+			else a_m = TRUE;
+		}
+		else {
+			if (strcmp(argv[i], "-help") == 0)
+				Log_print("\t-shm <name>      Export screen and sound, import input through shared memory");
+			argv[j++] = argv[i];
+		}
+
+		if (a_m) {
+			Log_print("Missing argument for '%s'", argv[i]);
+			return FALSE;
+		}
+	}
+	*argc = j;
+
+	if (shm_name[0] != '\0' && !Open()) {
+		Log_print("Cannot create shared memory object %s", shm_name);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void SHMExport_Exit(void)
+{
+	Close();
+}
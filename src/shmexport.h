@@ -0,0 +1,23 @@
+#ifndef SHMEXPORT_H_
+#define SHMEXPORT_H_
+
+#include "atari.h"
+
+/* Publishes the emulated screen and sound in a POSIX shared memory object
+   and takes input from it. The layout is described in atari800_shm.h. */
+
+int SHMExport_Initialise(int *argc, char *argv[]);
+void SHMExport_Exit(void);
+
+/* Adds Screen_atari as the next frame. Called once for each emulated frame. */
+void SHMExport_Frame(void);
+
+/* Adds sound samples, in the format written by SndSave_WriteToSoundFile(). */
+void SHMExport_Sound(const UBYTE *buffer, unsigned int size);
+
+/* If the other side has enabled input, stores it in INPUT_key_code,
+   INPUT_key_shift and INPUT_key_consol, fills PORT[2] and TRIG[4]
+   and returns TRUE. */
+int SHMExport_ReadInput(int port[2], int trig[4]);
+
+#endif /* SHMEXPORT_H_ */
@@ -38,6 +38,7 @@
 #include "compfile.h"
 #include "cpu.h"
 #include "esc.h"
+#include "img_disk.h"
 #include "log.h"
 #include "memory.h"
 #include "platform.h"
@@ -52,28 +53,8 @@
 #undef DEBUG_PRO
 #undef DEBUG_VAPI
 
-/* If ATR image is in double density (256 bytes per sector),
-   then the boot sectors (sectors 1-3) can be:
-   - logical (as seen by Atari) - 128 bytes in each sector
-   - physical (as stored on the disk) - 256 bytes in each sector.
-     Only the first half of sector is used for storing data, the rest is zero.
-   - SIO2PC (the type used by the SIO2PC program) - 3 * 128 bytes for data
-     of boot sectors, then 3 * 128 unused bytes (zero)
-   The XFD images in double density have either logical or physical
-   boot sectors. */
-#define BOOT_SECTORS_LOGICAL	0
-#define BOOT_SECTORS_PHYSICAL	1
-#define BOOT_SECTORS_SIO2PC		2
-static int boot_sectors_type[SIO_MAX_DRIVES];
-
-static int image_type[SIO_MAX_DRIVES];
-#define IMAGE_TYPE_XFD  0
-#define IMAGE_TYPE_ATR  1
-#define IMAGE_TYPE_PRO  2
-#define IMAGE_TYPE_VAPI 3
+static IMG_DISK_Info image_info[SIO_MAX_DRIVES];
 static FILE *disk[SIO_MAX_DRIVES] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
-static int sectorcount[SIO_MAX_DRIVES];
-static int sectorsize[SIO_MAX_DRIVES];
 /* these two are used by the 1450XLD parallel disk device */
 int SIO_format_sectorcount[SIO_MAX_DRIVES];
 int SIO_format_sectorsize[SIO_MAX_DRIVES];
@@ -84,9 +65,7 @@ typedef struct tagpro_additional_info_t {
 	unsigned char *count;
 } pro_additional_info_t;
 
-#define MAX_VAPI_PHANTOM_SEC  		40
-#define VAPI_BYTES_PER_TRACK        26042.0 
-#define VAPI_CYCLES_PER_ROT 		372706
+#define VAPI_CYCLES_PER_ROT 		IMG_DISK_VAPI_CYCLES_PER_ROT
 #define VAPI_CYCLES_PER_TRACK_STEP 	35780 /*70937*/
 #define VAPI_CYCLES_HEAD_SETTLE 	70134
 #define VAPI_CYCLES_TRACK_READ_DELTA 1426
@@ -95,13 +74,7 @@ typedef struct tagpro_additional_info_t {
 #define VAPI_CYCLES_MISSING_SECTOR	(2*VAPI_CYCLES_PER_ROT + 14453)
 #define VAPI_CYCLES_BAD_SECTOR_NUM	1521
 
-/* stores dup sector information for VAPI images */
-typedef struct tagvapi_sec_info_t {
-	int sec_count;
-	unsigned int sec_offset[MAX_VAPI_PHANTOM_SEC];
-	unsigned char sec_status[MAX_VAPI_PHANTOM_SEC];
-	unsigned int sec_rot_pos[MAX_VAPI_PHANTOM_SEC];
-} vapi_sec_info_t;
+typedef IMG_DISK_VAPISector vapi_sec_info_t;
 
 typedef struct tagvapi_additional_info_t {
 	vapi_sec_info_t *sectors;
@@ -109,44 +82,6 @@ typedef struct tagvapi_additional_info_t {
 	int vapi_delay_time;
 } vapi_additional_info_t;
 
-/* VAPI Format Header */
-typedef struct tagvapi_file_header_t {
-	unsigned char signature[4];
-	unsigned char majorver;
-	unsigned char minorver;
-	unsigned char reserved1[22];
-	unsigned char startdata[4];
-	unsigned char reserved[16];
-} vapi_file_header_t;
-
-typedef struct tagvapi_track_header_t {
-	unsigned char  next[4];
-	unsigned char  type[2];
-	unsigned char  reserved1[2];
-	unsigned char  tracknum;
-	unsigned char  reserved2;
-	unsigned char  sectorcnt[2];
-	unsigned char  reserved3[8];
-	unsigned char  startdata[4];
-	unsigned char  reserved4[8];
-} vapi_track_header_t;
-
-typedef struct tagvapi_sector_list_header_t {
-	unsigned char  sizelist[4];
-	unsigned char  type;
-	unsigned char  reserved[3];
-} vapi_sector_list_header_t;
-
-typedef struct tagvapi_sector_header_t {
-	unsigned char  sectornum;
-	unsigned char  sectorstatus;
-	unsigned char  sectorpos[2];
-	unsigned char  startdata[4];
-} vapi_sector_header_t;
-
-#define VAPI_32(x) (x[0] + (x[1] << 8) + (x[2] << 16) + (x[3] << 24))
-#define VAPI_16(x) (x[0] + (x[1] << 8))
-
 /* Additional Info for all copy protected disk types */
 static void *additional_info[SIO_MAX_DRIVES];
 
@@ -206,6 +141,7 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 	FILE *f = NULL;
 	SIO_UnitStatus status = SIO_READ_WRITE;
 	struct AFILE_ATR_Header header;
+	IMG_DISK_Info *info = &image_info[diskno - 1];
 
 	/* avoid overruns in SIO_filename[] */
 	if (strlen(filename) >= FILENAME_MAX)
@@ -230,24 +166,20 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 		return FALSE;
 	}
 
-	/* detect compressed image and uncompress */
-	switch (header.magic1) {
-	case 0xf9:
-	case 0xfa:
-		/* DCM */
-		{
-			FILE *f2 = Util_tmpopen(sio_tmpbuf[diskno - 1]);
-			if (f2 == NULL)
-				return FALSE;
-			Util_rewind(f);
-			if (!CompFile_DCMtoATR(f, f2)) {
-				Util_fclose(f2, sio_tmpbuf[diskno - 1]);
-				fclose(f);
-				return FALSE;
-			}
+	/* detect compressed image (DCM, ATZ/ATR.GZ, XFZ/XFD.GZ) and uncompress */
+	if (IMG_DISK_IsCompressed(&header)) {
+		FILE *f2 = Util_tmpopen(sio_tmpbuf[diskno - 1]);
+		if (f2 == NULL) {
 			fclose(f);
-			f = f2;
+			return FALSE;
 		}
+		if (!IMG_DISK_Uncompress(f, filename, f2)) {
+			Util_fclose(f2, sio_tmpbuf[diskno - 1]);
+			fclose(f);
+			return FALSE;
+		}
+		fclose(f);
+		f = f2;
 		Util_rewind(f);
 		if (fread(&header, 1, sizeof(struct AFILE_ATR_Header), f) != sizeof(struct AFILE_ATR_Header)) {
 			Util_fclose(f, sio_tmpbuf[diskno - 1]);
@@ -255,297 +187,55 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 		}
 		status = SIO_READ_ONLY;
 		/* XXX: status = b_open_readonly ? SIO_READ_ONLY : SIO_READ_WRITE; */
-		break;
-	case 0x1f:
-		if (header.magic2 == 0x8b) {
-			/* ATZ/ATR.GZ, XFZ/XFD.GZ */
-			fclose(f);
-			f = Util_tmpopen(sio_tmpbuf[diskno - 1]);
-			if (f == NULL)
-				return FALSE;
-			if (!CompFile_ExtractGZ(filename, f)) {
-				Util_fclose(f, sio_tmpbuf[diskno - 1]);
-				return FALSE;
-			}
-			Util_rewind(f);
-			if (fread(&header, 1, sizeof(struct AFILE_ATR_Header), f) != sizeof(struct AFILE_ATR_Header)) {
-				Util_fclose(f, sio_tmpbuf[diskno - 1]);
-				return FALSE;
-			}
-			status = SIO_READ_ONLY;
-			/* XXX: status = b_open_readonly ? SIO_READ_ONLY : SIO_READ_WRITE; */
-		}
-		break;
-	default:
-		break;
 	}
 
-	boot_sectors_type[diskno - 1] = BOOT_SECTORS_LOGICAL;
-
-	if (header.magic1 == AFILE_ATR_MAGIC1 && header.magic2 == AFILE_ATR_MAGIC2) {
-		/* ATR (may be temporary from DCM or ATR/ATR.GZ) */
-		image_type[diskno - 1] = IMAGE_TYPE_ATR;
-
-		sectorsize[diskno - 1] = (header.secsizehi << 8) + header.secsizelo;
-		if (sectorsize[diskno - 1] != 128 && sectorsize[diskno - 1] != 256) {
-			Util_fclose(f, sio_tmpbuf[diskno - 1]);
-			return FALSE;
-		}
-
-		if (header.writeprotect != 0 && !ignore_header_writeprotect)
-			status = SIO_READ_ONLY;
-
-		/* ATR header contains length in 16-byte chunks. */
-		/* First compute number of 128-byte chunks
-		   - it's number of sectors on single density disk */
-		sectorcount[diskno - 1] = ((header.hiseccounthi << 24)
-			+ (header.hiseccountlo << 16)
-			+ (header.seccounthi << 8)
-			+ header.seccountlo) >> 3;
-
-		/* Fix number of sectors if double density */
-		if (sectorsize[diskno - 1] == 256) {
-			if ((sectorcount[diskno - 1] & 1) != 0)
-				/* logical (128-byte) boot sectors */
-				sectorcount[diskno - 1] += 3;
-			else {
-				/* 256-byte boot sectors */
-				/* check if physical or SIO2PC: physical if there's
-				   a non-zero byte in bytes 0x190-0x30f of the ATR file */
-				UBYTE buffer[0x180];
-				int i;
-				fseek(f, 0x190, SEEK_SET);
-				if (fread(buffer, 1, 0x180, f) != 0x180) {
-					Util_fclose(f, sio_tmpbuf[diskno - 1]);
-					return FALSE;
-				}
-				boot_sectors_type[diskno - 1] = BOOT_SECTORS_SIO2PC;
-				for (i = 0; i < 0x180; i++)
-					if (buffer[i] != 0) {
-						boot_sectors_type[diskno - 1] = BOOT_SECTORS_PHYSICAL;
-						break;
-					}
-			}
-			sectorcount[diskno - 1] >>= 1;
-		}
+	if (!IMG_DISK_ParseHeader(f, &header, info)) {
+		Util_fclose(f, sio_tmpbuf[diskno - 1]);
+		return FALSE;
 	}
-	else if (header.magic1 == 'A' && header.magic2 == 'T' && header.seccountlo == '8' &&
-		 header.seccounthi == 'X') {
-		int file_length = Util_flen(f);
-		vapi_additional_info_t *info;
-		vapi_file_header_t fileheader;
-		vapi_track_header_t trackheader;
-		int trackoffset, totalsectors;
 
-		/* .atx is read only for now */
+	if (info->writeprotect && !ignore_header_writeprotect)
+		status = SIO_READ_ONLY;
+
+	if (info->type == IMG_DISK_TYPE_PRO
 #ifndef VAPI_WRITE_ENABLE
-		if (!b_open_readonly) {
+	    || info->type == IMG_DISK_TYPE_VAPI
+#endif
+	   ) {
+		/* .pro and .atx are read only for now */
+		if (status != SIO_READ_ONLY) {
 			fclose(f);
 			f = Util_fopen(filename, "rb", sio_tmpbuf[diskno - 1]);
-			if (f == NULL)
+			if (f == NULL) {
+				IMG_DISK_FreeInfo(info);
 				return FALSE;
-			status = SIO_READ_ONLY;
-		}
-#endif
-		
-		image_type[diskno - 1] = IMAGE_TYPE_VAPI;
-		sectorsize[diskno - 1] = 128;
-		sectorcount[diskno - 1] = 720;
-		fseek(f,0,SEEK_SET);
-		if (fread(&fileheader,1,sizeof(fileheader),f) != sizeof(fileheader)) {
-			Util_fclose(f, sio_tmpbuf[diskno - 1]);
-			Log_print("VAPI: Bad File Header");
-			return(FALSE);
 			}
-		trackoffset = VAPI_32(fileheader.startdata);	
-		if (trackoffset > file_length) {
-			Util_fclose(f, sio_tmpbuf[diskno - 1]);
-			Log_print("VAPI: Bad Track Offset");
-			return(FALSE);
-			}
-#ifdef DEBUG_VAPI
-		Log_print("VAPI File Version %d.%d",fileheader.majorver,fileheader.minorver);
-#endif
-		/* Read all of the track headers to get the total sector count */
-		totalsectors = 0;
-		while (trackoffset > 0 && trackoffset < file_length) {
-			ULONG next;
-			UWORD tracktype;
-
-			fseek(f,trackoffset,SEEK_SET);
-			if (fread(&trackheader,1,sizeof(trackheader),f) != sizeof(trackheader)) {
-				Util_fclose(f, sio_tmpbuf[diskno - 1]);
-				Log_print("VAPI: Bad Track Header");
-				return(FALSE);
-				}
-			next = VAPI_32(trackheader.next);
-			tracktype = VAPI_16(trackheader.type);
-			if (tracktype == 0) {
-				totalsectors += VAPI_16(trackheader.sectorcnt);
-				}
-			trackoffset += next;
+			status = SIO_READ_ONLY;
 		}
-
-		info = Util_malloc(sizeof(vapi_additional_info_t));
-		additional_info[diskno-1] = info;
-		info->sectors = Util_malloc(sectorcount[diskno - 1] * 
- 					    sizeof(vapi_sec_info_t));
-		memset(info->sectors, 0, sectorcount[diskno - 1] * 
- 					 sizeof(vapi_sec_info_t));
-
-		/* Now read all the sector data */
-		trackoffset = VAPI_32(fileheader.startdata);
-		while (trackoffset > 0 && trackoffset < file_length) {
-			int sectorcnt, seclistdata,next;
-			vapi_sector_list_header_t sectorlist;
-			vapi_sector_header_t sectorheader;
-			vapi_sec_info_t *sector;
-			UWORD tracktype;
-			int j;
-
-			fseek(f,trackoffset,SEEK_SET);
-			if (fread(&trackheader,1,sizeof(trackheader),f) != sizeof(trackheader)) {
-				free(info->sectors);
-				free(info);
-				Util_fclose(f, sio_tmpbuf[diskno - 1]);
-				Log_print("VAPI: Bad Track Header while reading sectors");
-				return(FALSE);
-				}
-			next = VAPI_32(trackheader.next);
-			sectorcnt = VAPI_16(trackheader.sectorcnt);
-			tracktype = VAPI_16(trackheader.type);
-			seclistdata = VAPI_32(trackheader.startdata) + trackoffset;
-#ifdef DEBUG_VAPI
-			Log_print("Track %d: next %x type %d seccnt %d secdata %x",trackheader.tracknum,
-				trackoffset + next,VAPI_16(trackheader.type),sectorcnt,seclistdata);
-#endif
-			if (tracktype == 0) {
-				if (seclistdata > file_length) {
-					free(info->sectors);
-					free(info);
-					Util_fclose(f, sio_tmpbuf[diskno - 1]);
-					Log_print("VAPI: Bad Sector List Offset");
-					return(FALSE);
-					}
-				fseek(f,seclistdata,SEEK_SET);
-				if (fread(&sectorlist,1,sizeof(sectorlist),f) != sizeof(sectorlist)) {
-					free(info->sectors);
-					free(info);
-					Util_fclose(f, sio_tmpbuf[diskno - 1]);
-					Log_print("VAPI: Bad Sector List");
-					return(FALSE);
-					}
-#ifdef DEBUG_VAPI
-				Log_print("Size sec list %x type %d",VAPI_32(sectorlist.sizelist),sectorlist.type);
-#endif
-				for (j=0;j<sectorcnt;j++) {
-					double percent_rot;
-
-					if (fread(&sectorheader,1,sizeof(sectorheader),f) != sizeof(sectorheader)) {
-						free(info->sectors);
-						free(info);
-						Util_fclose(f, sio_tmpbuf[diskno - 1]);
-						Log_print("VAPI: Bad Sector Header");
-						return(FALSE);
-						}
-					if (sectorheader.sectornum > 18)  {
-						Util_fclose(f, sio_tmpbuf[diskno - 1]);
-						Log_print("VAPI: Bad Sector Index: Track %d Sec Num %d Index %d",
-								trackheader.tracknum,j,sectorheader.sectornum);
-						return(FALSE);
-						}
-					sector = &info->sectors[trackheader.tracknum * 18 + sectorheader.sectornum - 1];
-
-					percent_rot = ((double) VAPI_16(sectorheader.sectorpos))/VAPI_BYTES_PER_TRACK;
-					sector->sec_rot_pos[sector->sec_count] = (unsigned int) (percent_rot * VAPI_CYCLES_PER_ROT);
-					sector->sec_offset[sector->sec_count] = VAPI_32(sectorheader.startdata) + trackoffset;
-					sector->sec_status[sector->sec_count] = ~sectorheader.sectorstatus;
-					sector->sec_count++;
-					if (sector->sec_count > MAX_VAPI_PHANTOM_SEC) {
-						free(info->sectors);
-						free(info);
-						Util_fclose(f, sio_tmpbuf[diskno - 1]);
-						Log_print("VAPI: Too many Phantom Sectors");
-						return(FALSE);
-						}
-#ifdef DEBUG_VAPI
-					Log_print("Sector %d status %x position %f %d %d data %x",sectorheader.sectornum,
-						sector->sec_status[sector->sec_count-1],percent_rot,
-						sector->sec_rot_pos[sector->sec_count-1],
-						VAPI_16(sectorheader.sectorpos),
-						sector->sec_offset[sector->sec_count-1]);				
-#endif				
-				}
-#ifdef DEBUG_VAPI
-				Log_flushlog();
-#endif
-			} else {
-				Log_print("Unknown VAPI track type Track:%d Type:%d",trackheader.tracknum,tracktype);
-			}
-			trackoffset += next;
-		}			
 	}
-	else {
-		int file_length = Util_flen(f);
-		/* check for PRO */
-		if ((file_length-16)%(128+12) == 0 &&
-				(header.magic1*256 + header.magic2 == (file_length-16)/(128+12)) &&
-				header.seccountlo == 'P') {
-			pro_additional_info_t *info;
-			/* .pro is read only for now */
-			if (!b_open_readonly) {
-				fclose(f);
-				f = Util_fopen(filename, "rb", sio_tmpbuf[diskno - 1]);
-				if (f == NULL)
-					return FALSE;
-				status = SIO_READ_ONLY;
-			}
-			image_type[diskno - 1] = IMAGE_TYPE_PRO;
-			sectorsize[diskno - 1] = 128;
-			if (file_length >= 1040*(128+12)+16) {
-				/* assume enhanced density */
-				sectorcount[diskno - 1] = 1040;
-			}
-			else {
-				/* assume single density */
-				sectorcount[diskno - 1] = 720;
-			}
 
-			info = Util_malloc(sizeof(pro_additional_info_t));
-			additional_info[diskno-1] = info;
-			info->count = Util_malloc(sectorcount[diskno - 1]);
-			memset(info->count, 0, sectorcount[diskno -1]);
-			info->max_sector = (file_length-16)/(128+12);
-		}
-		else {
-			/* XFD (may be temporary from XFZ/XFD.GZ) */
-
-			image_type[diskno - 1] = IMAGE_TYPE_XFD;
-
-			if (file_length <= (1040 * 128)) {
-				/* single density */
-				sectorsize[diskno - 1] = 128;
-				sectorcount[diskno - 1] = file_length >> 7;
-			}
-			else {
-				/* double density */
-				sectorsize[diskno - 1] = 256;
-				if ((file_length & 0xff) == 0) {
-					boot_sectors_type[diskno - 1] = BOOT_SECTORS_PHYSICAL;
-					sectorcount[diskno - 1] = file_length >> 8;
-				}
-				else
-					sectorcount[diskno - 1] = (file_length + 0x180) >> 8;
-			}
-		}
+	if (info->type == IMG_DISK_TYPE_PRO) {
+		pro_additional_info_t *pro_info;
+		pro_info = Util_malloc(sizeof(pro_additional_info_t));
+		additional_info[diskno-1] = pro_info;
+		pro_info->count = Util_malloc(info->sectorcount);
+		memset(pro_info->count, 0, info->sectorcount);
+		pro_info->max_sector = info->pro_max_sector;
+	}
+	else if (info->type == IMG_DISK_TYPE_VAPI) {
+		vapi_additional_info_t *vapi_info;
+		vapi_info = Util_malloc(sizeof(vapi_additional_info_t));
+		memset(vapi_info, 0, sizeof(vapi_additional_info_t));
+		additional_info[diskno-1] = vapi_info;
+		vapi_info->sectors = info->vapi_sectors;
 	}
 
 #ifdef DEBUG
 	Log_print("sectorcount = %d, sectorsize = %d",
-		   sectorcount[diskno - 1], sectorsize[diskno - 1]);
+		   info->sectorcount, info->sectorsize);
 #endif
-	SIO_format_sectorsize[diskno - 1] = sectorsize[diskno - 1];
-	SIO_format_sectorcount[diskno - 1] = sectorcount[diskno - 1];
+	SIO_format_sectorsize[diskno - 1] = info->sectorsize;
+	SIO_format_sectorcount[diskno - 1] = info->sectorcount;
 	strcpy(SIO_filename[diskno - 1], filename);
 	SIO_drive_status[diskno - 1] = status;
 	disk[diskno - 1] = f;
@@ -559,12 +249,11 @@ void SIO_Dismount(int diskno)
 		disk[diskno - 1] = NULL;
 		SIO_drive_status[diskno - 1] = SIO_NO_DISK;
 		strcpy(SIO_filename[diskno - 1], "Empty");
-		if (image_type[diskno - 1] == IMAGE_TYPE_PRO) {
+		if (image_info[diskno - 1].type == IMG_DISK_TYPE_PRO) {
 			free(((pro_additional_info_t *)additional_info[diskno-1])->count);
 		}
-		else if (image_type[diskno - 1] == IMAGE_TYPE_VAPI) {
-			free(((vapi_additional_info_t *)additional_info[diskno-1])->sectors);
-		}
+		/* VAPI sector list is owned by image_info */
+		IMG_DISK_FreeInfo(&image_info[diskno - 1]);
 		free(additional_info[diskno - 1]);
 		additional_info[diskno - 1] = 0;
 	}
@@ -579,10 +268,6 @@ void SIO_DisableDrive(int diskno)
 
 void SIO_SizeOfSector(UBYTE unit, int sector, int *sz, ULONG *ofs)
 {
-	int size;
-	ULONG offset;
-	int header_size = (image_type[unit] == IMAGE_TYPE_ATR ? 16 : 0);
-
 	if (BINLOAD_start_binloading) {
 		if (sz)
 			*sz = 128;
@@ -591,43 +276,7 @@ void SIO_SizeOfSector(UBYTE unit, int sector, int *sz, ULONG *ofs)
 		return;
 	}
 
-	if (image_type[unit] == IMAGE_TYPE_PRO) {
-		size = 128;
-		offset = 16 + (128+12)*(sector -1); /* returns offset of header */
-	}
-	else if (image_type[unit] == IMAGE_TYPE_VAPI) {
-		vapi_additional_info_t *info;
-		vapi_sec_info_t *secinfo;
-
-		size = 128;
-		info = additional_info[unit];
-		if (info == NULL)
-			offset = 0;
-		else if (sector > sectorcount[unit])
-			offset = 0;
-		else {
-			secinfo = &info->sectors[sector-1];
-			if (secinfo->sec_count == 0  )
-				offset = 0;
-			else
-				offset = secinfo->sec_offset[0];
-		}
-	}
-	else if (sector < 4) {
-		/* special case for first three sectors in ATR and XFD image */
-		size = 128;
-		offset = header_size + (sector - 1) * (boot_sectors_type[unit] == BOOT_SECTORS_PHYSICAL ? 256 : 128);
-	}
-	else {
-		size = sectorsize[unit];
-		offset = header_size + (boot_sectors_type[unit] == BOOT_SECTORS_LOGICAL ? 0x180 : 0x300) + (sector - 4) * size;
-	}
-
-	if (sz)
-		*sz = size;
-
-	if (ofs)
-		*ofs = offset;
+	IMG_DISK_SizeOfSector(&image_info[unit], sector, sz, ofs);
 }
 
 static int SeekSector(int unit, int sector)
@@ -655,14 +304,14 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 		return 0;
 	if (disk[unit] == NULL)
 		return 'N';
-	if (sector <= 0 || sector > sectorcount[unit])
+	if (sector <= 0 || sector > image_info[unit].sectorcount)
 		return 'E';
 	SIO_last_op = SIO_LAST_READ;
 	SIO_last_op_time = 1;
 	SIO_last_drive = unit + 1;
 	/* FIXME: what sector size did the user expect? */
 	size = SeekSector(unit, sector);
-	if (image_type[unit] == IMAGE_TYPE_PRO) {
+	if (image_info[unit].type == IMG_DISK_TYPE_PRO) {
 		pro_additional_info_t *info;
 		unsigned char *count;
 		info = (pro_additional_info_t *)additional_info[unit];
@@ -679,7 +328,7 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 #endif
 			count[sector] = (count[sector]+1) % (buffer[5]+1);
 			if (dupnum != 0)  {
-				sector = sectorcount[unit] + buffer[6+dupnum];
+				sector = image_info[unit].sectorcount + buffer[6+dupnum];
 				/* can dupnum be 5? */
 				if (dupnum > 4 || sector <= 0 || sector > info->max_sector) {
 					Log_print("Error in .pro image: sector:%d dupnum:%d", sector, dupnum);
@@ -705,7 +354,7 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 			return 'E';
 		}
 	}
-	else if (image_type[unit] == IMAGE_TYPE_VAPI) {
+	else if (image_info[unit].type == IMG_DISK_TYPE_VAPI) {
 		vapi_additional_info_t *info;
 		vapi_sec_info_t *secinfo;
 		ULONG secindex = 0;
@@ -717,7 +366,7 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 		info = (vapi_additional_info_t *)additional_info[unit];
 		info->vapi_delay_time = 0;
 
-		if (sector > sectorcount[unit]) {
+		if (sector > image_info[unit].sectorcount) {
 #ifdef DEBUG_VAPI
 			Log_print("bad sector num:%d", sector);
 #endif
@@ -832,13 +481,13 @@ int SIO_WriteSector(int unit, int sector, const UBYTE *buffer)
 		return 0;
 	if (disk[unit] == NULL)
 		return 'N';
-	if (SIO_drive_status[unit] != SIO_READ_WRITE || sector <= 0 || sector > sectorcount[unit])
+	if (SIO_drive_status[unit] != SIO_READ_WRITE || sector <= 0 || sector > image_info[unit].sectorcount)
 		return 'E';
 	SIO_last_op = SIO_LAST_WRITE;
 	SIO_last_op_time = 1;
 	SIO_last_drive = unit + 1;
 #ifdef VAPI_WRITE_ENABLE 	
- 	if (image_type[unit] == IMAGE_TYPE_VAPI) {
+ 	if (image_info[unit].type == IMG_DISK_TYPE_VAPI) {
 		vapi_additional_info_t *info;
 		vapi_sec_info_t *secinfo;
 
@@ -861,7 +510,7 @@ int SIO_WriteSector(int unit, int sector, const UBYTE *buffer)
 		io_success[unit] = 0;
 		return 'C';
 #if 0		
-	} else if (image_type[unit] == IMAGE_TYPE_PRO) {
+	} else if (image_info[unit].type == IMG_DISK_TYPE_PRO) {
 		pro_additional_info_t *info;
 		pro_phantom_sec_info_t *phantom;
 		
@@ -906,10 +555,10 @@ int SIO_FormatDisk(int unit, UBYTE *buffer, int sectsize, int sectcount)
 	   First get the information about the disk image, because we are going
 	   to umount it. */
 	memcpy(fname, SIO_filename[unit], FILENAME_MAX);
-	is_atr = (image_type[unit] == IMAGE_TYPE_ATR);
-	save_boot_sectors_type = boot_sectors_type[unit];
+	is_atr = (image_info[unit].type == IMG_DISK_TYPE_ATR);
+	save_boot_sectors_type = image_info[unit].boot_sectors_type;
 	bootsectsize = 128;
-	if (sectsize == 256 && save_boot_sectors_type != BOOT_SECTORS_LOGICAL)
+	if (sectsize == 256 && save_boot_sectors_type != IMG_DISK_BOOT_SECTORS_LOGICAL)
 		bootsectsize = 256;
 	bootsectcount = sectcount < 3 ? sectcount : 3;
 	/* Umount the file and open it in "wb" mode (it will truncate the file) */
@@ -920,20 +569,8 @@ int SIO_FormatDisk(int unit, UBYTE *buffer, int sectsize, int sectcount)
 		return 'E';
 	}
 	/* Write ATR header if necessary */
-	if (is_atr) {
-		struct AFILE_ATR_Header header;
-		ULONG disksize = (bootsectsize * bootsectcount + sectsize * (sectcount - bootsectcount)) >> 4;
-		memset(&header, 0, sizeof(header));
-		header.magic1 = AFILE_ATR_MAGIC1;
-		header.magic2 = AFILE_ATR_MAGIC2;
-		header.secsizelo = (UBYTE) sectsize;
-		header.secsizehi = (UBYTE) (sectsize >> 8);
-		header.seccountlo = (UBYTE) disksize;
-		header.seccounthi = (UBYTE) (disksize >> 8);
-		header.hiseccountlo = (UBYTE) (disksize >> 16);
-		header.hiseccounthi = (UBYTE) (disksize >> 24);
-		fwrite(&header, 1, sizeof(header), f);
-	}
+	if (is_atr)
+		IMG_DISK_WriteATRHeader(f, sectsize, sectcount, bootsectsize);
 	/* Write boot sectors */
 	memset(buffer, 0, sectsize);
 	for (i = 1; i <= bootsectcount; i++)
@@ -947,7 +584,7 @@ int SIO_FormatDisk(int unit, UBYTE *buffer, int sectsize, int sectcount)
 	/* We want to keep the current PHYSICAL/SIO2PC boot sectors type
 	   (since the image is blank it can't be figured out by SIO_Mount) */
 	if (bootsectsize == 256)
-		boot_sectors_type[unit] = save_boot_sectors_type;
+		image_info[unit].boot_sectors_type = save_boot_sectors_type;
 	/* Return information for Atari (buffer filled with ff's - no bad sectors) */
 	memset(buffer, 0xff, sectsize);
 	io_success[unit] = 0;
@@ -996,7 +633,7 @@ int SIO_ReadStatusBlock(int unit, UBYTE *buffer)
 	/* default to 1 track, 1 side for non-standard images */
 	tracks = 1;
 	heads = 1;
-	spt = sectorcount[unit];
+	spt = image_info[unit].sectorcount;
 
 	if (spt % 40 == 0) {
 		/* standard disk */
@@ -1020,9 +657,9 @@ int SIO_ReadStatusBlock(int unit, UBYTE *buffer)
 	buffer[3] = (UBYTE) spt;         /* sectors per track. LO byte */
 	buffer[4] = (UBYTE) (heads - 1); /* # of heads minus 1 */
 	/* FM for single density, MFM otherwise */
-	buffer[5] = (sectorsize[unit] == 128 && sectorcount[unit] <= 720) ? 0 : 4;
-	buffer[6] = (UBYTE) (sectorsize[unit] >> 8); /* bytes per sector. HI byte */
-	buffer[7] = (UBYTE) sectorsize[unit];        /* bytes per sector. LO byte */
+	buffer[5] = (image_info[unit].sectorsize == 128 && image_info[unit].sectorcount <= 720) ? 0 : 4;
+	buffer[6] = (UBYTE) (image_info[unit].sectorsize >> 8); /* bytes per sector. HI byte */
+	buffer[7] = (UBYTE) image_info[unit].sectorsize;        /* bytes per sector. LO byte */
 	buffer[8] = 1;                   /* drive is online */
 	buffer[9] = 192;                 /* transfer speed, whatever this means */
 	buffer[10] = 0;
@@ -1065,7 +702,7 @@ int SIO_DriveStatus(int unit, UBYTE *buffer)
 		return 0;
 
 	/* .PRO contains status information in the sector header */
-	if (io_success[unit] != 0  && image_type[unit] == IMAGE_TYPE_PRO) {
+	if (io_success[unit] != 0  && image_info[unit].type == IMG_DISK_TYPE_PRO) {
 		int sector = io_success[unit];
 		SeekSector(unit, sector);
 		if (fread(buffer, 1, 4, disk[unit]) < 4) {
@@ -1073,7 +710,7 @@ int SIO_DriveStatus(int unit, UBYTE *buffer)
 		}
 		return 'C';
 	}
-	else if (io_success[unit] != 0  && image_type[unit] == IMAGE_TYPE_VAPI &&
+	else if (io_success[unit] != 0  && image_info[unit].type == IMG_DISK_TYPE_VAPI &&
 			 SIO_drive_status[unit] != SIO_NO_DISK) {
 		vapi_additional_info_t *info;
 		info = (vapi_additional_info_t *)additional_info[unit];
@@ -1356,7 +993,7 @@ static UBYTE Command_Frame(void)
 		DataIndex = 0;
 		ExpectedBytes = 14;
 		TransferStatus = SIO_ReadFrame;
-		POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL;
+		POKEY_SetSerinDelay(SIO_SERIN_INTERVAL);
 		return 'A';
 	case 0x4f:				/* Write status */
 #ifdef DEBUG
@@ -1400,23 +1037,26 @@ static UBYTE Command_Frame(void)
 		TransferStatus = SIO_ReadFrame;
 		/* wait longer before confirmation because bytes could be lost */
 		/* before the buffer was set (see $E9FB & $EA37 in XL-OS) */
-		POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL << 2; 
-		if (image_type[unit] == IMAGE_TYPE_VAPI) {
+		if (image_info[unit].type == IMG_DISK_TYPE_VAPI) {
 			vapi_additional_info_t *info;
 			info = (vapi_additional_info_t *)additional_info[unit];
 			if (info == NULL)
-				POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL << 2; 
+				POKEY_SetSerinDelay(SIO_SERIN_INTERVAL << 2);
 			else
-				POKEY_DELAYED_SERIN_IRQ = ((info->vapi_delay_time + 114/2) / 114) - 12;
+				POKEY_SetSerinDelay(((info->vapi_delay_time + 114/2) / 114) - 12);
 		} 
 #ifndef NO_SECTOR_DELAY
 		else if (sector == 1) {
-			POKEY_DELAYED_SERIN_IRQ += delay_counter;
+			POKEY_SetSerinDelay((SIO_SERIN_INTERVAL << 2) + delay_counter);
 			delay_counter = SECTOR_DELAY;
 		}
 		else {
+			POKEY_SetSerinDelay(SIO_SERIN_INTERVAL << 2);
 			delay_counter = 0;
 		}
+#else
+		else
+			POKEY_SetSerinDelay(SIO_SERIN_INTERVAL << 2);
 #endif
 		SIO_last_op = SIO_LAST_READ;
 		SIO_last_op_time = 10;
@@ -1433,7 +1073,7 @@ static UBYTE Command_Frame(void)
 		DataIndex = 0;
 		ExpectedBytes = 6;
 		TransferStatus = SIO_ReadFrame;
-		POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL;
+		POKEY_SetSerinDelay(SIO_SERIN_INTERVAL);
 		return 'A';
 	/*case 0x66:*/			/* US Doubler Format - I think! */
 	case 0x21:				/* Format Disk */
@@ -1449,7 +1089,7 @@ static UBYTE Command_Frame(void)
 		DataIndex = 0;
 		ExpectedBytes = 2 + realsize;
 		TransferStatus = SIO_FormatFrame;
-		POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL;
+		POKEY_SetSerinDelay(SIO_SERIN_INTERVAL);
 		return 'A';
 	case 0x22:				/* Dual Density Format */
 	case 0xa2:				/* xf551 hispeed */
@@ -1463,7 +1103,7 @@ static UBYTE Command_Frame(void)
 		DataIndex = 0;
 		ExpectedBytes = 2 + 128;
 		TransferStatus = SIO_FormatFrame;
-		POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL;
+		POKEY_SetSerinDelay(SIO_SERIN_INTERVAL);
 		return 'A';
 	default:
 		/* Unknown command for a disk drive */
@@ -1551,7 +1191,7 @@ void SIO_PutByte(int byte)
 			if (CommandIndex >= ExpectedBytes) {
 				if (CommandFrame[0] >= 0x31 && CommandFrame[0] <= 0x38 && (SIO_drive_status[CommandFrame[0]-0x31] != SIO_OFF || BINLOAD_start_binloading)) {
 					TransferStatus = SIO_StatusRead;
-					POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL + SIO_ACK_INTERVAL;
+					POKEY_SetSerinDelay(SIO_SERIN_INTERVAL + SIO_ACK_INTERVAL);
 				}
 				else
 					TransferStatus = SIO_NoFrame;
@@ -1574,7 +1214,7 @@ void SIO_PutByte(int byte)
 						DataBuffer[1] = result;
 						DataIndex = 0;
 						ExpectedBytes = 2;
-						POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL + SIO_ACK_INTERVAL;
+						POKEY_SetSerinDelay(SIO_SERIN_INTERVAL + SIO_ACK_INTERVAL);
 						TransferStatus = SIO_FinalStatus;
 					}
 					else
@@ -1584,7 +1224,7 @@ void SIO_PutByte(int byte)
 					DataBuffer[0] = 'E';
 					DataIndex = 0;
 					ExpectedBytes = 1;
-					POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL + SIO_ACK_INTERVAL;
+					POKEY_SetSerinDelay(SIO_SERIN_INTERVAL + SIO_ACK_INTERVAL);
 					TransferStatus = SIO_FinalStatus;
 				}
 			}
@@ -1597,7 +1237,7 @@ void SIO_PutByte(int byte)
 		CASSETTE_PutByte(byte);
 		break;
 	}
-	/* POKEY_DELAYED_SEROUT_IRQ = SIO_SEROUT_INTERVAL; */ /* already set in pokey.c */
+	/* the SEROUT IRQ is already scheduled in pokey.c */
 }
 
 /* Get a byte from the floppy to the pokey. */
@@ -1611,7 +1251,7 @@ int SIO_GetByte(void)
 		break;
 	case SIO_FormatFrame:
 		TransferStatus = SIO_ReadFrame;
-		POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL << 3;
+		POKEY_SetSerinDelay(SIO_SERIN_INTERVAL << 3);
 		/* FALL THROUGH */
 	case SIO_ReadFrame:
 		if (DataIndex < ExpectedBytes) {
@@ -1621,8 +1261,8 @@ int SIO_GetByte(void)
 			}
 			else {
 				/* set delay using the expected transfer speed */
-				POKEY_DELAYED_SERIN_IRQ = (DataIndex == 1) ? SIO_SERIN_INTERVAL
-					: ((SIO_SERIN_INTERVAL * POKEY_AUDF[POKEY_CHAN3] - 1) / 0x28 + 1);
+				POKEY_SetSerinDelay((DataIndex == 1) ? SIO_SERIN_INTERVAL
+					: ((SIO_SERIN_INTERVAL * POKEY_AUDF[POKEY_CHAN3] - 1) / 0x28 + 1));
 			}
 		}
 		else {
@@ -1638,9 +1278,9 @@ int SIO_GetByte(void)
 			}
 			else {
 				if (DataIndex == 0)
-					POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL + SIO_ACK_INTERVAL;
+					POKEY_SetSerinDelay(SIO_SERIN_INTERVAL + SIO_ACK_INTERVAL);
 				else
-					POKEY_DELAYED_SERIN_IRQ = SIO_SERIN_INTERVAL;
+					POKEY_SetSerinDelay(SIO_SERIN_INTERVAL);
 			}
 		}
 		else {
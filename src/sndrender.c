@@ -0,0 +1,158 @@
+/*
+ * sndrender.c - fast rendering of sound to a file, without display
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#include <string.h>
+
+#include "atari.h"
+#include "log.h"
+#include "pokeysnd.h"
+#ifdef SYNCHRONIZED_SOUND
+#include "mzpokeysnd.h"
+#endif
+#include "sap.h"
+#include "sndrender.h"
+#include "sndsave.h"
+#include "util.h"
+
+/* Length used when neither -render-time nor a SAP TIME tag gives one */
+#define DEFAULT_TIME 180.0
+
+int SndRender_enabled = FALSE;
+
+static char filename[FILENAME_MAX];
+static double render_time = 0.0;
+static int render_rate = 44100;
+/* samples per frame, and the fraction of a sample carried to the next frame */
+static double frame_samples;
+static double frame_fraction;
+
+int SndRender_Initialise(int *argc, char *argv[])
+{
+	int i;
+	int j;
+	for (i = j = 1; i < *argc; i++) {
+		int i_a = (i + 1 < *argc);		/* is argument available? */
+		int a_m = FALSE;			/* error, argument missing! */
+
+		if (strcmp(argv[i], "-render") == 0) {
+			if (i_a) {
+				Util_strlcpy(filename, argv[++i], sizeof(filename));
+				SndRender_enabled = TRUE;
+			}
+			else a_m = TRUE;
+		}
+		else if (strcmp(argv[i], "-render-time") == 0) {
+			if (i_a) {
+				if (!Util_sscandouble(argv[++i], &render_time) || render_time <= 0.0) {
+					Log_print("Invalid render time - must be more than 0 seconds");
+					return FALSE;
+				}
+			}
+			else a_m = TRUE;
+		}
+		else if (strcmp(argv[i], "-render-rate") == 0) {
+			if (i_a) {
+				render_rate = Util_sscandec(argv[++i]);
+				/* The MZ POKEY filter can't be designed for lower rates. */
+				if (render_rate < 11025 || render_rate > 65535) {
+					Log_print("Invalid render sample rate - must be 11025..65535 Hz");
+					return FALSE;
+				}
+			}
+			else a_m = TRUE;
+		}
+		else {
+			if (strcmp(argv[i], "-help") == 0) {
+				Log_print("\t-render <file>   Write the sound to a WAV file without display, and exit");
+				Log_print("\t-render-time <s> Length of the sound (default: SAP TIME or 180 seconds)");
+				Log_print("\t-render-rate <n> Sample rate of the sound (default: 44100)");
+			}
+			argv[j++] = argv[i];
+		}
+
+		if (a_m) {
+			Log_print("Missing argument for '%s'", argv[i]);
+			return FALSE;
+		}
+	}
+	*argc = j;
+	return TRUE;
+}
+
+void SndRender_Frame(void)
+{
+#ifdef SYNCHRONIZED_SOUND
+	/* writes to the sound file */
+	MZPOKEYSND_UpdateProcessBuffer();
+#else
+	/* A frame has up to 65535 / Atari800_FPS_PAL + 1 = 1316 samples per
+	   channel, so the sound is generated in pieces. The piece length must be
+	   a multiple of the number of channels. */
+	static SWORD buffer[1024];
+	int n;
+	int len;
+	frame_fraction += frame_samples;
+	n = (int) frame_fraction;
+	frame_fraction -= n;
+	n *= POKEYSND_num_pokeys;
+	while (n > 0) {
+		len = n < 1024 ? n : 1024;
+		POKEYSND_Process(buffer, len);
+		n -= len;
+	}
+#endif
+}
+
+int SndRender_Run(void)
+{
+	double fps = Atari800_tv_mode == Atari800_TV_PAL ? Atari800_FPS_PAL : Atari800_FPS_NTSC;
+	double seconds = render_time > 0.0 ? render_time : SAP_time > 0.0 ? SAP_time : DEFAULT_TIME;
+	int frames = (int) (seconds * fps + 0.5);
+	int channels = 1;
+
+#ifdef STEREO_SOUND
+	if (SAP_stereo)
+		POKEYSND_stereo_enabled = TRUE;
+	if (POKEYSND_stereo_enabled)
+		channels = 2;
+#endif
+	POKEYSND_Init(POKEYSND_FREQ_17_EXACT, render_rate, channels, POKEYSND_BIT16);
+	if (!SndSave_OpenSoundFile(filename)) {
+		Log_print("Cannot create %s", filename);
+		return FALSE;
+	}
+	frame_samples = render_rate / fps;
+	frame_fraction = 0.0;
+	/* no waiting between frames */
+	Atari800_turbo = TRUE;
+	while (frames-- > 0)
+		Atari800_Frame();
+	POKEYSND_CloseLog();
+	if (!SndSave_CloseSoundFile()) {
+		Log_print("Error writing %s", filename);
+		return FALSE;
+	}
+	Log_print("%s: %.1f seconds of sound written", filename, seconds);
+	return TRUE;
+}
@@ -0,0 +1,23 @@
+#ifndef SNDRENDER_H_
+#define SNDRENDER_H_
+
+#include "atari.h"
+
+/* Rendering the sound of a program to a WAV file as fast as possible,
+   without a display or a sound device. Selected with -render <file>.
+   Only the timing of the display (DMA cycles, DLIs and VBIs) is emulated. */
+
+/* TRUE if -render was given. Then no platform initialisation is done and
+   Atari800_Initialise() calls SndRender_Run(). */
+extern int SndRender_enabled;
+
+int SndRender_Initialise(int *argc, char *argv[]);
+
+/* Emulates the requested time and writes the WAV file.
+   Returns FALSE on error. */
+int SndRender_Run(void);
+
+/* Generates the sound of one frame. Called by Atari800_Frame(). */
+void SndRender_Frame(void);
+
+#endif /* SNDRENDER_H_ */
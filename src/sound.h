@@ -12,4 +12,19 @@ void Sound_Continue(void);
 void Sound_Reinit(void);
 #endif
 
+#ifdef SYNCHRONIZED_SOUND
+/* State of the sound buffer since the sound was set up. The fill levels
+   are in ms, ratio is the current resampling ratio. */
+typedef struct Sound_stats_t {
+	double fill_min;
+	double fill_avg;
+	double fill_max;
+	double ratio;
+	int underflows;
+	int overflows;
+} Sound_stats_t;
+
+void Sound_GetStats(Sound_stats_t *stats);
+#endif
+
 #endif /* SOUND_H_ */
@@ -35,6 +35,7 @@
 /* XXX: #include <machine/soundcard.h> */
 
 #include "atari.h"
+#include "cassette.h"
 #include "log.h"
 #include "pokeysnd.h"
 #include "sound.h"
@@ -171,7 +172,7 @@ void Sound_Update(void)
 	   - pokeysnd currently supports only up to 65535Hz */
 	static unsigned char buffer[4096];
 	unsigned int len;
-	if (!sound_enabled || Atari800_turbo)
+	if (!sound_enabled || Atari800_turbo || CASSETTE_Turbo())
 		return;
 	/* compute number of samples for one Atari frame
 	   (assuming 60Hz for NTSC and 50Hz for PAL) */
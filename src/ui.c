@@ -33,6 +33,9 @@
 #include "antic.h"
 #include "artifact.h"
 #include "atari.h"
+#ifdef AVI_RECORDING
+#include "avirec.h"
+#endif
 #include "binload.h"
 #include "cartridge.h"
 #include "cassette.h"
@@ -1318,6 +1321,30 @@ static void SoundRecording(void)
 }
 #endif /* defined(SOUND) && !defined(DREAMCAST) */
 
+#ifdef AVI_RECORDING
+static void VideoRecording(void)
+{
+	if (!AVIRec_IsOpen()) {
+		int no = 0;
+		do {
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "atari%03d.avi", no);
+			if (!Util_fileexists(buffer)) {
+				/* file does not exist - we can create it */
+				FilenameMessage(AVIRec_Open(buffer)
+					? "Recording video to file \"%s\""
+					: "Can't write to file \"%s\"", buffer);
+				return;
+			}
+		} while (++no < 1000);
+		UI_driver->fMessage("All atariXXX.avi files exist!", 1);
+	}
+	else {
+		UI_driver->fMessage(AVIRec_Close() ? "Recording stopped" : "Error writing video file", 1);
+	}
+}
+#endif /* AVI_RECORDING */
+
 static int AutostartFile(void)
 {
 	static char filename[FILENAME_MAX];
@@ -1365,6 +1392,7 @@ static void TapeManagement(void)
 		UI_MENU_ACTION_PREFIX_TIP(1, "Position: ", position_string, NULL),
 		UI_MENU_CHECK(2, "Record:"),
 		UI_MENU_SUBMENU(3, "Make blank tape"),
+		UI_MENU_CHECK(4, "Full speed while loading:"),
 		UI_MENU_END
 	};
 
@@ -1399,6 +1427,7 @@ static void TapeManagement(void)
 		}
 
 		SetItemChecked(menu_array, 2, CASSETTE_record);
+		SetItemChecked(menu_array, 4, CASSETTE_turbo);
 
 		if (CASSETTE_status == CASSETTE_STATUS_NONE)
 			memcpy(position_string, "N/A", 4);
@@ -1462,6 +1491,9 @@ static void TapeManagement(void)
 		case 3:
 			MakeBlankTapeMenu();
 			break;
+		case 4:
+			CASSETTE_turbo = !CASSETTE_turbo;
+			break;
 		default:
 			return;
 		}
@@ -3666,9 +3698,11 @@ static int SoundSettings(void)
 		/* XXX: don't allow on smartphones? */
 #ifndef SYNCHRONIZED_SOUND
 		UI_MENU_CHECK(0, "High Fidelity POKEY:"),
+		UI_MENU_CHECK(6, "Band-limited POKEY:"),
 #endif
 #ifdef STEREO_SOUND
 		UI_MENU_CHECK(1, "Dual POKEY (Stereo):"),
+		UI_MENU_CHECK(7, "Quad POKEY:"),
 #endif
 #ifdef CONSOLE_SOUND
 		UI_MENU_CHECK(2, "Speaker (Key Click):"),
@@ -3690,9 +3724,11 @@ static int SoundSettings(void)
 	for (;;) {
 #ifndef SYNCHRONIZED_SOUND
 		SetItemChecked(menu_array, 0, POKEYSND_enable_new_pokey);
+		SetItemChecked(menu_array, 6, POKEYSND_enable_blep_pokey);
 #endif
 #ifdef STEREO_SOUND
 		SetItemChecked(menu_array, 1, POKEYSND_stereo_enabled);
+		SetItemChecked(menu_array, 7, POKEYSND_stereo_enabled && POKEYSND_quad_enabled);
 #endif
 #ifdef CONSOLE_SOUND
 		SetItemChecked(menu_array, 2, POKEYSND_console_sound_enabled);
@@ -3701,7 +3737,7 @@ static int SoundSettings(void)
 		SetItemChecked(menu_array, 3, POKEYSND_serio_sound_enabled);
 #endif
 #ifndef SYNCHRONIZED_SOUND
-		FindMenuItem(menu_array, 4)->suffix = POKEYSND_enable_new_pokey ? "N/A" : POKEYSND_bienias_fix ? "Yes" : "No ";
+		FindMenuItem(menu_array, 4)->suffix = POKEYSND_enable_new_pokey || POKEYSND_enable_blep_pokey ? "N/A" : POKEYSND_bienias_fix ? "Yes" : "No ";
 #endif
 #ifdef DREAMCAST
 		SetItemChecked(menu_array, 5, glob_snd_ena);
@@ -3728,6 +3764,15 @@ static int SoundSettings(void)
 			POKEYSND_stereo_enabled = !POKEYSND_stereo_enabled;
 #ifdef SUPPORTS_SOUND_REINIT
 			Sound_Reinit();
+#endif
+			break;
+		case 7:
+			/* four chips are always mixed to stereo */
+			POKEYSND_quad_enabled = !(POKEYSND_stereo_enabled && POKEYSND_quad_enabled);
+			if (POKEYSND_quad_enabled)
+				POKEYSND_stereo_enabled = TRUE;
+#ifdef SUPPORTS_SOUND_REINIT
+			Sound_Reinit();
 #endif
 			break;
 #endif
@@ -3743,13 +3788,20 @@ static int SoundSettings(void)
 #endif
 #ifndef SYNCHRONIZED_SOUND
 		case 4:
-			if (! POKEYSND_enable_new_pokey) POKEYSND_bienias_fix = !POKEYSND_bienias_fix;
+			if (! POKEYSND_enable_new_pokey && ! POKEYSND_enable_blep_pokey) POKEYSND_bienias_fix = !POKEYSND_bienias_fix;
 			break;
 #endif
 #ifdef DREAMCAST
 		case 5:
 			glob_snd_ena = !glob_snd_ena;
 			break;
+#endif
+#ifndef SYNCHRONIZED_SOUND
+		case 6:
+			POKEYSND_enable_blep_pokey = !POKEYSND_enable_blep_pokey;
+			POKEYSND_DoInit();
+			UI_driver->fMessage("Will reboot to apply the change", 1);
+			return TRUE; /* reboot required */
 #endif
 		default:
 			return FALSE;
@@ -3857,6 +3909,9 @@ void UI_Run(void)
 		UI_MENU_ACTION_ACCEL(UI_MENU_SOUND_RECORDING, "Sound Recording Start/Stop", "Alt+W"),
 #endif
 #endif
+#ifdef AVI_RECORDING
+		UI_MENU_ACTION(UI_MENU_VIDEO_RECORDING, "Video Recording Start/Stop"),
+#endif
 #ifndef CURSES_BASIC
 		UI_MENU_SUBMENU(UI_MENU_DISPLAY, "Display Settings"),
 #endif
@@ -3979,6 +4034,11 @@ void UI_Run(void)
 			SoundRecording();
 			break;
 #endif
+#endif
+#ifdef AVI_RECORDING
+		case UI_MENU_VIDEO_RECORDING:
+			VideoRecording();
+			break;
 #endif
 		case UI_MENU_SAVESTATE:
 			SaveState();
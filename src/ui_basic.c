@@ -195,6 +195,8 @@ static void Plot(int fg, int bg, int ch, int x, int y)
 	int i;
 	int j;
 
+	ANTIC_InvalidateLines(24 + y * 8, 8);
+
 	for (i = 0; i < 8; i++) {
 		UBYTE data = *font_ptr++;
 		for (j = 0; j < 8; j++) {
@@ -258,6 +260,7 @@ static void ClearRectangle(int bg, int x1, int y1, int x2, int y2)
 	UBYTE *ptr = (UBYTE *) Screen_atari + Screen_WIDTH * 24 + 32 + x1 * 8 + y1 * (Screen_WIDTH * 8);
 	int bytesperline = (x2 - x1 + 1) << 3;
 	UBYTE *end_ptr = (UBYTE *) Screen_atari + Screen_WIDTH * 32 + 32 + y2 * (Screen_WIDTH * 8);
+	ANTIC_InvalidateLines(24 + y1 * 8, (y2 - y1 + 1) * 8);
 	while (ptr < end_ptr) {
 #ifdef USE_COLOUR_TRANSLATION_TABLE
 		ANTIC_VideoMemset(ptr, (UBYTE) colour_translation_table[bg], bytesperline);
@@ -274,6 +277,7 @@ static void ClearScreen(void)
 #ifdef USE_CURSES
 	curses_clear_screen();
 #else
+	ANTIC_InvalidateLines(0, Screen_HEIGHT);
 #ifdef USE_COLOUR_TRANSLATION_TABLE
 	ANTIC_VideoMemset((UBYTE *) Screen_atari, colour_translation_table[0x00], Screen_HEIGHT * Screen_WIDTH);
 #else
@@ -382,6 +382,15 @@ void Votrax_Update(int num, SWORD *buffer, int length)
 					votraxsc01_locals.iRemainingSamples = PhonemeData[votraxsc01_locals.actPhoneme].iLength[votraxsc01_locals.actIntonation];
 				}
 
+				if ( votraxsc01_locals.iRemainingSamples==1 ) {
+					/* a loop of one sample (the silence of the pauses): fill
+					   the whole buffer instead of copying it sample by sample */
+					SWORD data = *votraxsc01_locals.pActPos++;
+					while ( length-- )
+						*buffer++ = data;
+					votraxsc01_locals.iRemainingSamples = 0;
+					return;
+				}
 			}
 
 			/* if there aren't enough remaining, reduce the amount */
@@ -42,8 +42,9 @@
 static double ratio;
 static int bit16;
 #define VTRX_BLOCK_SIZE 1024
+/* volume of the speech, 128 = full */
+#define VTRX_VOLUME (128/4)
 SWORD *temp_votrax_buffer = NULL;
-SWORD *votrax_buffer = NULL;
 int VOTRAXSND_busy = FALSE;
 static int votrax_sync_samples;
 static int dsprate;
@@ -123,8 +124,6 @@ void VOTRAXSND_Init(int playback_freq, int n_pokeys, int b16)
 #endif
 	free(temp_votrax_buffer);
 	temp_votrax_buffer = (SWORD *)Util_malloc(temp_votrax_buffer_size*sizeof(SWORD));
-	free(votrax_buffer);
-	votrax_buffer = (SWORD *)Util_malloc(VTRX_BLOCK_SIZE*sizeof(SWORD));
 
 	VOTRAXSND_busy = FALSE;
 	votrax_sync_samples = 0;
@@ -135,18 +134,19 @@ void VOTRAXSND_Reinit(void)
 	if (dsprate) VOTRAXSND_Init(dsprate, num_pokeys, bit16);
 }
 
-/* process votrax and interpolate samples */
-static void votrax_process(SWORD *v_buffer, int len, SWORD *temp_v_buffer)
+/* Generates the votrax samples for LEN output samples in temp_v_buffer and
+   sets *START to the position of the first output sample in it.
+   Returns FALSE if the samples are all silent, so there is nothing to mix. */
+static int votrax_process(int len, SWORD *temp_v_buffer, double *start)
 {
 	static SWORD last_sample;
 	static SWORD last_sample2;
 	static double startpos;
 	static int have;
 	int max_left_sample_index = (int)(startpos + (double)(len - 1)*ratio);
-	int pos = 0;
-	double fraction = 0;
 	int i;
 	int floor_next_pos;
+	int sound = FALSE;
 
 	if (have == 2) {
 	    temp_v_buffer[0] = last_sample;
@@ -165,17 +165,15 @@ static void votrax_process(SWORD *v_buffer, int len, SWORD *temp_v_buffer)
 		Votrax_Update(0, temp_v_buffer, max_left_sample_index + 1 + 1);
 	}
 
-	for (i = 0; i < len; i++) {
-		SWORD left_sample;
-		SWORD right_sample;
-		SWORD interp_sample;
-		pos = (int)(startpos + (double)i*ratio);
-		fraction = startpos + (double)i*ratio - (double)pos;
-		left_sample = temp_v_buffer[pos];
-		right_sample = temp_v_buffer[pos+1];
-		interp_sample = (int)(left_sample + fraction*(double)(right_sample-left_sample));
-		v_buffer[i] = interp_sample;
+	/* the chip is silent most of the time */
+	for (i = 0; i <= max_left_sample_index + 1; i++) {
+		if (temp_v_buffer[i] != 0) {
+			sound = TRUE;
+			break;
+		}
 	}
+
+	*start = startpos;
 	floor_next_pos = (int)(startpos + (double)len*ratio);
 	startpos = (startpos + (double)len*ratio) - (double)floor_next_pos;
 	if (floor_next_pos == max_left_sample_index)
@@ -191,47 +189,39 @@ static void votrax_process(SWORD *v_buffer, int len, SWORD *temp_v_buffer)
 	else {
 		have = (floor_next_pos - (max_left_sample_index + 2));
 	}
+	return sound;
 }
 
-/* 16 bit mixing */
-static void mix(SWORD *dst, SWORD *src, int sndn, int volume)
+/* Interpolates samples I0 to I1 - 1 from SRC, starting at position START,
+   and mixes them into every STEP-th sample of DST - 16 bit */
+static void mix(SWORD *dst, const SWORD *src, double start, int i0, int i1, int step)
 {
-	SWORD s1, s2;
-	int val;
+	int i;
 
-	while (sndn--) {
-		s1 = *src;
-		s1 = s1*volume/128;
-		s2 = *dst;
-		src++;
-		val = s1 + s2;
+	for (i = i0; i < i1; i++, dst += step) {
+		double x = start + (double)i*ratio;
+		int pos = (int)x;
+		SWORD s = (int)(src[pos] + (x - (double)pos)*(double)(src[pos+1] - src[pos]));
+		int val = s*VTRX_VOLUME/128 + *dst;
 		if (val > 32767) val = 32767;
 		if (val < -32768) val = -32768;
-		*dst++ = val;
-		if (num_pokeys == 2) {
-			dst++;
-		}
+		*dst = val;
 	}
 }
 
 /* 8 bit mixing */
-static void mix8(UBYTE *dst, SWORD *src, int sndn, int volume)
+static void mix8(UBYTE *dst, const SWORD *src, double start, int i0, int i1, int step)
 {
-	SWORD s1, s2;
-	int val;
+	int i;
 
-	while (sndn--) {
-		s1 = *src;
-		s1 = s1*volume/128;
-		s2 = ((int)(*dst) - 0x80)*256;
-		src++;
-		val = s1 + s2;
+	for (i = i0; i < i1; i++, dst += step) {
+		double x = start + (double)i*ratio;
+		int pos = (int)x;
+		SWORD s = (int)(src[pos] + (x - (double)pos)*(double)(src[pos+1] - src[pos]));
+		int val = s*VTRX_VOLUME/128 + ((int)(*dst) - 0x80)*256;
 		if (val > 32767) val = 32767;
 		if (val < -32768) val = -32768;
-		*dst++ = (UBYTE)((val/256) + 0x80);
-		if (num_pokeys == 2) {
-			dst++;
-		}
+		*dst = (UBYTE)((val/256) + 0x80);
 	}
 }
 
@@ -255,8 +245,23 @@ void VOTRAXSND_Frame(void)
 	}
 }
 
+/* Mixes samples I0 to I1 - 1 of the current block into DST */
+static void mix_range(void *dst, double start, int i0, int i1)
+{
+	if (i0 >= i1) return;
+	/* the speech goes to the left channel */
+	if (bit16) mix((SWORD *)dst, temp_votrax_buffer, start, i0, i1, num_pokeys);
+	else mix8((UBYTE *)dst, temp_votrax_buffer, start, i0, i1, num_pokeys);
+}
+
 void VOTRAXSND_Process(void *sndbuffer, int sndn)
 {
+	VOTRAXSND_Process2(sndbuffer, sndn, NULL, 0);
+}
+
+void VOTRAXSND_Process2(void *sndbuffer, int sndn, void *sndbuffer2, int sndn2)
+{
+	int frame_bytes = (bit16 ? 2 : 1)*num_pokeys;
 	if (!votraxsnd_enabled()) return;
 
 	if(votrax_written) {
@@ -264,13 +269,22 @@ void VOTRAXSND_Process(void *sndbuffer, int sndn)
 		Votrax_PutByte(votrax_written_byte);
 	}
 	sndn /= num_pokeys;
-	while (sndn > 0) {
-		int amount = ((sndn > VTRX_BLOCK_SIZE) ? VTRX_BLOCK_SIZE : sndn);
-		votrax_process(votrax_buffer, amount, temp_votrax_buffer);
-		if (bit16) mix((SWORD *)sndbuffer, votrax_buffer, amount, 128/4);
-		else mix8((UBYTE *)sndbuffer, votrax_buffer, amount, 128/4);
-		sndbuffer = (char *) sndbuffer + VTRX_BLOCK_SIZE*(bit16 ? 2 : 1)*((num_pokeys == 2) ? 2: 1);
-		sndn -= VTRX_BLOCK_SIZE;
+	sndn2 /= num_pokeys;
+	while (sndn + sndn2 > 0) {
+		int amount = ((sndn + sndn2 > VTRX_BLOCK_SIZE) ? VTRX_BLOCK_SIZE : sndn + sndn2);
+		/* the part of the block in the first buffer */
+		int first = amount < sndn ? amount : sndn;
+		double start;
+		if (votrax_process(amount, temp_votrax_buffer, &start)) {
+			mix_range(sndbuffer, start, 0, first);
+			mix_range(sndbuffer2, start, first, amount);
+		}
+		sndbuffer = (char *) sndbuffer + first*frame_bytes;
+		sndn -= first;
+		if (amount > first) {
+			sndbuffer2 = (char *) sndbuffer2 + (amount - first)*frame_bytes;
+			sndn2 -= amount - first;
+		}
 	}
 }
 
@@ -8,6 +8,10 @@ void VOTRAXSND_PutByte(UBYTE byte);
 void VOTRAXSND_Init(int playback_freq, int n_pokeys, int b16);
 void VOTRAXSND_Frame(void);
 void VOTRAXSND_Process(void *sndbuffer, int sndn);
+/* Mixes the speech into SNDN samples at SNDBUFFER followed by SNDN2 samples
+   at SNDBUFFER2, e.g. the two parts of a span of a ring buffer that wraps
+   around. The result is the same as for one buffer of SNDN + SNDN2 samples. */
+void VOTRAXSND_Process2(void *sndbuffer, int sndn, void *sndbuffer2, int sndn2);
 extern int VOTRAXSND_busy;
 void VOTRAXSND_Reinit(void);
 void VOTRAXSND_ModifyRatio(double factor);
@@ -178,6 +178,19 @@ static UBYTE const output_mask[2] = {0x01,0x10};
 
 UBYTE XEP80_screen_1[XEP80_SCRN_WIDTH*XEP80_MAX_SCRN_HEIGHT];
 UBYTE XEP80_screen_2[XEP80_SCRN_WIDTH*XEP80_MAX_SCRN_HEIGHT];
+UBYTE XEP80_scanline_dirty[XEP80_MAX_SCRN_HEIGHT];
+
+/* What BlitChar last drew in each character cell of the screen: the character
+   code, plus CELL_CURSOR for the cursor. Redrawing a cell with the same value
+   is skipped, so scrolling or redrawing the whole screen only rasterises
+   the cells that actually change. */
+#define CELL_CURSOR 0x100
+#define CELL_NONE 0xffff
+static UWORD drawn_cells[XEP80_HEIGHT][XEP80_LINE_LEN];
+/* The settings that drawn_cells were drawn with. */
+#define CELL_SETTINGS_SIZE 10
+static int cell_settings[CELL_SETTINGS_SIZE];
+static int drawn_cells_valid = FALSE;
 
 UBYTE (*font)[XEP80_FONTS_CHAR_COUNT][XEP80_MAX_CHAR_HEIGHT][XEP80_CHAR_WIDTH];
 
@@ -199,6 +212,32 @@ static void UpdateTVSystem(void)
    Functions for blitting display buffer.
    -------------------------------------- */
 
+/* Returns FALSE if drawn_cells cannot be used, because a character depends on
+   its neighbours when double-width characters are on. Empties drawn_cells
+   if any setting that affects all characters has changed. */
+static int UpdateDrawnCells(void)
+{
+	int settings[CELL_SETTINGS_SIZE];
+	if (font_a_double || font_b_double)
+		return FALSE;
+	settings[0] = attrib_a;
+	settings[1] = attrib_b;
+	settings[2] = inverse_mode;
+	settings[3] = char_set;
+	settings[4] = blink_reverse;
+	settings[5] = cursor_blink;
+	settings[6] = cursor_overwrite;
+	settings[7] = XEP80_char_height;
+	settings[8] = XEP80_FONTS_oncolor;
+	settings[9] = XEP80_FONTS_offcolor;
+	if (!drawn_cells_valid || memcmp(settings, cell_settings, sizeof(settings)) != 0) {
+		memcpy(cell_settings, settings, sizeof(settings));
+		memset(drawn_cells, 0xff, sizeof(drawn_cells));
+		drawn_cells_valid = TRUE;
+	}
+	return TRUE;
+}
+
 static void BlitChar(int x, int y, int cur)
 {
 	int screen_col;
@@ -217,6 +256,14 @@ static void BlitChar(int x, int y, int cur)
 	screen_col = x-xscroll;
 	ch = char_data(y, x);
 
+	if (UpdateDrawnCells()) {
+		UWORD cell = cur ? ch | CELL_CURSOR : ch;
+		if (drawn_cells[y][screen_col] == cell)
+			return;
+		drawn_cells[y][screen_col] = cell;
+	}
+	memset(XEP80_scanline_dirty + XEP80_char_height * y, 1, XEP80_char_height);
+
 	/* Dispaly Atari EOL's as spaces */
 	if (ch == XEP80_ATARI_EOL && ((font_a_index & XEP80_FONTS_BLK_FONT_BIT) == 0)
 	    && char_set != CHAR_SET_INTERNAL)
@@ -570,6 +617,9 @@ static void BlitGraphChar(int x, int y)
 	}
 
 	ch = graph_data(y, x);
+	/* the character cells get overwritten */
+	drawn_cells_valid = FALSE;
+	XEP80_scanline_dirty[y + GRAPH_Y_OFFSET] = 1;
 
 	to1 = &XEP80_screen_1[XEP80_SCRN_WIDTH * (y + GRAPH_Y_OFFSET)
 	                      + x * 8 + GRAPH_X_OFFSET];
@@ -594,6 +644,7 @@ static void BlitGraphScreen(void)
 
 	memset(XEP80_screen_1, XEP80_FONTS_offcolor, XEP80_SCRN_WIDTH*XEP80_MAX_SCRN_HEIGHT);
 	memset(XEP80_screen_2, XEP80_FONTS_offcolor, XEP80_SCRN_WIDTH*XEP80_MAX_SCRN_HEIGHT);
+	memset(XEP80_scanline_dirty, 1, XEP80_MAX_SCRN_HEIGHT);
 	for (x=0; x<XEP80_GRAPH_WIDTH/8; x++)
 		for (y=0; y<XEP80_GRAPH_HEIGHT; y++)
 			BlitGraphChar(x,y);
@@ -44,6 +44,11 @@ extern int XEP80_port;
 extern UBYTE XEP80_screen_1[XEP80_SCRN_WIDTH*XEP80_MAX_SCRN_HEIGHT];
 extern UBYTE XEP80_screen_2[XEP80_SCRN_WIDTH*XEP80_MAX_SCRN_HEIGHT];
 
+/* One entry for each line of XEP80_screen_1 and XEP80_screen_2, set to 1
+   when the line is redrawn. Platform code that displays only the changed
+   lines clears the entries after displaying the screen. */
+extern UBYTE XEP80_scanline_dirty[XEP80_MAX_SCRN_HEIGHT];
+
 UBYTE XEP80_GetBit(void);
 void XEP80_PutBit(UBYTE byte);
 void XEP80_ChangeColors(void);
@@ -0,0 +1,397 @@
+/*
+ * diskimg.c - batch conversion and verification of Atari disk images
+ *
+ * Copyright (C) 2013 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Uses the same image parsing code as the emulator (src/img_disk.c), so
+ * anything this tool accepts is mounted identically by atari800.
+ * Build it with "make diskimg" in the src directory after running configure.
+ *
+ * Usage: diskimg [options] command file...
+ *
+ *   info   prints type and geometry of each image
+ *   check  reads every sector and reports bad, missing or truncated ones
+ *   crc    prints CRC32 of the logical disk contents; the value does not
+ *          depend on the image format, so an XFD, a DCM and an ATR of the
+ *          same disk give the same CRC
+ *   atr    converts each image to an uncompressed ATR with logical boot
+ *          sectors - the fastest layout for SIO_Mount()
+ *   xfd    converts each image to XFD
+ *
+ * Images are processed by several worker processes in parallel (-j).
+ */
+
+#define _POSIX_C_SOURCE 200112L /* for fork, waitpid */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(HAVE_UNISTD_H) && !defined(WIN32)
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#define HAVE_WORKERS
+#endif
+
+#include "afile.h"
+#include "atari.h"
+#include "crc32.h"
+#include "img_disk.h"
+#include "util.h"
+
+#define COMMAND_INFO  0
+#define COMMAND_CHECK 1
+#define COMMAND_CRC   2
+#define COMMAND_ATR   3
+#define COMMAND_XFD   4
+
+static int command;
+static const char *output_dir = NULL;
+static int force = FALSE;
+
+static const char * const type_names[] = { "XFD", "ATR", "PRO", "ATX" };
+
+Util_tmpbufdef(static, tmpbuf)
+
+/* util.c calls this when out of memory. */
+void Atari800_ErrExit(void)
+{
+	exit(1);
+}
+
+/* Opens an image, uncompressing it if necessary, and parses its header.
+   Stores a description of the source format in *FORMAT.
+   Returns the stream on success or NULL on error. */
+static FILE *OpenImage(const char *filename, IMG_DISK_Info *info, const char **format)
+{
+	FILE *f;
+	struct AFILE_ATR_Header header;
+
+	f = Util_fopen(filename, "rb", tmpbuf);
+	if (f == NULL) {
+		printf("%s: cannot open\n", filename);
+		return NULL;
+	}
+	if (fread(&header, 1, sizeof(header), f) != sizeof(header)) {
+		printf("%s: file too short\n", filename);
+		fclose(f);
+		return NULL;
+	}
+	*format = NULL;
+	if (IMG_DISK_IsCompressed(&header)) {
+		FILE *f2 = Util_tmpopen(tmpbuf);
+		*format = header.magic1 == 0x1f ? "GZ" : "DCM";
+		if (f2 == NULL) {
+			printf("%s: cannot create temporary file\n", filename);
+			fclose(f);
+			return NULL;
+		}
+		if (!IMG_DISK_Uncompress(f, filename, f2)) {
+			printf("%s: cannot uncompress %s image\n", filename, *format);
+			Util_fclose(f2, tmpbuf);
+			fclose(f);
+			return NULL;
+		}
+		fclose(f);
+		f = f2;
+		Util_rewind(f);
+		if (fread(&header, 1, sizeof(header), f) != sizeof(header)) {
+			printf("%s: uncompressed image too short\n", filename);
+			Util_fclose(f, tmpbuf);
+			return NULL;
+		}
+	}
+	if (!IMG_DISK_ParseHeader(f, &header, info) || info->sectorcount <= 0) {
+		printf("%s: not a valid disk image\n", filename);
+		Util_fclose(f, tmpbuf);
+		return NULL;
+	}
+	if (*format == NULL)
+		*format = type_names[info->type];
+	return f;
+}
+
+/* Returns the expected length of an ATR or XFD file described by INFO. */
+static ULONG ExpectedLength(IMG_DISK_Info const *info)
+{
+	int size;
+	ULONG offset;
+	IMG_DISK_SizeOfSector(info, info->sectorcount, &size, &offset);
+	return offset + size;
+}
+
+/* Returns TRUE if EXT is the extension of a disk image that can be read. */
+static int IsImageExtension(const char *ext)
+{
+	static const char * const image_exts[] = {
+		"atr", "xfd", "dcm", "atz", "xfz", "pro", "atx", "gz"
+	};
+	int i;
+	for (i = 0; i < (int) (sizeof(image_exts) / sizeof(image_exts[0])); i++)
+		if (Util_stricmp(ext, image_exts[i]) == 0)
+			return TRUE;
+	return FALSE;
+}
+
+/* Builds the output file name: OUTPUT_DIR (or the directory of FILENAME),
+   the file name without its image extensions and EXT. */
+static void OutputName(char *result, const char *filename, const char *ext)
+{
+	char dir_part[FILENAME_MAX];
+	char file_part[FILENAME_MAX];
+	char *p;
+	Util_splitpath(filename, dir_part, file_part);
+	/* strip only the extensions of images, e.g. of "game.side1.atr.gz" */
+	while ((p = strrchr(file_part, '.')) != NULL && IsImageExtension(p + 1))
+		*p = '\0';
+	if (strlen(file_part) + strlen(ext) + 1 >= FILENAME_MAX)
+		file_part[FILENAME_MAX - strlen(ext) - 2] = '\0';
+	strcat(file_part, ext);
+	Util_catpath(result, output_dir != NULL ? output_dir : dir_part, file_part);
+}
+
+/* Processes a single image. Returns TRUE on success. */
+static int ProcessImage(const char *filename)
+{
+	IMG_DISK_Info info;
+	const char *format;
+	FILE *f;
+	FILE *out = NULL;
+	char outname[FILENAME_MAX];
+	char tmpname[FILENAME_MAX + 4];
+	ULONG crc = 0xffffffff;
+	int bad = 0;
+	int missing = 0;
+	int sector;
+	int result = TRUE;
+
+	f = OpenImage(filename, &info, &format);
+	if (f == NULL)
+		return FALSE;
+
+	if (command == COMMAND_INFO) {
+		static const char * const boot_names[] = { "logical", "physical", "SIO2PC" };
+		printf("%s: %s, %d sectors of %d bytes, %s boot sectors%s\n",
+		       filename, format, info.sectorcount, info.sectorsize,
+		       boot_names[info.boot_sectors_type],
+		       info.writeprotect ? ", write-protected" : "");
+		IMG_DISK_FreeInfo(&info);
+		Util_fclose(f, tmpbuf);
+		return TRUE;
+	}
+
+	if (command == COMMAND_ATR || command == COMMAND_XFD) {
+		OutputName(outname, filename, command == COMMAND_ATR ? ".atr" : ".xfd");
+		/* write to a temporary name, so that an image can be normalised in place */
+		strcpy(tmpname, outname);
+		strcat(tmpname, ".tmp");
+		out = fopen(tmpname, "wb");
+		if (out == NULL) {
+			printf("%s: cannot create %s\n", filename, tmpname);
+			IMG_DISK_FreeInfo(&info);
+			Util_fclose(f, tmpbuf);
+			return FALSE;
+		}
+		if (command == COMMAND_ATR
+		    && !IMG_DISK_WriteATRHeader(out, info.sectorsize, info.sectorcount, 128))
+			result = FALSE;
+	}
+
+	for (sector = 1; result && sector <= info.sectorcount; sector++) {
+		UBYTE buffer[256];
+		int size;
+		IMG_DISK_SizeOfSector(&info, sector, &size, NULL);
+		switch (IMG_DISK_ReadSector(f, &info, sector, buffer)) {
+		case IMG_DISK_SECTOR_OK:
+			break;
+		case IMG_DISK_SECTOR_BAD:
+			bad++;
+			break;
+		case IMG_DISK_SECTOR_MISSING:
+			missing++;
+			memset(buffer, 0, size);
+			break;
+		default:
+			printf("%s: cannot read sector %d\n", filename, sector);
+			result = FALSE;
+			continue;
+		}
+		crc = CRC32_Update(crc, buffer, size);
+		if (out != NULL && (int) fwrite(buffer, 1, size, out) != size) {
+			printf("%s: write error\n", filename);
+			result = FALSE;
+		}
+	}
+
+	if (result && (bad != 0 || missing != 0)) {
+		printf("%s: %d bad and %d missing sectors\n", filename, bad, missing);
+		/* copy protection is lost in an ATR or XFD */
+		if (command == COMMAND_CHECK || (out != NULL && !force))
+			result = FALSE;
+	}
+	if (result && command == COMMAND_CHECK
+	    && (info.type == IMG_DISK_TYPE_ATR || info.type == IMG_DISK_TYPE_XFD)) {
+		ULONG length = (ULONG) Util_flen(f);
+		if (length != ExpectedLength(&info))
+			printf("%s: warning: %lu trailing bytes\n", filename,
+			       (unsigned long) (length - ExpectedLength(&info)));
+	}
+
+	if (out != NULL) {
+		if (fclose(out) != 0)
+			result = FALSE;
+		if (result) {
+			Util_unlink(outname);
+			if (rename(tmpname, outname) != 0) {
+				printf("%s: cannot rename %s\n", filename, tmpname);
+				result = FALSE;
+			}
+		}
+		if (!result)
+			Util_unlink(tmpname);
+		else
+			printf("%s: %s -> %s\n", filename, format, outname);
+	}
+	else if (command == COMMAND_CRC && result)
+		printf("%08lx %5d %3d %s\n", (unsigned long) (crc ^ 0xffffffff),
+		       info.sectorcount, info.sectorsize, filename);
+	else if (command == COMMAND_CHECK && result)
+		printf("%s: OK\n", filename);
+
+	IMG_DISK_FreeInfo(&info);
+	Util_fclose(f, tmpbuf);
+	return result;
+}
+
+/* Processes every JOBS-th file starting at FIRST.
+   Returns the number of failed images. */
+static int ProcessFiles(char *files[], int count, int first, int jobs)
+{
+	int failed = 0;
+	int i;
+	for (i = first; i < count; i += jobs)
+		if (!ProcessImage(files[i]))
+			failed++;
+	return failed;
+}
+
+static void Usage(const char *progname)
+{
+	printf("Usage: %s [options] info|check|crc|atr|xfd file...\n"
+	       "  info     Print type and geometry of the images\n"
+	       "  check    Read all sectors, report bad/missing sectors and truncated files\n"
+	       "  crc      Print CRC32 of the logical disk contents\n"
+	       "  atr      Convert the images to uncompressed ATR\n"
+	       "  xfd      Convert the images to XFD\n"
+	       "Options:\n"
+#ifdef HAVE_WORKERS
+	       "  -j <n>   Run <n> worker processes in parallel\n"
+#endif
+	       "  -o <dir> Write converted images to <dir>\n"
+	       "  -f       Convert even if bad or missing sectors are lost\n",
+	       progname);
+}
+
+int main(int argc, char *argv[])
+{
+	int jobs = 1;
+	int failed = 0;
+	int count;
+	int i;
+	clock_t start;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			jobs = Util_sscandec(argv[++i]);
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			output_dir = argv[++i];
+		else if (strcmp(argv[i], "-f") == 0)
+			force = TRUE;
+		else {
+			Usage(argv[0]);
+			return 2;
+		}
+	}
+	if (i + 1 >= argc || jobs <= 0) {
+		Usage(argv[0]);
+		return 2;
+	}
+	if (strcmp(argv[i], "info") == 0)
+		command = COMMAND_INFO;
+	else if (strcmp(argv[i], "check") == 0)
+		command = COMMAND_CHECK;
+	else if (strcmp(argv[i], "crc") == 0)
+		command = COMMAND_CRC;
+	else if (strcmp(argv[i], "atr") == 0)
+		command = COMMAND_ATR;
+	else if (strcmp(argv[i], "xfd") == 0)
+		command = COMMAND_XFD;
+	else {
+		Usage(argv[0]);
+		return 2;
+	}
+	argv += i + 1;
+	count = argc - i - 1;
+	if (jobs > count)
+		jobs = count;
+
+	/* one line per write, so that output of the workers doesn't mix */
+	setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+	start = clock();
+
+#ifdef HAVE_WORKERS
+	if (jobs > 1) {
+		int j;
+		fflush(stdout);
+		for (j = 0; j < jobs; j++) {
+			pid_t pid = fork();
+			if (pid == 0) {
+				int n = ProcessFiles(argv, count, j, jobs);
+				fflush(stdout);
+				_exit(n > 255 ? 255 : n);
+			}
+			if (pid < 0) {
+				/* do the rest here */
+				failed += ProcessFiles(argv, count, j, jobs);
+			}
+		}
+		for (;;) {
+			int status;
+			pid_t pid = wait(&status);
+			if (pid < 0)
+				break;
+			if (WIFEXITED(status))
+				failed += WEXITSTATUS(status);
+			else
+				failed++;
+		}
+	}
+	else
+#endif
+		failed = ProcessFiles(argv, count, 0, 1);
+
+	fprintf(stderr, "%d images, %d failed, %.2f s CPU in main process\n",
+	        count, failed, (double) (clock() - start) / CLOCKS_PER_SEC);
+	return failed != 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * palblendtest.c - checks the PAL blending blits against per-pixel blending
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * PAL_BLENDING_Blit32 and PAL_BLENDING_BlitScaled16/32 blend each source
+ * line once and scale the result. This program compares their output with
+ * the straightforward way, which blends every destination pixel from the
+ * source pixels under it (the way the blits worked before). Random screens
+ * and random palettes in RGB565, RGB555 and 32-bit formats are blitted at
+ * many sizes, with exact and fractional scaling and both field parities.
+ * The destination is compared in full, so writes outside the blitted area
+ * are found too.
+ * Build and run it with "make check-palblend" in the src directory after
+ * running configure. The exit status is 1 if any blit differs.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atari.h"
+#include "artifact.h"
+#include "colours.h"
+#include "colours_pal.h"
+#include "pal_blending.h"
+#include "platform.h"
+#include "screen.h"
+
+/* Destination width and height limits: four and three times the source */
+#define MAX_DEST_WIDTH (4 * Screen_WIDTH)
+#define MAX_DEST_HEIGHT (3 * Screen_HEIGHT)
+/* ULONGs past the end of each destination line that must stay untouched */
+#define GUARD 3
+
+/* Stand-ins for the parts of the emulator that pal_blending.c refers to.
+   PLATFORM_MapRGB() fills the palettes with random pixel values of the
+   current format and keeps a copy of them for the per-pixel blits. */
+ARTIFACT_t ARTIFACT_mode = ARTIFACT_PAL_BLEND;
+static PLATFORM_pixel_format_t format;
+static ULONG ref_palette[2][256];
+static int n_palettes = 0;
+
+void Atari800_ErrExit(void)
+{
+	exit(1);
+}
+
+void COLOURS_PAL_GetYUV(double yuv_table[256*5])
+{
+	memset(yuv_table, 0, 256 * 5 * sizeof(double));
+}
+
+void Colours_YUV2RGB(double y, double u, double v, double *r, double *g, double *b)
+{
+	*r = *g = *b = 0.0;
+}
+
+void Colours_SetRGB(int i, int r, int g, int b, int *colortable_ptr)
+{
+	colortable_ptr[i] = 0;
+}
+
+void PLATFORM_GetPixelFormat(PLATFORM_pixel_format_t *f)
+{
+	*f = format;
+}
+
+void PLATFORM_MapRGB(void *dest, int const *palette, int size)
+{
+	ULONG *ref = ref_palette[n_palettes++ & 1];
+	ULONG mask = format.rmask | format.gmask | format.bmask;
+	int i;
+	for (i = 0; i < size; i++) {
+		ref[i] = (((ULONG) rand() << 16) ^ (ULONG) rand()) & mask;
+		if (format.bpp == 16)
+			((UWORD *) dest)[i] = (UWORD) ref[i];
+		else
+			((ULONG *) dest)[i] = ref[i];
+	}
+}
+
+/* Averages two pixels of the current format with the same Y component */
+static ULONG Average(ULONG a, ULONG b)
+{
+	ULONG low_bits = (format.rmask & ~(format.rmask << 1)) | (format.gmask & ~(format.gmask << 1)) | (format.bmask & ~(format.bmask << 1));
+	return (a & b) + (((a ^ b) & ~low_bits) >> 1);
+}
+
+/* Returns the blended colour of source pixel X of line SRC, over line
+   SRC_PREV */
+static ULONG BlendPixel(const UBYTE *src, const UBYTE *src_prev, int x, int odd)
+{
+	UBYTE c = src[x];
+	return Average(ref_palette[odd][c], ref_palette[odd ^ 1][(src_prev[x] & 0xf0) | (c & 0x0f)]);
+}
+
+/* Blits like PAL_BLENDING_BlitScaled16/32 (or PAL_BLENDING_Blit32 if
+   DEST_WIDTH == 0), blending every destination pixel separately */
+static void RefBlit(ULONG *dest, const UBYTE *src, int pitch, int width, int height, int dest_width, int dest_height, int odd)
+{
+	const UBYTE *src_prev = src;
+	int y = 0x10000;
+	int dy;
+	int dx;
+	int pos;
+	if (dest_width == 0) {
+		for (; height > 0; height--) {
+			for (pos = 0; pos < width; pos++)
+				dest[pos] = BlendPixel(src, src_prev, pos, odd);
+			src_prev = src;
+			src += Screen_WIDTH;
+			dest += pitch;
+			odd ^= 1;
+		}
+		return;
+	}
+	dx = (width << 16) / dest_width;
+	dy = (height << 16) / dest_height;
+	for (; dest_height > 0; dest_height--) {
+		int x = (width << 16) - 0x4000;
+		if (format.bpp == 16) {
+			for (pos = dest_width / 2 - 1; pos >= 0; pos--) {
+				ULONG quad = BlendPixel(src, src_prev, x >> 16, odd) << 16;
+				x -= dx;
+				dest[pos] = quad | BlendPixel(src, src_prev, x >> 16, odd);
+				x -= dx;
+			}
+		}
+		else {
+			for (pos = dest_width - 1; pos >= 0; pos--) {
+				dest[pos] = BlendPixel(src, src_prev, x >> 16, odd);
+				x -= dx;
+			}
+		}
+		dest += pitch;
+		y -= dy;
+		if (y < 0) {
+			y += 0x10000;
+			src_prev = src;
+			src += Screen_WIDTH;
+			odd ^= 1;
+		}
+	}
+}
+
+static UBYTE screen[Screen_WIDTH * Screen_HEIGHT];
+static ULONG dest[MAX_DEST_HEIGHT * (MAX_DEST_WIDTH + GUARD)];
+static ULONG ref_dest[MAX_DEST_HEIGHT * (MAX_DEST_WIDTH + GUARD)];
+
+/* Blits WIDTH x HEIGHT pixels to DEST_WIDTH x DEST_HEIGHT (not scaled if
+   DEST_WIDTH == 0) with both methods and returns TRUE if they match. */
+static int TestBlit(int width, int height, int dest_width, int dest_height, int odd)
+{
+	int pitch = (dest_width == 0 ? width : format.bpp == 16 ? dest_width / 2 : dest_width) + GUARD;
+	size_t size = (dest_width == 0 ? height : dest_height) * pitch * sizeof(ULONG);
+	memset(dest, 0x55, size);
+	memset(ref_dest, 0x55, size);
+	RefBlit(ref_dest, screen, pitch, width, height, dest_width, dest_height, odd);
+	if (dest_width == 0)
+		PAL_BLENDING_Blit32(dest, screen, pitch, width, height, odd);
+	else if (format.bpp == 16)
+		PAL_BLENDING_BlitScaled16(dest, screen, pitch, width, height, dest_width, dest_height, odd);
+	else
+		PAL_BLENDING_BlitScaled32(dest, screen, pitch, width, height, dest_width, dest_height, odd);
+	if (memcmp(dest, ref_dest, size) == 0)
+		return TRUE;
+	printf("%d-bit blit of %dx%d to %dx%d, %s line first: FAILED\n", format.bpp,
+	       width, height, dest_width, dest_height, odd ? "odd" : "even");
+	return FALSE;
+}
+
+int main(void)
+{
+	static const PLATFORM_pixel_format_t formats[] = {
+		{ 16, 0xf800, 0x07e0, 0x001f },
+		{ 16, 0x7c00, 0x03e0, 0x001f },
+		{ 32, 0xff0000, 0x00ff00, 0x0000ff }
+	};
+	static const int widths[] = { 1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 33, 100, 101, 255, 320, 335, 336, 383, 384 };
+	static const int heights[] = { 1, 2, 3, 7, 61, 240 };
+	int n_formats = (int) (sizeof(formats) / sizeof(formats[0]));
+	int n_widths = (int) (sizeof(widths) / sizeof(widths[0]));
+	int n_heights = (int) (sizeof(heights) / sizeof(heights[0]));
+	int tests = 0;
+	int failed = 0;
+	int f;
+	int i;
+
+	srand(1);
+	for (i = 0; i < (int) sizeof(screen); i++)
+		screen[i] = (UBYTE) rand();
+	for (f = 0; f < n_formats; f++) {
+		int w;
+		format = formats[f];
+		PAL_BLENDING_UpdateLookup();
+		for (w = 0; w < n_widths; w++) {
+			int h;
+			for (h = 0; h < n_heights; h++) {
+				int width = widths[w];
+				int height = heights[h];
+				/* destination sizes: 1x, 2x, 3x, 4x3, 5/2x7/3, 3/4x1/2 */
+				int dest_sizes[6][2];
+				int s;
+				int odd;
+				dest_sizes[0][0] = width; dest_sizes[0][1] = height;
+				dest_sizes[1][0] = 2 * width; dest_sizes[1][1] = 2 * height;
+				dest_sizes[2][0] = 3 * width; dest_sizes[2][1] = 3 * height;
+				dest_sizes[3][0] = 4 * width; dest_sizes[3][1] = 3 * height;
+				dest_sizes[4][0] = width * 5 / 2 + 1; dest_sizes[4][1] = height * 7 / 3 + 1;
+				dest_sizes[5][0] = width * 3 / 4 + 1; dest_sizes[5][1] = height / 2 + 1;
+				for (odd = 0; odd <= 1; odd++) {
+					if (format.bpp == 32) {
+						tests++;
+						if (!TestBlit(width, height, 0, 0, odd))
+							failed++;
+					}
+					for (s = 0; s < 6; s++) {
+						tests++;
+						if (!TestBlit(width, height, dest_sizes[s][0], dest_sizes[s][1], odd))
+							failed++;
+					}
+				}
+			}
+		}
+	}
+	printf("%d blits, %d failed\n", tests, failed);
+	return failed ? 1 : 0;
+}
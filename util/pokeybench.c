@@ -3,7 +3,7 @@
  *  Atari800  Atari 800XL, etc. emulator                                     *
  *  ----------------------------------------------------------------------   *
  *  POKEY Chip Emulator,                                                     *
- *  "POKEYBENCH" Test and benchmark program for developers, V1.3             *
+ *  "POKEYBENCH" Test and benchmark program for developers, V1.7             *
  *  by Michael Borisov                                                       *
  *                                                                           *
  *****************************************************************************/
@@ -32,8 +32,48 @@
  *                                                                           *
  *****************************************************************************/
 
+/* Build from a configured source tree (one that has config.h), e.g.:
+   cd src && gcc -O2 -I. -o pokeybench ../util/pokeybench.c pokeysnd.c \
+   mzpokeysnd.c bleppokeysnd.c remez.c crc32.c util.c log.c -lm
+   Add -DSYNCHRONIZED_SOUND to also measure the synchronized output path
+   used by the SDL port (the band-limited engine is not available then).
+
+   Usage: pokeybench paramfile out8 out16 [rf|mz|blep [chips]]
+   The speed of each sound engine is measured with the registers from
+   paramfile, and the quality with a few pure tones. The output files are
+   written by the engine given last (default: mz). With 2 or 4 chips, the
+   speed is measured with all of them playing the same registers, mixed to
+   stereo (the rf engine plays only two of four).
+
+   Usage: pokeybench -replay logfile [hashfile]
+   Replays a log of POKEY register writes, recorded with the emulator's
+   -pokeylog option, through each sound engine at each of REPLAY_RATES,
+   and prints the speed and a CRC-32 of the 16-bit output. With hashfile,
+   the CRCs are compared with the ones stored in it, and the exit status is
+   1 if any of them differs or is missing. If hashfile does not exist, it is
+   created with the current CRCs, so a log and its hashfile make a
+   regression test for changes to the sound engines. "make pokeybench" in
+   src builds the program with the configured options. Some of them change
+   the output: CLIP_SOUND and INTERPOLATE_SOUND that of rf, NONLINEAR_MIXING
+   and SYNCHRONIZED_SOUND that of mz, STEREO_SOUND and VOL_ONLY_SOUND that
+   of all engines. Each CRC is stored under the engine name followed by the
+   options of these that are enabled (e.g. "mz+nonlinear+sync+stereo+volonly"),
+   so one hashfile can hold the CRCs of all configurations.
+   "make check-pokey" replays ../util/regress/pokey.log this way. */
+
+#include "config.h"
+#include "atari.h"
+#include "antic.h"
+#include "gtia.h"
+#include "pokey.h"
 #include "pokeysnd.h"
+#include "crc32.h"
 #include "mzpokeysnd.h"
+#include "bleppokeysnd.h"
+#include "sndsave.h"
+#include "avirec.h"
+#include "shmexport.h"
+#include "votraxsnd.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -54,6 +94,94 @@
 /* How many seconds of sound to save in the outfile */
 #define MZM_SAVE_TIME 10
 
+/* Volume gain, as SOUND_GAIN in pokey.c */
+#define PK_GAIN 4
+
+/* Sound engines */
+#define PK_RF 0
+#define PK_MZ 1
+#define PK_BLEP 2
+#ifdef SYNCHRONIZED_SOUND
+#define PK_ENGINES 2
+#else
+#define PK_ENGINES 3
+#endif
+static const char * const engine_names[3] = { "rf", "mz", "blep" };
+static int engine = PK_MZ;
+/* Number of chips in the speed test */
+static int chips = 1;
+
+/* Quality test: seconds skipped while the output settles, and analysed */
+#define Q_SETTLE_TIME 1
+#define Q_TIME 1
+
+/* Replay: sample rates, and the registers that are not sound registers */
+static const unsigned short REPLAY_RATES[] = { 22050, 44100, 48000 };
+#define REPLAY_NRATES ((int) (sizeof(REPLAY_RATES) / sizeof(REPLAY_RATES[0])))
+
+/* A write from a register log */
+typedef struct {
+    unsigned long cycles; /* since the previous write */
+    unsigned char chip;
+    unsigned char reg;
+    unsigned char val;
+} pkwrite;
+
+/* Stand-ins for the parts of the emulator that the sound code refers to */
+int ANTIC_xpos = 0;
+unsigned int ANTIC_screenline_cpu_clock = 0;
+#ifdef NEW_CYCLE_EXACT
+int ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
+const int *ANTIC_cpu2antic_ptr = NULL;
+#endif
+int GTIA_speaker = 0;
+UBYTE POKEY_AUDF[4 * POKEY_MAXPOKEYS];
+UBYTE POKEY_AUDC[4 * POKEY_MAXPOKEYS];
+UBYTE POKEY_AUDCTL[POKEY_MAXPOKEYS];
+int POKEY_Base_mult[POKEY_MAXPOKEYS];
+UBYTE POKEY_poly9_lookup[POKEY_POLY9_SIZE];
+UBYTE POKEY_poly17_lookup[16385];
+#ifdef SYNCHRONIZED_SOUND
+int ANTIC_ypos = 0;
+int Atari800_tv_mode = Atari800_TV_PAL;
+#endif
+
+void Atari800_ErrExit(void)
+{
+    exit(1);
+}
+
+int SndSave_WriteToSoundFile(const UBYTE *ucBuffer, unsigned int uiSize)
+{
+    return 0;
+}
+
+int SndSave_CloseSoundFile(void)
+{
+    return 1;
+}
+
+#ifdef AVI_RECORDING
+void AVIRec_Sound(const UBYTE *buffer, unsigned int size)
+{
+}
+#endif
+
+#ifdef SHM_EXPORT
+void SHMExport_Sound(const UBYTE *buffer, unsigned int size)
+{
+}
+#endif
+
+#if defined(PBI_XLD) || defined(VOICEBOX)
+void VOTRAXSND_Init(int playback_freq, int n_pokeys, int b16)
+{
+}
+
+void VOTRAXSND_Process(void *sndbuffer, int sndn)
+{
+}
+#endif
 
 /* Wrapper for fgets, removes trailing whitespace */
 char* fgetl(char* s, int len, FILE* fs)
@@ -64,52 +192,63 @@ char* fgetl(char* s, int len, FILE* fs)
     s2 = fgets(s,len,fs);
     if(s2 == NULL)
         return s2;
-    for(i=strlen(s)-1; i>=0; i--)
-        if(isspace(s[i]))
-            s[i] = '\0';
+    for(i=strlen(s)-1; i>=0 && isspace((unsigned char) s[i]); i--)
+        s[i] = '\0';
     return s2;
 }
 
-int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
-           const char* ofn8, const char* ofn16,
-           unsigned short samplerate)
+/* Initializes the sound engine with N chips and writes the tested
+   register values to all of them. More than one chip is stereo. */
+int pkinit(unsigned char *audf, unsigned char *audc, unsigned char audctl,
+           unsigned short samplerate, int flags, int n)
 {
-    unsigned char* buf;
-    short* buf16;
-    double rate;
-    double rasum;
-    double rasum2;
-    double varian;
-    double stddev;
-    unsigned long samremain, samproc;
     int i;
-    time_t start,finish;
-    FILE* ft;
+    int c;
 
-    buf = malloc(MZM_BUF_SAMPLES);
-    if(buf == NULL)
+    POKEYSND_enable_new_pokey = engine == PK_MZ;
+    POKEYSND_enable_blep_pokey = engine == PK_BLEP;
+    POKEYSND_stereo_enabled = n > 1;
+    POKEYSND_quad_enabled = n > 2;
+    if(i=POKEYSND_Init(POKEYSND_FREQ_17_EXACT,samplerate,n > 1 ? 2 : 1,flags))
     {
-        printf("Out of memory\n");
+        printf("Error initializing Pokey sound: %d\n",i);
         return 1;
     }
 
-    if(i=Pokey_sound_init(1790000,samplerate,1,0,1))
+    for(c=0; c<n; c++)
     {
-        printf("Error initializing Pokey sound: %d\n",i);
-        return 1;
+        /* pokeysnd.c reads the registers from pokey.c */
+        for(i=0; i<4; i++)
+        {
+            POKEY_AUDF[c*4 + i] = audf[i];
+            POKEY_AUDC[c*4 + i] = audc[i];
+        }
+        POKEY_AUDCTL[c] = audctl;
+        POKEY_Base_mult[c] = (audctl & POKEY_CLOCK_15) ? POKEY_DIV_15 : POKEY_DIV_64;
+
+        POKEYSND_Update(POKEY_OFFSET_AUDCTL,audctl,c,PK_GAIN);
+        for(i=0; i<4; i++)
+        {
+            POKEYSND_Update(POKEY_OFFSET_AUDF1 + i*2,audf[i],c,PK_GAIN);
+            POKEYSND_Update(POKEY_OFFSET_AUDC1 + i*2,audc[i],c,PK_GAIN);
+        }
     }
+    return 0;
+}
 
-    Update_pokey_sound(_AUDF1,audf[0],0,1);
-    Update_pokey_sound(_AUDC1,audc[0],0,1);
-    Update_pokey_sound(_AUDF2,audf[1],0,1);
-    Update_pokey_sound(_AUDC2,audc[1],0,1);
-    Update_pokey_sound(_AUDF3,audf[2],0,1);
-    Update_pokey_sound(_AUDC3,audc[2],0,1);
-    Update_pokey_sound(_AUDF4,audf[3],0,1);
-    Update_pokey_sound(_AUDC4,audc[3],0,1);
-    Update_pokey_sound(_AUDCTL,audctl,0,1);
-    Pokey_debugreset(0);
-    
+/* Generates sound for TEST_TRIALS trials and prints the rates.
+   With SYNC, the sound is generated a frame at a time through
+   MZPOKEYSND_UpdateProcessBuffer(). Returns the average rate. */
+double pkrate(int sync)
+{
+    unsigned char buf[MZM_BUF_SAMPLES];
+    double rate;
+    double rasum;
+    double rasum2;
+    double varian;
+    double stddev;
+    int i;
+    time_t start,finish;
 
     rasum = 0.0;
     rasum2 = 0.0;
@@ -129,8 +268,15 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
         /* Generate until test time elapses */
         do
         {
-            Pokey_process(buf,MZM_BUF_SAMPLES);
-            rate += MZM_BUF_SAMPLES;
+#ifdef SYNCHRONIZED_SOUND
+            if(sync)
+                rate += MZPOKEYSND_UpdateProcessBuffer();
+            else
+#endif
+            {
+                POKEYSND_Process(buf,MZM_BUF_SAMPLES);
+                rate += MZM_BUF_SAMPLES;
+            }
             time(&finish);
         } while(difftime(finish,start) < MZM_TRIAL_TIME);
 
@@ -150,26 +296,190 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
 
     printf("Standard deviation: %10.0f samples/sec\n",stddev);
 
-    printf("Gen/play ratio = %3.1f\n",rasum/TEST_TRIALS/samplerate);
+    return rasum/TEST_TRIALS;
+}
+
+/* Returns the power of frequency F (in cycles per sample) in X.
+   With REMOVE, also subtracts that frequency from X. */
+static double pkpower(double *x, unsigned long n, double f, int remove)
+{
+    double w = 2.0*3.14159265358979323846*f;
+    double a = 0.0;
+    double b = 0.0;
+    unsigned long i;
+    for(i=0; i<n; i++)
+    {
+        a += x[i]*cos(w*i);
+        b += x[i]*sin(w*i);
+    }
+    if(remove)
+        for(i=0; i<n; i++)
+            x[i] -= 2.0*(a*cos(w*i) + b*sin(w*i))/n;
+    return 2.0*(a*a + b*b)/n;
+}
+
+/* Plays a pure tone on channel 1 and fits DC and the tone's harmonics
+   below 0.45 * samplerate to the 16-bit output. Everything else is aliasing
+   or noise; returns the ratio of the fitted signal to it in dB.
+   The engines may play the tone slightly out of tune, so the frequency is
+   looked for within 3% of the ideal one and returned in *FREQ. */
+double pkquality(unsigned char audf1, unsigned char audctl,
+                 unsigned short samplerate, double *freq)
+{
+    static short buf[MZM_BUF_SAMPLES];
+    static unsigned char audf[4];
+    static unsigned char audc[4] = { 0xaf, 0, 0, 0 };
+    double *x;
+    double f0;
+    double step;
+    double best;
+    double mean = 0.0;
+    double total = 0.0;
+    double residual = 0.0;
+    unsigned long n = (unsigned long) samplerate * Q_TIME;
+    unsigned long skip = (unsigned long) samplerate * Q_SETTLE_TIME;
+    unsigned long i;
+    int h;
+
+    *freq = 0.0;
+    audf[0] = audf1;
+    if(pkinit(audf,audc,audctl,samplerate,POKEYSND_BIT16,1))
+        return 0.0;
+    x = malloc(n * sizeof(double));
+    if(x == NULL)
+        return 0.0;
+    for(i=0; i<skip+n; i+=MZM_BUF_SAMPLES)
+    {
+        unsigned long j;
+        POKEYSND_Process(buf,MZM_BUF_SAMPLES);
+        for(j=0; j<MZM_BUF_SAMPLES; j++)
+            if(i+j >= skip && i+j < skip+n)
+                x[i+j-skip] = buf[j];
+    }
+
+    /* a pure tone toggles its output on each counter underflow */
+    if(audctl & POKEY_CH1_179)
+        f0 = POKEYSND_FREQ_17_EXACT / (2.0 * (audf1 + 4));
+    else
+        f0 = POKEYSND_FREQ_17_EXACT / (2.0 * (audf1 + 1) * POKEY_DIV_64);
+
+    for(i=0; i<n; i++)
+        mean += x[i];
+    mean /= n;
+    for(i=0; i<n; i++)
+    {
+        x[i] -= mean;
+        total += x[i]*x[i];
+    }
+    f0 /= samplerate;
+    /* search for the strongest fundamental in steps of 0.1%, then refine
+       the step twice */
+    best = f0;
+    step = 0.001*f0;
+    for(h=0; h<3; h++)
+    {
+        double centre = best;
+        double maxpower = -1.0;
+        int span = h == 0 ? 30 : 10;
+        int k;
+        for(k=-span; k<=span; k++)
+        {
+            double p = pkpower(x,n,centre + k*step,FALSE);
+            if(p > maxpower)
+            {
+                maxpower = p;
+                best = centre + k*step;
+            }
+        }
+        step /= 10.0;
+    }
+    f0 = best;
+    *freq = f0*samplerate;
+    /* the harmonics are far enough apart to be fitted one at a time */
+    for(h=1; h*f0 < 0.45; h++)
+        pkpower(x,n,h*f0,TRUE);
+    for(i=0; i<n; i++)
+        residual += x[i]*x[i];
+    free(x);
+    return 10.0*log10((total - residual)/residual);
+}
+
+int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
+           const char* ofn8, const char* ofn16,
+           unsigned short samplerate)
+{
+    unsigned char* buf;
+    short* buf16;
+    unsigned long samremain, samproc;
+    int i;
+    FILE* ft;
+    static const unsigned char tones[][2] = {
+        { 0x40, 0 }, { 0x10, 0 }, { 0x80, POKEY_CH1_179 }, { 0x30, POKEY_CH1_179 }
+    };
+    int out_engine = engine;
+
+    buf = malloc(MZM_BUF_SAMPLES);
+    if(buf == NULL)
+    {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    for(engine=0; engine<PK_ENGINES; engine++)
+    {
+        printf("\nEngine %s, %d chip%s:\n", engine_names[engine], chips, chips > 1 ? "s" : "");
+        if(pkinit(audf,audc,audctl,samplerate,0,chips))
+        {
+            free(buf);
+            return 1;
+        }
+        printf("Gen/play ratio = %3.1f\n",pkrate(FALSE)/samplerate/POKEYSND_num_pokeys);
+
+#ifdef SYNCHRONIZED_SOUND
+        if(engine == PK_MZ)
+        {
+            printf("\nSynchronized sound (whole frames):\n");
+            if(pkinit(audf,audc,audctl,samplerate,0,chips))
+            {
+                free(buf);
+                return 1;
+            }
+            printf("Gen/play ratio = %3.1f\n",pkrate(TRUE)/samplerate/POKEYSND_num_pokeys);
+        }
+#endif
+    }
+
+    printf("\nSignal to alias and noise ratio of pure tones, in dB:\n");
+    printf("(and the frequency played, in Hz)\n");
+    printf("AUDF AUDCTL   Freq");
+    for(engine=0; engine<PK_ENGINES; engine++)
+        printf("%17s", engine_names[engine]);
+    printf("\n");
+    for(i=0; i<(int) (sizeof(tones)/sizeof(tones[0])); i++)
+    {
+        double f0 = tones[i][1] & POKEY_CH1_179
+            ? POKEYSND_FREQ_17_EXACT / (2.0 * (tones[i][0] + 4))
+            : POKEYSND_FREQ_17_EXACT / (2.0 * (tones[i][0] + 1) * POKEY_DIV_64);
+        printf(" $%02X   $%02X  %7.1f",tones[i][0],tones[i][1],f0);
+        for(engine=0; engine<PK_ENGINES; engine++)
+        {
+            double freq;
+            double q = pkquality(tones[i][0],tones[i][1],samplerate,&freq);
+            printf("%7.1f (%7.1f)",q,freq);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    engine = out_engine;
+    printf("\nWriting the output files with engine %s\n", engine_names[engine]);
 
     /* And now, write 8-bit output file */
 
-    if(i=Pokey_sound_init(1790000,samplerate,1,0,1))
+    if(pkinit(audf,audc,audctl,samplerate,0,1))
     {
-        printf("Error initializing Pokey sound: %d\n",i);
         free(buf);
         return 1;
     }
-    Update_pokey_sound(_AUDF1,audf[0],0,1);
-    Update_pokey_sound(_AUDC1,audc[0],0,1);
-    Update_pokey_sound(_AUDF2,audf[1],0,1);
-    Update_pokey_sound(_AUDC2,audc[1],0,1);
-    Update_pokey_sound(_AUDF3,audf[2],0,1);
-    Update_pokey_sound(_AUDC3,audc[2],0,1);
-    Update_pokey_sound(_AUDF4,audf[3],0,1);
-    Update_pokey_sound(_AUDC4,audc[3],0,1);
-    Update_pokey_sound(_AUDCTL,audctl,0,1);
-    Pokey_debugreset(0);
 
     if(!(ft=fopen(ofn8,"wb")))
     {
@@ -189,7 +499,7 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
         {
             samproc = samremain;
         }
-        Pokey_process(buf,(unsigned short)samproc);
+        POKEYSND_Process(buf,(unsigned short)samproc);
         i = fwrite(buf,1,samproc,ft);
         if(i<samproc)
         {
@@ -206,22 +516,8 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
 
     /* Write 16-bit output file */
 
-    if(i=Pokey_sound_init(1790000,samplerate,1,SND_BIT16,1))
-    {
-        printf("Error initializing Pokey sound: %d\n",i);
+    if(pkinit(audf,audc,audctl,samplerate,POKEYSND_BIT16,1))
         return 1;
-    }
-    Update_pokey_sound(_AUDF1,audf[0],0,1);
-    Update_pokey_sound(_AUDC1,audc[0],0,1);
-    Update_pokey_sound(_AUDF2,audf[1],0,1);
-    Update_pokey_sound(_AUDC2,audc[1],0,1);
-    Update_pokey_sound(_AUDF3,audf[2],0,1);
-    Update_pokey_sound(_AUDC3,audc[2],0,1);
-    Update_pokey_sound(_AUDF4,audf[3],0,1);
-    Update_pokey_sound(_AUDC4,audc[3],0,1);
-    Update_pokey_sound(_AUDCTL,audctl,0,1);
-    Pokey_debugreset(0);
-
 
     buf16 = malloc(2*MZM_BUF_SAMPLES);
     if(buf16 == NULL)
@@ -248,7 +544,7 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
         {
             samproc = samremain;
         }
-        Pokey_process(buf16,(unsigned short)samproc);
+        POKEYSND_Process(buf16,(unsigned short)samproc);
         i = fwrite(buf16,2,samproc,ft);
         if(i<samproc)
         {
@@ -266,6 +562,283 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
     return 0;
 }
 
+/* Reads a log written by POKEYSND_OpenLog(). Returns the number of
+   writes, stores them at *WRITES, the cycles after the last write at *TAIL
+   and the number of chips used at *NCHIPS. Returns -1 on error. */
+static long pkreadlog(const char *fn, pkwrite **writes, unsigned long *tail,
+                      int *nchips)
+{
+    char line[256];
+    FILE *fs;
+    pkwrite *w = NULL;
+    long n = 0;
+    long size = 0;
+    int ended = FALSE;
+
+    if(!(fs = fopen(fn,"r")))
+    {
+        perror(fn);
+        return -1;
+    }
+    *nchips = 1;
+    while(fgetl(line,sizeof(line),fs) != NULL)
+    {
+        unsigned long cycles;
+        unsigned int chip, reg, val;
+        int fields;
+
+        if(line[0] == '#' || line[0] == '\0')
+            continue;
+        fields = sscanf(line,"%lu %u %x %x",&cycles,&chip,&reg,&val);
+        if(ended || (fields != 1 && fields != 4)
+           || (fields == 4 && (chip >= POKEY_MAXPOKEYS || reg > 0x0f || val > 0xff)))
+        {
+            printf("%s: Error in file format: %s\n", fn, line);
+            free(w);
+            fclose(fs);
+            return -1;
+        }
+        if(fields == 1)
+        {
+            *tail = cycles;
+            ended = TRUE;
+            continue;
+        }
+        if(n == size)
+        {
+            pkwrite *w2;
+            size = size ? 2*size : 4096;
+            w2 = realloc(w, size*sizeof(pkwrite));
+            if(w2 == NULL)
+            {
+                printf("Out of memory\n");
+                free(w);
+                fclose(fs);
+                return -1;
+            }
+            w = w2;
+        }
+        w[n].cycles = cycles;
+        w[n].chip = (unsigned char) chip;
+        w[n].reg = (unsigned char) reg;
+        w[n].val = (unsigned char) val;
+        if(chip >= (unsigned int) *nchips)
+            *nchips = chip >= 2 ? 4 : 2;
+        n++;
+    }
+    fclose(fs);
+    if(!ended)
+    {
+        printf("%s: Unexpected end of file\n", fn);
+        free(w);
+        return -1;
+    }
+    *writes = w;
+    return n;
+}
+
+/* Generates the 16-bit output up to sample frame END, adding it to the CRC */
+static void pkreplayto(unsigned long end, unsigned long *done, ULONG *crc)
+{
+    static short buf[MZM_BUF_SAMPLES * 2];
+    UBYTE bytes[MZM_BUF_SAMPLES * 4];
+    int channels = POKEYSND_num_pokeys;
+
+    while(*done < end)
+    {
+        unsigned long n = end - *done;
+        unsigned long i;
+        if(n > MZM_BUF_SAMPLES)
+            n = MZM_BUF_SAMPLES;
+        POKEYSND_Process(buf,(int) n*channels);
+        /* the CRC is of little-endian samples on all hosts */
+        for(i=0; i<n*channels; i++)
+        {
+            bytes[2*i] = (UBYTE) buf[i];
+            bytes[2*i+1] = (UBYTE) (buf[i] >> 8);
+        }
+        *crc = CRC32_Update(*crc,bytes,(unsigned int) (2*n*channels));
+        *done += n;
+    }
+}
+
+/* Replays N WRITES and TAIL cycles at SAMPLERATE with the current engine.
+   Returns the CRC-32 of the output and stores the speed at *RATE. */
+static ULONG pkreplay(const pkwrite *writes, long n, unsigned long tail, int nchips,
+                      unsigned short samplerate, double *rate)
+{
+    static unsigned char zero[4];
+    double cycle = 0.0;
+    double seconds;
+    unsigned long done = 0;
+    ULONG crc = 0xffffffff;
+    clock_t start;
+    long i;
+
+    if(pkinit(zero,zero,0,samplerate,POKEYSND_BIT16,nchips))
+        exit(1);
+    start = clock();
+    for(i=0; i<n; i++)
+    {
+        const pkwrite *w = &writes[i];
+        cycle += w->cycles;
+        pkreplayto((unsigned long) (cycle * samplerate / POKEYSND_FREQ_17_EXACT),&done,&crc);
+        /* pokeysnd.c reads the registers from pokey.c */
+        if(w->reg <= POKEY_OFFSET_AUDC4)
+        {
+            if(w->reg & 1)
+                POKEY_AUDC[w->chip*4 + (w->reg >> 1)] = w->val;
+            else
+                POKEY_AUDF[w->chip*4 + (w->reg >> 1)] = w->val;
+        }
+        else if(w->reg == POKEY_OFFSET_AUDCTL)
+        {
+            POKEY_AUDCTL[w->chip] = w->val;
+            POKEY_Base_mult[w->chip] = (w->val & POKEY_CLOCK_15) ? POKEY_DIV_15 : POKEY_DIV_64;
+        }
+        POKEYSND_Update(w->reg,w->val,w->chip,PK_GAIN);
+    }
+    cycle += tail;
+    pkreplayto((unsigned long) (cycle * samplerate / POKEYSND_FREQ_17_EXACT),&done,&crc);
+    seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    *rate = seconds > 0.0 ? done / seconds : 0.0;
+    return crc ^ 0xffffffff;
+}
+
+/* Returns the name under which the replay CRCs of engine ENG are stored:
+   the engine name followed by the enabled build options that change its
+   output */
+static const char *pkcasename(int eng)
+{
+    static char name[64];
+    strcpy(name,engine_names[eng]);
+    if(eng == PK_RF)
+    {
+#ifdef CLIP_SOUND
+        strcat(name,"+clip");
+#endif
+#ifdef INTERPOLATE_SOUND
+        strcat(name,"+interpolate");
+#endif
+    }
+    else if(eng == PK_MZ)
+    {
+#ifdef NONLINEAR_MIXING
+        strcat(name,"+nonlinear");
+#endif
+#ifdef SYNCHRONIZED_SOUND
+        strcat(name,"+sync");
+#endif
+    }
+#ifdef STEREO_SOUND
+    strcat(name,"+stereo");
+#endif
+#ifdef VOL_ONLY_SOUND
+    strcat(name,"+volonly");
+#endif
+    return name;
+}
+
+/* Replays a register log through all engines and sample rates and checks
+   the output against the CRCs in HASHFN, or stores them there. */
+static int pkreplaytest(const char *logfn, const char *hashfn)
+{
+    ULONG crcs[PK_ENGINES][REPLAY_NRATES];
+    int known[PK_ENGINES][REPLAY_NRATES];
+    pkwrite *writes;
+    unsigned long tail;
+    long n;
+    int nchips;
+    int r;
+    int failed = 0;
+    int missing = 0;
+    FILE *fh = NULL;
+
+    n = pkreadlog(logfn,&writes,&tail,&nchips);
+    if(n < 0)
+        return 2;
+    memset(known,0,sizeof(known));
+    if(hashfn != NULL && (fh = fopen(hashfn,"r")) != NULL)
+    {
+        char line[256];
+        while(fgetl(line,sizeof(line),fh) != NULL)
+        {
+            char name[64];
+            unsigned int rate;
+            unsigned long crc;
+            if(line[0] == '#' || line[0] == '\0')
+                continue;
+            if(sscanf(line,"%63s %u %lx",name,&rate,&crc) != 3)
+            {
+                printf("%s: Error in file format: %s\n", hashfn, line);
+                fclose(fh);
+                free(writes);
+                return 2;
+            }
+            for(engine=0; engine<PK_ENGINES; engine++)
+                for(r=0; r<REPLAY_NRATES; r++)
+                    if(strcmp(name,pkcasename(engine)) == 0 && rate == REPLAY_RATES[r])
+                    {
+                        crcs[engine][r] = (ULONG) crc;
+                        known[engine][r] = TRUE;
+                    }
+        }
+        fclose(fh);
+        fh = NULL;
+    }
+    else if(hashfn != NULL)
+    {
+        if(!(fh = fopen(hashfn,"w")))
+        {
+            perror(hashfn);
+            free(writes);
+            return 2;
+        }
+        fprintf(fh,"# engine and build options, sample rate, CRC-32 of %s\n",logfn);
+        printf("Creating %s\n",hashfn);
+    }
+
+    printf("%s: %ld writes, %d chip%s\n\n", logfn, n, nchips, nchips > 1 ? "s" : "");
+    printf("Engine and build options          Rate  Gen/play ratio       CRC-32\n");
+    for(engine=0; engine<PK_ENGINES; engine++)
+        for(r=0; r<REPLAY_NRATES; r++)
+        {
+            double rate;
+            ULONG crc = pkreplay(writes,n,tail,nchips,REPLAY_RATES[r],&rate);
+            printf("%-32s %5u  %14.1f     %08lx", pkcasename(engine), REPLAY_RATES[r],
+                   rate/REPLAY_RATES[r], (unsigned long) crc);
+            if(fh != NULL)
+            {
+                fprintf(fh,"%s %u %08lx\n", pkcasename(engine), REPLAY_RATES[r], (unsigned long) crc);
+                printf("\n");
+            }
+            else if(hashfn == NULL)
+                printf("\n");
+            else if(!known[engine][r])
+            {
+                printf("  no CRC stored\n");
+                missing++;
+            }
+            else if(crcs[engine][r] != crc)
+            {
+                printf("  FAILED, expected %08lx\n", (unsigned long) crcs[engine][r]);
+                failed++;
+            }
+            else
+                printf("  OK\n");
+            fflush(stdout);
+        }
+    free(writes);
+    if(fh != NULL && fclose(fh) != 0)
+    {
+        perror(hashfn);
+        return 2;
+    }
+    if(failed || missing)
+        printf("\n%d failed, %d without a stored CRC\n", failed, missing);
+    return failed || missing ? 1 : 0;
+}
+
 int main(int argc, char* argv[])
 {
     char paramfn[256];
@@ -281,6 +854,9 @@ int main(int argc, char* argv[])
 
     printf("PokeyBench (c) 2002 by Michael Borisov\n\n");
 
+    if(argc>=3 && strcmp(argv[1],"-replay") == 0)
+        return pkreplaytest(argv[2], argc>=4 ? argv[3] : NULL);
+
     /* Get command-line parameters */
     if(argc<2)
     {
@@ -330,6 +906,28 @@ int main(int argc, char* argv[])
         ofn16[255] = '\0';
     }
 
+    if(argc>=5)
+    {
+        for(i=0; i<PK_ENGINES; i++)
+            if(strcmp(argv[4],engine_names[i]) == 0)
+                engine = i;
+        if(strcmp(argv[4],engine_names[engine]) != 0)
+        {
+            printf("Unknown engine: %s\n", argv[4]);
+            return 1;
+        }
+    }
+
+    if(argc>=6)
+    {
+        chips = atoi(argv[5]);
+        if(chips != 1 && chips != 2 && chips != 4)
+        {
+            printf("Number of chips must be 1, 2 or 4\n");
+            return 1;
+        }
+    }
+
 
     /* Read parameter file */
     if(!(fs = fopen(paramfn,"r")))
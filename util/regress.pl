@@ -0,0 +1,215 @@
+#!/usr/bin/perl -w
+# Regression test runner for the Atari800 emulator
+# Replays event recordings (made with "-record") and compares the screen
+# checksums stored in them, running several emulator processes in parallel.
+use strict;
+use POSIX ':sys_wait_h';
+use File::Basename qw(dirname);
+use File::Spec;
+use Time::HiRes qw(time);
+
+# defaults
+my $emulator = '';
+my $config = '';
+my $jobs = 0;
+my $outdir = 'regress';
+my $manifest = '';
+my @extra_options = ();
+
+# find the number of processors, so all of them are kept busy by default
+sub count_cpus() {
+	my $n = 0;
+	if (open CPUINFO, '/proc/cpuinfo') {
+		while (<CPUINFO>) {
+			$n++ if /^processor\s*:/;
+		}
+		close CPUINFO;
+	}
+	return $n || 1;
+}
+
+# read the manifest: one test case per line, fields separated by whitespace:
+#   <name> <image> <recording> [<emulator options>...]
+# Relative paths are relative to the directory of the manifest.
+# Empty lines and lines starting with '#' are ignored.
+sub read_manifest($) {
+	my $filename = shift;
+	my $dir = dirname($filename);
+	my @cases = ();
+	open MANIFEST, $filename or die "$filename: $!\n";
+	while (<MANIFEST>) {
+		s/^\s+//;
+		s/\s+$//;
+		next if $_ eq '' || /^#/;
+		my ($name, $image, $recording, @options) = split;
+		defined $recording or die "$filename line $.: expected <name> <image> <recording>\n";
+		$image = File::Spec->rel2abs($image, $dir);
+		$recording = File::Spec->rel2abs($recording, $dir);
+		-r $image or die "$filename line $.: $image not found\n";
+		-r $recording or die "$filename line $.: $recording not found\n";
+		push @cases, {
+			'name' => $name,
+			'image' => $image,
+			'recording' => $recording,
+			'options' => \@options
+		};
+	}
+	close MANIFEST;
+	return @cases;
+}
+
+# start the emulator for a test case, with its output going to the log file
+sub start_case($) {
+	my $case = shift;
+	my @command = ($emulator);
+	push @command, '-config', $config if $config;
+	# full speed and no sound; the rest of the options come from the manifest
+	push @command, '-turbo', '-nosound', @extra_options, @{$case->{'options'}};
+	push @command, '-playback', $case->{'recording'}, $case->{'image'};
+	$case->{'log'} = "$outdir/$case->{'name'}.log";
+	$case->{'start'} = time;
+	my $pid = fork;
+	defined $pid or die "fork failed: $!\n";
+	if ($pid == 0) {
+		open STDOUT, '>', $case->{'log'} or die "$case->{'log'}: $!\n";
+		open STDERR, '>&STDOUT';
+		exec @command or die "Cannot run $emulator: $!\n";
+	}
+	return $pid;
+}
+
+# examine the log and the exit status of a finished test case
+sub finish_case($$) {
+	my ($case, $status) = @_;
+	$case->{'time'} = time - $case->{'start'};
+	$case->{'frames'} = 0;
+	$case->{'mismatches'} = 0;
+	$case->{'first'} = -1;
+	my $finished = 0;
+	if (open LOG, $case->{'log'}) {
+		while (<LOG>) {
+			if (/^Playback finished: (\d+) frames, (\d+) mismatches, first mismatch in frame (-?\d+)/) {
+				$case->{'frames'} = $1;
+				$case->{'mismatches'} = $2;
+				$case->{'first'} = $3;
+				$finished = 1;
+			}
+		}
+		close LOG;
+	}
+	if (!$finished) {
+		$case->{'result'} = $status & 127 ? 'CRASH' : 'ERROR';
+	}
+	elsif ($case->{'mismatches'} == 0 && $status == 0) {
+		$case->{'result'} = 'PASS';
+	}
+	else {
+		$case->{'result'} = 'FAIL';
+	}
+}
+
+for (@ARGV) {
+	if (/^--emulator=(.+)/) {
+		$emulator = $1;
+	}
+	elsif (/^--config=(.+)/) {
+		$config = $1;
+	}
+	elsif (/^--jobs=(\d+)$/) {
+		$jobs = $1;
+	}
+	elsif (/^--output=(.+)/) {
+		$outdir = $1;
+	}
+	elsif (/^-?-h(elp)?$/) {
+		$manifest = '';
+		last;
+	}
+	elsif (/^-/) {
+		push @extra_options, $_;
+	}
+	else {
+		$manifest = $_;
+	}
+}
+
+unless ($manifest) {
+	print <<EOF;
+regress.pl replays Atari800 event recordings and checks that the emulated
+screen matches the checksums stored in them. The emulator must be built
+with event recording support (--enable-eventrecording).
+
+Usage: regress.pl [options] <manifest>
+
+Each line of the manifest describes one test case:
+  <name> <image> <recording> [<emulator options>...]
+where <image> is the program or disk image the recording was made with
+and <recording> is the file written by "atari800 -record <recording> <image>"
+or "atari800 -record-movie <recording> <image>". Relative paths are
+relative to the directory of the manifest. util/regress/manifest holds
+the tests that come with Atari800.
+
+Available options:
+--emulator=<filename> Emulator to run (defaults to ./atari800 or ../src/atari800)
+--config=<filename>   Use the specified configuration file (ROM paths etc.)
+--jobs=<n>            Number of emulators running at once (defaults to
+                      the number of processors)
+--output=<directory>  Directory for the emulator logs (defaults to $outdir)
+Any other options starting with '-' are passed to the emulator.
+
+The emulators are run with -turbo and -nosound. With the SDL target,
+SDL_VIDEODRIVER and SDL_AUDIODRIVER are set to "dummy" unless already set,
+so no window is opened.
+EOF
+	exit;
+}
+
+unless ($emulator) {
+	for ('./atari800', '../src/atari800') {
+		if (-x $_) {
+			$emulator = $_;
+			last;
+		}
+	}
+	$emulator or die "Emulator not found, use --emulator=<filename>\n";
+}
+$jobs ||= count_cpus();
+$ENV{'SDL_VIDEODRIVER'} ||= 'dummy';
+$ENV{'SDL_AUDIODRIVER'} ||= 'dummy';
+
+my @cases = read_manifest($manifest);
+@cases or die "$manifest: no test cases\n";
+unless (-d $outdir) {
+	mkdir $outdir or die "Failed to create '$outdir' directory\n";
+}
+
+print "Running ", scalar(@cases), " test cases, $jobs at once\n";
+my $start_time = time;
+my %running = ();
+my $next = 0;
+while ($next < @cases || %running) {
+	while ($next < @cases && keys(%running) < $jobs) {
+		my $pid = start_case($cases[$next]);
+		$running{$pid} = $cases[$next++];
+	}
+	my $pid = waitpid(-1, 0);
+	last if $pid <= 0;
+	my $case = delete $running{$pid} or next;
+	finish_case($case, $?);
+	my $fps = $case->{'time'} > 0 ? $case->{'frames'} / $case->{'time'} : 0;
+	my $first = $case->{'first'} >= 0 ? "first mismatch in frame $case->{'first'}" : '';
+	printf "%-5s %-24s %7d frames %8.1f fps  %s\n",
+		$case->{'result'}, $case->{'name'}, $case->{'frames'}, $fps, $first;
+}
+
+my $total_time = time - $start_time;
+my ($passed, $frames) = (0, 0);
+for my $case (@cases) {
+	$passed++ if $case->{'result'} eq 'PASS';
+	$frames += $case->{'frames'};
+}
+printf "%d of %d test cases passed, %d frames in %.2f seconds (%.1f fps)\n",
+	$passed, scalar(@cases), $frames, $total_time,
+	$total_time > 0 ? $frames / $total_time : 0;
+print "Logs written to: $outdir\n";
+exit($passed == @cases ? 0 : 1);
@@ -0,0 +1,246 @@
+/*
+ * votraxbench.c - regression test and benchmark of the Votrax speech output
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Runs src/votrax.c and src/votraxsnd.c the way the sound code does -
+ * VOTRAXSND_Frame() once per frame and VOTRAXSND_Process() on a buffer of
+ * POKEY sound - with phonemes, block sizes and background sound from a
+ * fixed pseudo-random sequence, and prints the time and a CRC-32 of the
+ * mixed output of each case. The cases cover the XLD and the Voicebox
+ * (with its pitch taken from AUDF4), mono and stereo, 8 and 16-bit output
+ * at several sample rates.
+ * Build it with "make votraxbench" in the src directory after running
+ * configure.
+ *
+ * Usage: votraxbench [hashfile]
+ *
+ * With hashfile, the CRCs are compared with the ones stored in it and the
+ * exit status is 1 if any of them differs. If hashfile does not exist, it
+ * is created with the current CRCs. "make check-votrax" compares them with
+ * util/regress/votrax.crc.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "atari.h"
+#include "crc32.h"
+#include "pokey.h"
+#include "votraxsnd.h"
+#ifdef PBI_XLD
+#include "pbi_xld.h"
+#endif
+#ifdef VOICEBOX
+#include "voicebox.h"
+#endif
+
+/* Frames of each case; a frame is one call of VOTRAXSND_Process() */
+#define FRAMES 1500
+/* The most samples per channel that a frame has */
+#define MAX_FRAME 3000
+
+/* Stand-ins for the parts of the emulator that the speech code refers to */
+int Atari800_tv_mode = Atari800_TV_PAL;
+UBYTE POKEY_AUDF[4 * POKEY_MAXPOKEYS];
+
+void Atari800_ErrExit(void)
+{
+	exit(1);
+}
+
+#ifdef PBI_XLD
+int PBI_XLD_enabled = FALSE;
+int PBI_XLD_v_enabled = FALSE;
+void PBI_XLD_votrax_busy_callback(int busy_status)
+{
+}
+#endif
+#ifdef VOICEBOX
+int VOICEBOX_enabled = FALSE;
+int VOICEBOX_ii = FALSE;
+#endif
+
+typedef struct {
+	const char *name;
+	int voicebox;
+	int rate;
+	int channels;
+	int bit16;
+} test_case;
+
+static const test_case cases[] = {
+	{ "xld", FALSE, 44100, 1, TRUE },
+	{ "xld", FALSE, 44100, 2, TRUE },
+	{ "xld", FALSE, 48000, 2, TRUE },
+	{ "xld", FALSE, 22050, 1, FALSE },
+	{ "xld", FALSE, 31400, 2, FALSE },
+	{ "xld", FALSE, 8000, 1, TRUE },
+	{ "voicebox", TRUE, 44100, 2, TRUE },
+	{ "voicebox", TRUE, 22050, 1, FALSE }
+};
+#define N_CASES ((int) (sizeof(cases) / sizeof(cases[0])))
+
+static ULONG seed;
+
+static int Random(void)
+{
+	seed = (seed * 1103515245 + 12345) & 0xffffffff;
+	return (int) ((seed >> 16) & 0x7fff);
+}
+
+/* Runs test case T and returns the CRC-32 of its output. Stores the time
+   taken at *SECONDS. */
+static ULONG RunCase(const test_case *t, double *seconds)
+{
+	static SWORD buffer[2 * MAX_FRAME];
+	UBYTE bytes[4 * MAX_FRAME];
+	ULONG crc = 0xffffffff;
+	clock_t total = 0;
+	int f;
+
+	seed = 1;
+#ifdef PBI_XLD
+	PBI_XLD_v_enabled = !t->voicebox;
+#endif
+#ifdef VOICEBOX
+	VOICEBOX_enabled = VOICEBOX_ii = t->voicebox;
+#endif
+	POKEY_AUDF[3] = 0xa0;
+	VOTRAXSND_Init(t->rate, t->channels, t->bit16);
+	for (f = 0; f < FRAMES; f++) {
+		int n = (Random() % MAX_FRAME + 1) * t->channels;
+		int i;
+		clock_t start;
+		/* background sound from POKEY */
+		if (t->bit16)
+			for (i = 0; i < n; i++)
+				buffer[i] = (SWORD) (Random() * 2 - 32768 + (Random() & 1));
+		else
+			memset(buffer, Random() & 0xff, n);
+		if (Random() % 4 == 0)
+			VOTRAXSND_PutByte((UBYTE) Random());
+		if (t->voicebox && Random() % 16 == 0)
+			POKEY_AUDF[3] = (UBYTE) (0x90 + Random() % 32);
+		start = clock();
+		VOTRAXSND_Frame();
+		VOTRAXSND_Process(buffer, n);
+		total += clock() - start;
+		/* the CRC is of little-endian samples on all hosts */
+		if (t->bit16) {
+			for (i = 0; i < n; i++) {
+				bytes[2 * i] = (UBYTE) buffer[i];
+				bytes[2 * i + 1] = (UBYTE) (buffer[i] >> 8);
+			}
+			crc = CRC32_Update(crc, bytes, 2 * n);
+		}
+		else
+			crc = CRC32_Update(crc, (const UBYTE *) buffer, n);
+	}
+	*seconds = (double) total / CLOCKS_PER_SEC;
+	return crc ^ 0xffffffff;
+}
+
+/* Returns a name of test case I for the hashfile */
+static const char *CaseName(int i)
+{
+	static char name[64];
+	const test_case *t = &cases[i];
+	sprintf(name, "%s-%d-%s-%d", t->name, t->rate, t->channels == 2 ? "stereo" : "mono",
+	        t->bit16 ? 16 : 8);
+	return name;
+}
+
+int main(int argc, char *argv[])
+{
+	ULONG stored[N_CASES];
+	int known[N_CASES];
+	FILE *fp = NULL;
+	int failed = 0;
+	int i;
+
+	memset(known, 0, sizeof(known));
+	if (argc > 1 && (fp = fopen(argv[1], "r")) != NULL) {
+		char line[256];
+		while (fgets(line, sizeof(line), fp) != NULL) {
+			char name[64];
+			unsigned long crc;
+			if (line[0] == '#' || line[0] == '\n')
+				continue;
+			if (sscanf(line, "%63s %lx", name, &crc) != 2) {
+				printf("%s: Error in file format: %s", argv[1], line);
+				fclose(fp);
+				return 2;
+			}
+			for (i = 0; i < N_CASES; i++)
+				if (strcmp(name, CaseName(i)) == 0) {
+					stored[i] = (ULONG) crc;
+					known[i] = TRUE;
+				}
+		}
+		fclose(fp);
+		fp = NULL;
+	}
+	else if (argc > 1) {
+		fp = fopen(argv[1], "w");
+		if (fp == NULL) {
+			perror(argv[1]);
+			return 2;
+		}
+		fprintf(fp, "# test case, CRC-32 of the output of votraxbench\n");
+		printf("Creating %s\n", argv[1]);
+	}
+
+	printf("Test case                    Time      CRC-32\n");
+	for (i = 0; i < N_CASES; i++) {
+		double seconds;
+		ULONG crc = RunCase(&cases[i], &seconds);
+		printf("%-26s %6.3f s  %08lx", CaseName(i), seconds, (unsigned long) crc);
+		if (fp != NULL)
+			fprintf(fp, "%s %08lx\n", CaseName(i), (unsigned long) crc);
+		if (argc < 2 || fp != NULL)
+			printf("\n");
+		else if (!known[i]) {
+			printf("  no CRC stored\n");
+			failed++;
+		}
+		else if (stored[i] != crc) {
+			printf("  FAILED, expected %08lx\n", (unsigned long) stored[i]);
+			failed++;
+		}
+		else
+			printf("  OK\n");
+		fflush(stdout);
+	}
+	if (fp != NULL && fclose(fp) != 0) {
+		perror(argv[1]);
+		return 2;
+	}
+	if (failed) {
+		printf("\n%d failed\n", failed);
+		return 1;
+	}
+	return 0;
+}